@@ -0,0 +1,69 @@
+// Writes the catalog compiled from BuffsList.inc to a catalog file, which the addon loads instead of its built-in catalog when the file
+// is next to its DLL, see BuffCatalogFile.h. Icons are resolved against the atlas table the tool was built with, which must match the
+// atlas of the addon the file is shipped with.
+//
+// Usage: GW2ClarityCatalogTool [output path] [--memory]
+//
+// The written file is read back and checked to give exactly the same catalog, and nothing is left behind if it doesn't. --memory also
+// prints how much memory the catalog takes, compared to an estimate of the addon's former representation.
+
+#include <cstdio>
+#include <filesystem>
+
+#include "BuffCatalogFile.h"
+
+using namespace GW2Clarity;
+
+namespace
+{
+void PrintUsage(const char* program) {
+    std::printf("Usage: %s [output path] [--memory]\n\n"
+                "Writes the compiled buff catalog to the output path, '%s' by default.\n"
+                "  --memory  Also print how much memory the catalog takes\n",
+                program, BuffCatalogFileName);
+}
+
+void PrintFootprint(const char* name, const BuffCatalogFootprint& f) {
+    std::printf("%-22s %10zu %10zu %10zu %10zu %10zu\n", name, f.buffs, f.strings, f.extraIds, f.lookups, f.total());
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    std::filesystem::path path = BuffCatalogFileName;
+    bool memory = false;
+    for(int i = 1; i < argc; i++) {
+        const std::string_view arg = argv[i];
+        if(arg == "--memory") {
+            memory = true;
+        } else if(arg.starts_with('-')) {
+            // Including --help, which would otherwise be taken for an output path
+            PrintUsage(argv[0]);
+            return arg == "--help" || arg == "-h" ? 0 : 1;
+        } else {
+            path = argv[i];
+        }
+    }
+    const auto& compiled = CompiledBuffCatalog();
+
+    if(!WriteBuffCatalogFile(path, compiled))
+        return 1;
+
+    const auto file = BuffCatalogFile::Open(path);
+    if(!file || !SameBuffCatalog(compiled, file->catalog())) {
+        LogError("Catalog file '{}' does not match the compiled catalog.", path.string());
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+        return 1;
+    }
+
+    LogInfo("Wrote {} buffs to '{}'.", compiled.buffs().size(), path.string());
+
+    if(memory) {
+        std::printf("%-22s %10s %10s %10s %10s %10s\n", "Catalog bytes", "buffs", "strings", "extra IDs", "lookups", "total");
+        PrintFootprint("Former (estimated)", EstimateLegacyFootprint(compiled));
+        PrintFootprint("Current", MeasureFootprint(compiled));
+        std::printf("The compiled catalog is constant data. A catalog file is mapped, %ju bytes, and only its buffs are copied.\n",
+                    std::uintmax_t(std::filesystem::file_size(path)));
+    }
+    return 0;
+}
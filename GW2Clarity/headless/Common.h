@@ -0,0 +1,153 @@
+#pragma once
+
+// Portable stand-in for the GW2Common header, providing only what the core library needs so it can be built without Win32, D3D11 or
+// ImGui. The addon itself is always built against the real Common.h.
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <map>
+#include <memory>
+#include <numbers>
+#include <numeric>
+#include <optional>
+#include <set>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#if __has_include(<format>)
+#include <format>
+#endif
+#if !defined(__cpp_lib_format)
+#include <sstream>
+#endif
+
+#include <glm/glm.hpp>
+
+using i8 = std::int8_t;
+using i16 = std::int16_t;
+using i32 = std::int32_t;
+using i64 = std::int64_t;
+using u8 = std::uint8_t;
+using u16 = std::uint16_t;
+using u32 = std::uint32_t;
+using u64 = std::uint64_t;
+using f32 = float;
+using f64 = double;
+using mstime = u64;
+
+using glm::ivec2;
+using glm::ivec4;
+using glm::uvec2;
+using glm::vec2;
+using glm::vec3;
+using glm::vec4;
+
+// Documents converting constructors, as in the addon
+#define implicit
+
+#define GW2_ASSERT(expr) assert(expr)
+
+namespace GW2Clarity::Headless
+{
+#if !defined(__cpp_lib_format)
+template<typename T>
+void FormatArgument(std::ostringstream& out, const T& v) {
+    if constexpr(std::is_same_v<T, bool>)
+        out << (v ? "true" : "false");
+    else if constexpr(std::is_integral_v<T> && sizeof(T) == 1 && !std::is_same_v<T, char>)
+        out << i32(v);
+    else
+        out << v;
+}
+
+// Stand-in for std::vformat where <format> is missing: replaces each replacement field, in order, with its argument as streamed by
+// an ostream, ignoring any format specification
+template<typename... Args>
+std::string Format(std::string_view fmt, const Args&... args) {
+    std::ostringstream out;
+    auto argument = [&]([[maybe_unused]] size_t index) {
+        [[maybe_unused]] size_t i = 0;
+        ((i++ == index ? FormatArgument(out, args) : void()), ...);
+    };
+
+    size_t next = 0;
+    for(size_t i = 0; i < fmt.size(); i++) {
+        const char c = fmt[i];
+        if((c == '{' || c == '}') && i + 1 < fmt.size() && fmt[i + 1] == c) {
+            out << c;
+            i++;
+        }
+        else if(const size_t end = fmt.find('}', i); c == '{' && end != std::string_view::npos) {
+            argument(next++);
+            i = end;
+        }
+        else
+            out << c;
+    }
+    return out.str();
+}
+#endif
+
+template<typename... Args>
+void Log(const char* level, std::string_view fmt, Args&&... args) {
+#if defined(__cpp_lib_format)
+    std::fprintf(stderr, "[%s] %s\n", level, std::vformat(fmt, std::make_format_args(args...)).c_str());
+#else
+    std::fprintf(stderr, "[%s] %s\n", level, Format(fmt, args...).c_str());
+#endif
+}
+} // namespace GW2Clarity::Headless
+
+template<typename... Args>
+void LogDebug(std::string_view fmt, Args&&... args) {
+#ifdef _DEBUG
+    GW2Clarity::Headless::Log("debug", fmt, args...);
+#else
+    (void)fmt;
+    ((void)args, ...);
+#endif
+}
+
+template<typename... Args>
+void LogInfo(std::string_view fmt, Args&&... args) {
+    GW2Clarity::Headless::Log("info", fmt, args...);
+}
+
+template<typename... Args>
+void LogWarn(std::string_view fmt, Args&&... args) {
+    GW2Clarity::Headless::Log("warn", fmt, args...);
+}
+
+template<typename... Args>
+void LogError(std::string_view fmt, Args&&... args) {
+    GW2Clarity::Headless::Log("error", fmt, args...);
+}
+
+inline std::string ToLower(std::string s) {
+    for(char& c : s)
+        c = char(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+inline std::string ReplaceChars(std::string s, std::initializer_list<std::pair<char, char>> replacements) {
+    for(char& c : s)
+        for(const auto& [from, to] : replacements)
+            if(c == from)
+                c = to;
+    return s;
+}
@@ -0,0 +1,17 @@
+#pragma once
+
+#ifdef GW2CLARITY_ALLOCATION_TRACKING
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Heap allocations made through operator new by the calling thread since it started. Counted by replacing the global operator new of the
+// addon's module, so allocations made by other modules, including ImGui's own allocator, are not seen. Define
+// GW2CLARITY_ALLOCATION_TRACKING to enable it; it is off in Release so that shipped builds keep the default allocator.
+[[nodiscard]] u64 ThreadAllocationCount();
+
+} // namespace GW2Clarity
+
+#endif
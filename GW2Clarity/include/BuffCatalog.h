@@ -0,0 +1,142 @@
+#pragma once
+
+#include <stdexcept>
+
+#include "BuffTable.h"
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Position of an icon in the buffs atlas. Kept as plain floats rather than a vec2 so that the catalog stays a literal type whatever glm
+// configuration it is built with.
+struct AtlasUV
+{
+    f32 u = 0.f, v = 0.f;
+
+    [[nodiscard]] vec2 vec() const { return { u, v }; }
+};
+
+// IDs beyond a buff's primary one whose stacks count towards it
+class BuffExtraIds
+{
+public:
+    static inline constexpr size_t Capacity = 10;
+
+    constexpr BuffExtraIds() = default;
+    constexpr BuffExtraIds(std::span<const u32> ids) {
+        if(ids.size() > Capacity)
+            throw std::length_error("Too many extra IDs for one buff, raise BuffExtraIds::Capacity");
+        std::ranges::copy(ids, ids_.begin());
+        count_ = u8(ids.size());
+    }
+
+    [[nodiscard]] constexpr const u32* begin() const { return ids_.data(); }
+    [[nodiscard]] constexpr const u32* end() const { return ids_.data() + count_; }
+    [[nodiscard]] constexpr size_t size() const { return count_; }
+    [[nodiscard]] constexpr bool empty() const { return count_ == 0; }
+
+protected:
+    std::array<u32, Capacity> ids_ {};
+    u8 count_ = 0;
+};
+
+// Laid out to keep padding to a minimum. Strings view an interned pool, the literals of BuffsList.inc or a catalog file's string pool, so
+// that every buff of a category shares the category's name.
+struct Buff
+{
+    static inline constexpr u32 CategoryId = 0xFFFFFFFF;
+
+    std::string_view name;
+    std::string_view category;
+    u32 id;
+    i32 maxStacks;
+    AtlasUV uv {};
+    u32 slot = BuffSlotMap::InvalidSlot;
+    // Index into Buffs::atlasUVs(), zero being reserved for buffs without an icon
+    u16 atlasSlot = 0;
+    BuffExtraIds extraIds;
+
+    // Character of the atlas entry a buff name maps to, lower case with spaces and quotes replaced by underscores
+    static constexpr char AtlasEntryChar(char c) {
+        if(c >= 'A' && c <= 'Z')
+            return char(c - 'A' + 'a');
+        return c == ' ' || c == '\"' ? '_' : c;
+    }
+
+    // Category header
+    constexpr implicit Buff(std::string_view name) : Buff(CategoryId, name) { }
+
+    constexpr Buff(u32 id, std::string_view name, i32 maxStacks = std::numeric_limits<i32>::max())
+        : name(name), id(id), maxStacks(maxStacks) { }
+
+    constexpr Buff(std::initializer_list<u32> ids, std::string_view name, i32 maxStacks = std::numeric_limits<i32>::max())
+        : name(name), id(*ids.begin()), maxStacks(maxStacks), extraIds({ ids.begin() + 1, ids.end() }) { }
+
+    [[nodiscard]] constexpr bool isCategory() const { return id == CategoryId; }
+
+    [[nodiscard]] i32 GetStacks(const ActiveBuffsTable& activeBuffs) const {
+        return std::accumulate(extraIds.begin(), extraIds.end(), activeBuffs.slot(slot), [&](i32 a, u32 b) { return a + activeBuffs[b]; });
+    }
+
+    [[nodiscard]] bool ShowNumber(i32 count) const { return maxStacks > 1 && count > 1; }
+};
+
+inline constexpr Buff UnknownBuff { 0, "Unknown", 1 };
+
+// Entry of the table mapping primary buff IDs to catalog indices, sorted by ID
+struct BuffIdIndex
+{
+    u32 id;
+    u32 index;
+};
+
+// Every known buff, with category headers interleaved, and the tables looking them up by ID. Only views its data.
+class BuffCatalog
+{
+public:
+    constexpr BuffCatalog(std::span<const Buff> buffs, std::span<const BuffIdIndex> byId, BuffSlotMap slots, AtlasUV atlasUVSize)
+        : buffs_(buffs), byId_(byId), slots_(slots), atlasUVSize_(atlasUVSize) { }
+
+    [[nodiscard]] constexpr std::span<const Buff> buffs() const { return buffs_; }
+    // Every primary and extra ID mapped to the slot its stacks are tracked in
+    [[nodiscard]] constexpr const BuffSlotMap& slots() const { return slots_; }
+    [[nodiscard]] vec2 atlasUVSize() const { return atlasUVSize_.vec(); }
+    [[nodiscard]] constexpr std::span<const BuffIdIndex> byId() const { return byId_; }
+
+    // Buff whose primary ID is id, or null
+    [[nodiscard]] constexpr const Buff* find(u32 id) const {
+        const auto it = std::ranges::lower_bound(byId_, id, {}, &BuffIdIndex::id);
+        return it != byId_.end() && it->id == id ? &buffs_[it->index] : nullptr;
+    }
+
+protected:
+    std::span<const Buff> buffs_;
+    std::span<const BuffIdIndex> byId_;
+    BuffSlotMap slots_;
+    AtlasUV atlasUVSize_;
+};
+
+// Bytes held by a catalog, by what holds them. Strings are counted once however many buffs view them, with their null character.
+struct BuffCatalogFootprint
+{
+    size_t buffs = 0;
+    size_t strings = 0;
+    // Only counted separately when held outside of the buffs
+    size_t extraIds = 0;
+    size_t lookups = 0;
+
+    [[nodiscard]] size_t total() const { return buffs + strings + extraIds + lookups; }
+};
+
+[[nodiscard]] BuffCatalogFootprint MeasureFootprint(const BuffCatalog& catalog);
+// Estimated footprint of the same buffs held the way the addon used to: a vector of buffs with their name, atlas entry and category in
+// std::strings and their extra IDs in a std::set, looked up through an unordered_map. Heap blocks are assumed to be rounded to 16 bytes
+// with 16 bytes of allocator overhead, and atlas entries as long as names.
+[[nodiscard]] BuffCatalogFootprint EstimateLegacyFootprint(const BuffCatalog& catalog);
+
+// The catalog compiled from BuffsList.inc, with atlas UVs resolved from the atlas table. Constant-initialized, so using it costs nothing
+// at load time and it owns no heap memory.
+[[nodiscard]] const BuffCatalog& CompiledBuffCatalog();
+
+} // namespace GW2Clarity
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <filesystem>
+
+#include "BuffCatalog.h"
+#include "Main.h"
+#include "MappedFile.h"
+
+namespace GW2Clarity
+{
+
+// Catalog files hold a whole BuffCatalog, so that buffs added by a game patch can be shipped without rebuilding the addon. They are
+// used straight from a memory mapping: the ID and slot tables are viewed in place, and only the Buff array, whose strings point into
+// the mapping, is materialized once when the file is opened.
+//
+// The file is a Header followed by the arrays it points to. Every string of the pool is followed by a null character so that names can
+// be handed to ImGui as they are.
+namespace BuffCatalogFormat
+{
+inline constexpr std::array<char, 4> Magic { 'G', 'C', 'B', 'C' };
+// Bump whenever the layout of the file changes
+inline constexpr u32 Version = 2;
+
+// Byte offset from the start of the file and number of elements
+struct Range
+{
+    u32 offset, count;
+};
+
+// Range of the string pool, excluding the terminating null character
+struct String
+{
+    u32 offset, size;
+};
+
+struct Header
+{
+    std::array<char, 4> magic;
+    u32 version;
+    f32 atlasUVSize[2];
+    // byId holds BuffIdIndex and slotEntries BuffSlotMap::Entry values, as laid out in memory
+    Range strings, buffs, extraIds, byId, slotIds, slotDisplacements, slotEntries;
+};
+
+struct Buff
+{
+    u32 id;
+    i32 maxStacks;
+    String name, category;
+    f32 uv[2];
+    // Range of extraIds
+    u32 firstExtraId, extraIdCount;
+    u32 slot;
+    u16 atlasSlot, padding;
+};
+} // namespace BuffCatalogFormat
+
+// Where Buffs looks for a catalog file, next to the addon's DLL
+inline constexpr const char* BuffCatalogFileName = "buffs.catalog";
+
+// Writes the catalog atomically. Returns false and logs why if the file could not be written.
+bool WriteBuffCatalogFile(const std::filesystem::path& path, const BuffCatalog& catalog);
+
+// Whether both catalogs hold the same buffs, in the same order, with the same slots and icons. Logs the first difference found.
+[[nodiscard]] bool SameBuffCatalog(const BuffCatalog& a, const BuffCatalog& b);
+
+class BuffCatalogFile
+{
+public:
+    // Returns nothing if there is no file, or if it is damaged or from another version
+    [[nodiscard]] static std::optional<BuffCatalogFile> Open(const std::filesystem::path& path);
+
+    // Valid as long as the file is, including after it is moved
+    [[nodiscard]] const BuffCatalog& catalog() const { return catalog_; }
+
+protected:
+    BuffCatalogFile(MappedFile file, std::vector<Buff> buffs, const BuffCatalogFormat::Header& h);
+
+    [[nodiscard]] static bool Validate(std::span<const std::byte> data);
+
+    MappedFile file_;
+    std::vector<Buff> buffs_;
+    BuffCatalog catalog_;
+};
+
+} // namespace GW2Clarity
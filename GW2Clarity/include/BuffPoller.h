@@ -0,0 +1,46 @@
+#pragma once
+
+#include <atomic>
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Avoids redundant work around getbuffs polls: results identical to the previous one are detected by hash so they can be ignored,
+// and polling backs off exponentially while getbuffs keeps returning the same error, such as -2 for the whole of a competitive match.
+class BuffPoller
+{
+public:
+    struct Stats
+    {
+        std::atomic<u64> updates { 0 };
+        // Updates on which getbuffs wasn't called because of the back-off
+        std::atomic<u64> backedOff { 0 };
+        // Polls whose result was identical to the previous one
+        std::atomic<u64> unchanged { 0 };
+    };
+
+    // Whether getbuffs should be called on this update
+    [[nodiscard]] bool ShouldPoll();
+
+    // Returns false if the null-terminated result is identical to the previous one, in which case nothing derived from it needs updating
+    bool Changed(const StackedBuff* buffs);
+
+    // Read from any thread
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+
+    [[nodiscard]] static u64 Hash(const StackedBuff* buffs);
+
+    // Updates skipped after the same error comes back, doubling each time
+    static inline constexpr u32 MaxBackOff = 64;
+
+protected:
+    std::optional<u64> lastHash_;
+    i32 lastError_ = 0;
+    u32 backOff_ = 0;
+    u32 skipLeft_ = 0;
+    Stats stats_;
+};
+
+} // namespace GW2Clarity
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Result set of a BuffSearchIndex query, kept between queries so a growing query only narrows the previous results
+struct BuffSearchResults
+{
+    std::string query;
+    std::vector<u32> indices;
+    bool valid = false;
+};
+
+// Case-insensitive substring search over buff names and categories, built once from the catalog.
+// Queries of three characters or more only verify the entries listed under their rarest trigram.
+class BuffSearchIndex
+{
+public:
+    // Adds the next entry, whose index is the number of entries added before it. Only valid before Build() is called.
+    void Add(std::string_view name, std::string_view category);
+    void Build();
+
+    // Fills results with the indices of matching entries in ascending order. An empty query matches everything.
+    void Search(std::string_view query, BuffSearchResults& results) const;
+
+    [[nodiscard]] size_t size() const { return offsets_.empty() ? 0 : offsets_.size() - 1; }
+
+protected:
+    // Separates name and category in the haystack so no match spans both
+    static inline constexpr char Separator = '\x1F';
+
+    static u32 Trigram(const char* c) {
+        const auto* b = reinterpret_cast<const unsigned char*>(c);
+        return u32(b[0]) | u32(b[1]) << 8 | u32(b[2]) << 16;
+    }
+
+    [[nodiscard]] std::string_view haystack(u32 index) const {
+        return std::string_view { haystacks_ }.substr(offsets_[index], offsets_[index + 1] - offsets_[index]);
+    }
+    [[nodiscard]] bool Matches(u32 index, std::string_view lowerQuery) const {
+        return haystack(index).find(lowerQuery) != std::string_view::npos;
+    }
+
+    // Lowercase "name<Separator>category" of every entry, back to back
+    std::string haystacks_;
+    std::vector<u32> offsets_ { 0 };
+
+    // Sorted trigrams, each owning postings_[first, next trigram's first)
+    struct TrigramEntry
+    {
+        u32 trigram;
+        u32 first;
+    };
+    std::vector<TrigramEntry> trigrams_;
+    std::vector<u32> postings_;
+};
+
+} // namespace GW2Clarity
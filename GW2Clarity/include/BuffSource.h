@@ -0,0 +1,100 @@
+#pragma once
+
+#include <filesystem>
+#include <random>
+
+#include <nlohmann/json.hpp>
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+#ifdef _WIN32
+using GetBuffsCallback = StackedBuff*(__cdecl*)();
+#else
+using GetBuffsCallback = StackedBuff* (*)();
+#endif
+
+// Name of the function every getbuffs library exports
+inline constexpr const char* GetBuffsExportName = "GetCurrentPlayerStackedBuffs";
+
+// Provides the player's current buffs
+class BuffSource
+{
+public:
+    virtual ~BuffSource() = default;
+
+    // Returns the active buffs terminated by an entry with ID 0, valid until the next call. If the first entry has ID 0, its count is
+    // zero or one of getbuffs' error codes.
+    [[nodiscard]] virtual StackedBuff* GetBuffs() = 0;
+};
+
+// Calls into a getbuffs library: getbuffs.dll in the game, or any stand-in exporting the same function
+class LibraryBuffSource : public BuffSource
+{
+public:
+    // Returns null and logs why if the library or its export could not be found
+    [[nodiscard]] static std::unique_ptr<LibraryBuffSource> Load(const std::filesystem::path& path);
+
+    LibraryBuffSource(const LibraryBuffSource&) = delete;
+    LibraryBuffSource& operator=(const LibraryBuffSource&) = delete;
+    ~LibraryBuffSource() override;
+
+    [[nodiscard]] StackedBuff* GetBuffs() override { return getBuffs_(); }
+
+protected:
+    LibraryBuffSource(void* module, GetBuffsCallback getBuffs) : module_(module), getBuffs_(getBuffs) { }
+
+    void* module_;
+    GetBuffsCallback getBuffs_;
+};
+
+// Generates buffs from a scripted scenario, to exercise the addon without the game. A scenario is a JSON object:
+//  - "seed": random seed, so runs are reproducible;
+//  - "loop": whether to start over after the last phase rather than staying in it;
+//  - "phases": array of phases lasting "frames" calls each. A phase either returns the getbuffs error code "error", or keeps
+//    "active" buffs up. Every call, each buff ends with probability "churn" and is replaced by another, and changes its stack count
+//    to between 1 and "max_stacks" with probability "stack_change". A fraction "unknown" of the buffs have IDs outside the catalog.
+//    Each call busy-waits for "latency_us" microseconds to simulate getbuffs' own cost.
+class ScriptedBuffSource : public BuffSource
+{
+public:
+    struct Phase
+    {
+        u32 frames = 1;
+        i32 error = 0;
+        u32 active = 0;
+        f32 churn = 0.f;
+        f32 stackChange = 0.f;
+        i32 maxStacks = 25;
+        f32 unknown = 0.f;
+        u32 latencyUs = 0;
+    };
+
+    // Active buffs are drawn from knownIds, or from the unknown range if it is empty
+    ScriptedBuffSource(const nlohmann::json& scenario, std::vector<u32> knownIds);
+
+    [[nodiscard]] StackedBuff* GetBuffs() override;
+
+    [[nodiscard]] const auto& phases() const { return phases_; }
+
+protected:
+    [[nodiscard]] StackedBuff NewBuff(const Phase& p);
+
+    std::vector<Phase> phases_;
+    std::vector<u32> knownIds_;
+    bool loop_ = true;
+    std::mt19937 rng_;
+
+    size_t phase_ = 0;
+    u32 phaseFrame_ = 0;
+    u32 nextUnknownId_ = UnknownIdBase;
+    std::vector<StackedBuff> active_;
+    std::vector<StackedBuff> result_;
+
+    // Far above any real buff ID
+    static inline constexpr u32 UnknownIdBase = 0x70000000;
+};
+
+} // namespace GW2Clarity
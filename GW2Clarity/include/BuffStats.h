@@ -0,0 +1,135 @@
+#pragma once
+
+#include <iosfwd>
+
+#include "BuffCatalog.h"
+#include "BuffTable.h"
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+enum class BuffStatsWindow : u8
+{
+    // The current fight while in combat, the previous one otherwise
+    Fight,
+    // The last RecentDuration, give or take the bucket being filled
+    Recent,
+    // Since the statistics were created or last reset
+    Session,
+};
+
+inline constexpr std::array<const char*, 3> BuffStatsWindowNames { "Last fight", "Last 5 minutes", "Session" };
+
+// Statistics of one buff slot over a window
+struct BuffSlotStats
+{
+    u32 slot;
+    // Fraction of the window the buff was active
+    f32 uptime;
+    // Time-weighted average of the stacks while the buff was active
+    f32 averageStacks;
+    // Integral of the stacks over the window
+    f64 stackSeconds;
+    // Longest stretch of the window without the buff, counting from the start of the window if it was never active before
+    f32 longestGapSeconds;
+};
+
+struct BuffStatsSnapshot
+{
+    BuffStatsWindow window = BuffStatsWindow::Session;
+    mstime duration = 0;
+    // Slots active at some point of the window, in slot order
+    std::vector<BuffSlotStats> slots;
+};
+
+// Streaming uptime and stack statistics for every catalog slot, fed the changes of every published buffs table. An update only touches
+// the slots which changed: time spent in the current state is folded in lazily, when a slot changes, when a recent bucket ends or when a
+// fight starts or ends.
+//
+// Memory is fixed at construction. The recent window is a ring of BucketCount buckets, each quantity stored as one array per bucket
+// indexed by slot, so that folding a bucket and summing a slot over the window both walk contiguous memory. Not thread-safe.
+class BuffStats
+{
+public:
+    static inline constexpr mstime BucketDuration = 10'000;
+    static inline constexpr size_t BucketCount = 30;
+    static inline constexpr mstime RecentDuration = BucketDuration * BucketCount;
+
+    BuffStats(size_t slotCount, mstime now);
+
+    void Update(mstime now, std::span<const BuffCountChange> changes);
+    // Fights start and end with combat. Cheap when the state is unchanged, call it as often as buffs are polled.
+    void UpdateCombat(mstime now, bool inCombat);
+    // Forgets everything but the current stacks
+    void Reset(mstime now);
+
+    // Folds time up to now before computing the window, hence not const
+    void Snapshot(mstime now, BuffStatsWindow window, BuffStatsSnapshot& out);
+
+    [[nodiscard]] bool inFight() const { return inFight_; }
+    [[nodiscard]] size_t slotCount() const { return counts_.size(); }
+
+protected:
+    struct Totals
+    {
+        std::vector<u64> activeMs;
+        std::vector<u64> stackMs;
+        std::vector<mstime> longestGap;
+
+        void Reset(size_t slotCount);
+    };
+
+    // Clamps to the latest time seen, as callers on different threads may read the clock out of order
+    mstime Now(mstime now) {
+        lastNow_ = std::max(lastNow_, now);
+        return lastNow_;
+    }
+    // Starts buckets until the current one contains now
+    void Advance(mstime now);
+    // Adds the time slot s spent in its current state up to the given time
+    void Fold(u32 s, mstime until);
+    void FoldAll(mstime until);
+    void EndGap(u32 s, mstime now);
+
+    [[nodiscard]] size_t bucketOffset(size_t bucket) const { return bucket * counts_.size(); }
+    [[nodiscard]] mstime bucketStart(size_t bucket) const {
+        return bucketStart_ - mstime((bucket_ + BucketCount - bucket) % BucketCount) * BucketDuration;
+    }
+
+    std::vector<i32> counts_;
+    // When each slot last had its time folded in, and when each inactive slot lost its buff
+    std::vector<mstime> since_;
+    std::vector<mstime> inactiveSince_;
+
+    // BucketCount arrays of one entry per slot each
+    std::vector<u32> bucketActiveMs_;
+    std::vector<u32> bucketStackMs_;
+    // Longest gap ending in the bucket, unclipped, and when it ended in milliseconds from the start of the bucket, so that it can be
+    // clipped to the start of the window
+    std::vector<u32> bucketLongestGap_;
+    std::vector<u16> bucketLongestGapEnd_;
+    // Longest gap ending in the bucket, clipped to the start of the bucket, for when it is the first bucket of the window. Only the first
+    // gap ending in a bucket can start before it, so the longest gap isn't necessarily the longest once clipped.
+    std::vector<u16> bucketLongestGapInBucket_;
+    size_t bucket_ = 0;
+    mstime bucketStart_ = 0;
+
+    Totals session_;
+    Totals fight_;
+    mstime sessionStart_ = 0;
+    mstime fightStart_ = 0;
+    mstime fightEnd_ = 0;
+    bool inFight_ = false;
+    bool hadFight_ = false;
+
+    mstime lastNow_ = 0;
+};
+
+// Catalog buff each slot belongs to, an extra ID belonging to the first buff listing it. Null for slots no buff lists.
+[[nodiscard]] std::vector<const Buff*> BuffSlotOwners(const BuffCatalog& catalog);
+
+// Writes one line per slot and window, with a header line
+void WriteBuffStatsCsv(std::ostream& out, std::span<const BuffStatsSnapshot> snapshots, const BuffCatalog& catalog);
+
+} // namespace GW2Clarity
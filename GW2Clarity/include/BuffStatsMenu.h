@@ -0,0 +1,35 @@
+#pragma once
+
+#include "BuffStats.h"
+#include "Buffs.h"
+#include "Main.h"
+#include "SettingsMenu.h"
+
+namespace GW2Clarity
+{
+
+// Settings tab showing buff uptimes and stacks over the last fight, the last few minutes or the whole session, with a CSV export
+class BuffStatsMenu : public SettingsMenu::Implementer
+{
+public:
+    explicit BuffStatsMenu(Buffs* buffs);
+    ~BuffStatsMenu();
+
+    void DrawMenu(Keybind** currentEditedKeybind) override;
+
+    [[nodiscard]] const char* GetTabName() const override { return "Statistics"; }
+
+protected:
+    void Export();
+
+    Buffs* buffs_;
+    const std::vector<const Buff*> owners_;
+    BuffStatsWindow window_ = BuffStatsWindow::Fight;
+    BuffStatsSnapshot snapshot_;
+    mstime lastRefreshTime_ = 0;
+    std::string lastExportPath_;
+
+    static inline constexpr mstime RefreshDelay = 500;
+};
+
+} // namespace GW2Clarity
@@ -0,0 +1,234 @@
+#pragma once
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Perfect hash from catalog buff IDs to dense slot indices, the slot of an ID being its index in ids().
+// Lookups are two hashes and a single compare; IDs not in the catalog yield InvalidSlot. The map only views its tables, which
+// BuildSlotHash computes, at compile time for the compiled catalog.
+class BuffSlotMap
+{
+public:
+    static inline constexpr u32 InvalidSlot = std::numeric_limits<u32>::max();
+
+    struct Entry
+    {
+        u32 id = 0;
+        u32 slot = InvalidSlot;
+    };
+
+    constexpr BuffSlotMap() = default;
+    // Both tables must have a power of two size
+    constexpr BuffSlotMap(std::span<const u32> ids, std::span<const u32> displacements, std::span<const Entry> entries)
+        : ids_(ids), displacements_(displacements), entries_(entries), bucketMask_(u32(displacements.size() - 1)),
+          tableMask_(u32(entries.size() - 1)) { }
+
+    [[nodiscard]] constexpr u32 operator[](u32 id) const {
+        if(entries_.empty())
+            return InvalidSlot;
+
+        const u32 d = displacements_[Hash(id, 0) & bucketMask_];
+        const auto& e = entries_[Hash(id, d) & tableMask_];
+        return e.id == id ? e.slot : InvalidSlot;
+    }
+
+    [[nodiscard]] constexpr size_t size() const { return ids_.size(); }
+    [[nodiscard]] constexpr u32 id(u32 slot) const { return ids_[slot]; }
+    [[nodiscard]] constexpr auto ids() const { return ids_; }
+    [[nodiscard]] constexpr auto displacements() const { return displacements_; }
+    [[nodiscard]] constexpr auto entries() const { return entries_; }
+
+    static constexpr u32 Hash(u32 x, u32 seed) {
+        x ^= seed;
+        x ^= x >> 16;
+        x *= 0x85ebca6bu;
+        x ^= x >> 13;
+        x *= 0xc2b2ae35u;
+        x ^= x >> 16;
+        return x;
+    }
+
+protected:
+    std::span<const u32> ids_;
+    std::span<const u32> displacements_;
+    std::span<const Entry> entries_;
+    u32 bucketMask_ = 0;
+    u32 tableMask_ = 0;
+};
+
+// Tables of a BuffSlotMap over distinct, non-zero IDs
+struct BuffSlotHash
+{
+    std::vector<u32> displacements;
+    std::vector<BuffSlotMap::Entry> entries;
+};
+
+// Places every ID in a table of tableSize entries through bucketCount displacements, or returns false if some bucket can't be placed
+constexpr bool TryBuildSlotHash(std::span<const u32> ids, u32 bucketCount, u32 tableSize, BuffSlotHash& hash) {
+    hash.displacements.assign(bucketCount, 0);
+    hash.entries.assign(tableSize, BuffSlotMap::Entry {});
+
+    std::vector<std::vector<u32>> buckets(bucketCount);
+    for(u32 slot = 0; slot < ids.size(); slot++)
+        buckets[BuffSlotMap::Hash(ids[slot], 0) & (bucketCount - 1)].push_back(slot);
+
+    std::vector<u32> order(bucketCount);
+    std::iota(order.begin(), order.end(), 0);
+    // Largest buckets first, ties broken by index so that the same IDs always give the same tables
+    std::ranges::sort(order, [&](u32 a, u32 b) {
+        return buckets[a].size() != buckets[b].size() ? buckets[a].size() > buckets[b].size() : a < b;
+    });
+
+    std::vector<u32> placed;
+    for(u32 b : order) {
+        const auto& bucket = buckets[b];
+        if(bucket.empty())
+            break;
+
+        constexpr u32 MaxAttempts = 1 << 16;
+        u32 d = 1;
+        for(; d < MaxAttempts; d++) {
+            placed.clear();
+            bool ok = true;
+            for(u32 slot : bucket) {
+                u32 e = BuffSlotMap::Hash(ids[slot], d) & (tableSize - 1);
+                if(hash.entries[e].slot != BuffSlotMap::InvalidSlot || std::ranges::find(placed, e) != placed.end()) {
+                    ok = false;
+                    break;
+                }
+                placed.push_back(e);
+            }
+
+            if(ok)
+                break;
+        }
+
+        if(d == MaxAttempts)
+            return false;
+
+        hash.displacements[b] = d;
+        for(size_t i = 0; i < bucket.size(); i++)
+            hash.entries[placed[i]] = { ids[bucket[i]], bucket[i] };
+    }
+
+    return true;
+}
+
+[[nodiscard]] constexpr BuffSlotHash BuildSlotHash(std::span<const u32> ids) {
+    // Roughly four keys per bucket and a load factor of at most one half keeps displacement searches short
+    const u32 bucketCount = std::bit_ceil(std::max(1u, u32(ids.size() / 4)));
+    u32 tableSize = std::bit_ceil(std::max(2u, u32(ids.size() * 2)));
+
+    BuffSlotHash hash;
+    while(!TryBuildSlotHash(ids, bucketCount, tableSize, hash))
+        tableSize *= 2;
+    return hash;
+}
+
+// A slot whose stack count differs between two consecutive tables. A zero previous count means the buff was added, a zero current
+// count that it was removed.
+struct BuffCountChange
+{
+    u32 id;
+    u32 slot;
+    i32 previous;
+    i32 current;
+
+    [[nodiscard]] bool added() const { return previous == 0; }
+    [[nodiscard]] bool removed() const { return current == 0; }
+};
+
+// Live stack counts for every catalog slot, plus a small fixed-size side table for IDs the catalog doesn't know about.
+// Neither clearing nor updating the table allocates.
+class ActiveBuffsTable
+{
+public:
+    static inline constexpr size_t OverflowCapacity = 128;
+
+    ActiveBuffsTable() = default;
+    explicit ActiveBuffsTable(const BuffSlotMap* slots) : slots_(slots), counts_(slots->size(), 0), changes_(slots->size()) { }
+
+    void Clear() {
+        if(!counts_.empty())
+            memset(counts_.data(), 0, counts_.size() * sizeof(i32));
+        overflowCount_ = 0;
+    }
+
+    // Replaces the contents with a null-terminated getbuffs result. Returns the ID of the first buff dropped because the overflow table
+    // was full, or zero.
+    u32 Assign(const StackedBuff* buffs) {
+        Clear();
+
+        u32 dropped = 0;
+        for(size_t i = 0; buffs[i].id; i++)
+            if(!Set(buffs[i].id, buffs[i].count) && dropped == 0)
+                dropped = buffs[i].id;
+        return dropped;
+    }
+
+    // Returns false if the ID is unknown and the overflow table is full.
+    bool Set(u32 id, i32 count) {
+        if(u32 slot = (*slots_)[id]; slot != BuffSlotMap::InvalidSlot) {
+            counts_[slot] = count;
+            return true;
+        }
+
+        for(size_t i = 0; i < overflowCount_; i++)
+            if(overflow_[i].id == id) {
+                overflow_[i].count = count;
+                return true;
+            }
+
+        if(overflowCount_ >= overflow_.size())
+            return false;
+
+        overflow_[overflowCount_++] = { id, count };
+        return true;
+    }
+
+    [[nodiscard]] i32 slot(u32 slot) const { return slot < counts_.size() ? counts_[slot] : 0; }
+
+    [[nodiscard]] i32 operator[](u32 id) const {
+        if(slots_)
+            if(u32 s = (*slots_)[id]; s != BuffSlotMap::InvalidSlot)
+                return counts_[s];
+
+        for(size_t i = 0; i < overflowCount_; i++)
+            if(overflow_[i].id == id)
+                return overflow_[i].count;
+
+        return 0;
+    }
+
+    // Records every slot whose count differs from previous, the counts of the table this one follows. Unknown IDs aren't tracked: no
+    // item can depend on a buff the catalog doesn't know.
+    void Diff(std::span<const i32> previous) {
+        changeCount_ = 0;
+        for(u32 s = 0; s < counts_.size(); s++)
+            if(counts_[s] != previous[s])
+                changes_[changeCount_++] = { slots_->id(s), s, previous[s], counts_[s] };
+    }
+
+    [[nodiscard]] auto counts() const { return std::span { counts_ }; }
+    // Changes since the table of the previous generation, as recorded by Diff
+    [[nodiscard]] auto changes() const { return std::span { changes_.data(), changeCount_ }; }
+    [[nodiscard]] auto overflow() const { return std::span { overflow_.data(), overflowCount_ }; }
+    [[nodiscard]] const BuffSlotMap* slotMap() const { return slots_; }
+
+    [[nodiscard]] u64 generation() const { return generation_; }
+    void generation(u64 g) { generation_ = g; }
+
+protected:
+    const BuffSlotMap* slots_ = nullptr;
+    u64 generation_ = 0;
+    std::vector<i32> counts_;
+    std::array<StackedBuff, OverflowCapacity> overflow_ {};
+    size_t overflowCount_ = 0;
+    // Sized for every slot changing at once
+    std::vector<BuffCountChange> changes_;
+    size_t changeCount_ = 0;
+};
+
+} // namespace GW2Clarity
@@ -0,0 +1,95 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Buff trace files record successive getbuffs results so they can be replayed without the game.
+//
+// The file starts with the magic and a u32 version, followed by independently compressed blocks of up to FramesPerBlock frames. Each
+// block is a header of three u32s (frame count, raw size, compressed size) and the deflated frames. Within a block, every frame is
+// encoded against the previous one, the first against an empty frame, as varints:
+//  - microseconds since the previous frame, or since the start of the trace for the first frame of a block;
+//  - the zigzagged getbuffs status, zero or an error code, in which case the frame has no buffs and nothing else follows;
+//  - the number of buffs that ended, then their IDs in ascending order, each as the difference to the previous one;
+//  - the number of buffs that started or whose count changed, then their ID differences and zigzagged counts.
+namespace BuffTrace
+{
+inline constexpr std::array<char, 4> Magic { 'G', 'C', 'B', 'T' };
+inline constexpr u32 Version = 1;
+inline constexpr u32 FramesPerBlock = 1024;
+// Sanity limit on decoded block sizes, well above what FramesPerBlock frames of any real buff list could use
+inline constexpr u32 MaxBlockSize = 64 * 1024 * 1024;
+} // namespace BuffTrace
+
+class BuffTraceWriter
+{
+public:
+    BuffTraceWriter() = default;
+    BuffTraceWriter(const BuffTraceWriter&) = delete;
+    BuffTraceWriter& operator=(const BuffTraceWriter&) = delete;
+    ~BuffTraceWriter() { Close(); }
+
+    bool Open(const std::filesystem::path& path);
+    // Writes any pending frames and closes the file
+    void Close();
+    [[nodiscard]] bool isOpen() const { return file_.is_open(); }
+
+    // Appends a null-terminated getbuffs result, timestamped in microseconds since the start of the trace
+    void Record(u64 timeUs, const StackedBuff* buffs);
+
+    [[nodiscard]] u64 frameCount() const { return frameCount_; }
+
+protected:
+    void FlushBlock();
+
+    std::ofstream file_;
+    std::string block_;
+    std::string compressed_;
+    u32 blockFrames_ = 0;
+    u64 frameCount_ = 0;
+    u64 lastTimeUs_ = 0;
+    // Buffs of the previous and current frames, sorted by ID
+    std::vector<StackedBuff> previous_;
+    std::vector<StackedBuff> current_;
+};
+
+struct BuffTraceFrame
+{
+    u64 timeUs = 0;
+    // Null-terminated, exactly as getbuffs returned it save for the order, which is by ascending ID
+    std::vector<StackedBuff> buffs;
+};
+
+class BuffTraceReader
+{
+public:
+    bool Open(const std::filesystem::path& path);
+
+    // Decodes the next frame. Returns false at the end of the trace or if it is corrupted, as reported by failed().
+    bool Next(BuffTraceFrame& frame);
+
+    [[nodiscard]] bool failed() const { return failed_; }
+
+protected:
+    bool ReadBlock();
+    bool Fail(std::string_view reason);
+
+    std::ifstream file_;
+    std::string compressed_;
+    std::string block_;
+    size_t blockOffset_ = 0;
+    u32 blockFramesLeft_ = 0;
+    u64 lastTimeUs_ = 0;
+    std::vector<StackedBuff> previous_;
+    std::vector<StackedBuff> current_;
+    std::vector<u32> removed_;
+    std::vector<StackedBuff> changed_;
+    bool failed_ = false;
+};
+
+} // namespace GW2Clarity
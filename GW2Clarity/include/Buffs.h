@@ -1,65 +1,25 @@
 #pragma once
 
+#include <mutex>
+
 #include <imgui.h>
 
 #include "ActivationKeybind.h"
+#include "BuffCatalog.h"
+#include "BuffCatalogFile.h"
+#include "BuffSearch.h"
+#include "BuffStats.h"
+#include "BuffTable.h"
 #include "ConfigurationFile.h"
 #include "Graphics.h"
 #include "Layouts.h"
 #include "Main.h"
 #include "SettingsMenu.h"
+#include "TripleBuffer.h"
 
 namespace GW2Clarity
 {
 
-struct Buff
-{
-    u32 id;
-    i32 maxStacks;
-    std::string name;
-    std::string atlasEntry;
-    vec2 uv {};
-    std::set<u32> extraIds;
-    std::string category;
-
-    static std::string NameToAtlas(const std::string& name) { return ReplaceChars(ToLower(name), { { ' ', '_' }, { '\"', '_' } }); }
-
-    implicit Buff(std::string&& name) : Buff(0xFFFFFFFF, std::move(name)) { }
-
-    Buff(u32 id, std::string&& name, i32 maxStacks = std::numeric_limits<i32>::max())
-        : id(id), maxStacks(maxStacks), name(std::move(name)) {
-        atlasEntry = NameToAtlas(this->name);
-    }
-
-    Buff(u32 id, std::string&& name, std::string&& atlas, i32 maxStacks = std::numeric_limits<i32>::max())
-        : id(id), maxStacks(maxStacks), name(std::move(name)), atlasEntry(std::move(atlas)) { }
-
-    Buff(u32 id, std::string&& name, vec4&& uv, i32 maxStacks = std::numeric_limits<i32>::max())
-        : id(id), maxStacks(maxStacks), name(std::move(name)), uv(std::move(uv)) { }
-
-    Buff(std::initializer_list<u32> ids, std::string&& name, i32 maxStacks = std::numeric_limits<i32>::max())
-        : id(*ids.begin()), maxStacks(maxStacks), name(std::move(name)) {
-        atlasEntry = NameToAtlas(this->name);
-        extraIds.insert(ids.begin() + 1, ids.end());
-    }
-
-    Buff(std::initializer_list<u32> ids, std::string&& name, std::string&& atlas, i32 maxStacks = std::numeric_limits<i32>::max())
-        : id(*ids.begin()), maxStacks(maxStacks), name(std::move(name)), atlasEntry(std::move(atlas)) {
-        extraIds.insert(ids.begin() + 1, ids.end());
-    }
-
-    Buff(std::initializer_list<u32> ids, std::string&& name, vec2&& uv, i32 maxStacks = std::numeric_limits<i32>::max())
-        : id(*ids.begin()), maxStacks(maxStacks), name(std::move(name)), uv(std::move(uv)) {
-        extraIds.insert(ids.begin() + 1, ids.end());
-    }
-
-    [[nodiscard]] i32 GetStacks(std::unordered_map<u32, i32>& activeBuffs) const {
-        return std::accumulate(extraIds.begin(), extraIds.end(), activeBuffs[id], [&](i32 a, u32 b) { return a + activeBuffs[b]; });
-    }
-
-    [[nodiscard]] bool ShowNumber(i32 count) const { return maxStacks > 1 && count > 1; }
-};
-
 class Buffs
 #ifdef _DEBUG
     : public SettingsMenu::Implementer
@@ -76,46 +36,72 @@ public:
 
     void UpdateBuffsTable(StackedBuff* buffs);
 
-    static inline const Buff UnknownBuff { 0, "Unknown", 1 };
+    // Statistics are fed every table published by UpdateBuffsTable, and may be read from any thread
+    void UpdateStatsCombat(bool inCombat);
+    void SnapshotStats(BuffStatsWindow window, BuffStatsSnapshot& out) const;
+    void ResetStats();
 
-    [[nodiscard]] auto buffs() const { return std::span { buffs_ }; }
-    [[nodiscard]] vec2 GetNumber(i32 n) const {
-        // 0 and 1 are not in the array, so 2 is at index 0
-        n -= 2;
-        return n < 0 ? vec2 {} : n < i32(numbers_.size()) ? numbers_[n] : numbers_.back();
-    }
-    [[nodiscard]] const auto& buffsMap() const { return buffsMap_; }
-    [[nodiscard]] auto& activeBuffs() const { return activeBuffs_; }
+    [[nodiscard]] auto buffs() const { return catalog_.buffs(); }
+    [[nodiscard]] const BuffCatalog& catalog() const { return catalog_; }
+    [[nodiscard]] const BuffSlotMap& buffSlots() const { return catalog_.slots(); }
+    // Latest published buff table, only to be called from the render thread. The returned table is immutable until the next call.
+    const ActiveBuffsTable& AcquireActiveBuffs() const { return activeBuffs_.Acquire(); }
+    // Table returned by the last call to AcquireActiveBuffs()
+    [[nodiscard]] const ActiveBuffsTable& activeBuffs() const { return activeBuffs_.front(); }
 
-    [[nodiscard]] const auto& buffsAtlasUVSize() const { return buffsAtlasUVSize_; }
+    [[nodiscard]] vec2 buffsAtlasUVSize() const { return catalog_.atlasUVSize(); }
     [[nodiscard]] const auto& numbersAtlasUVSize() const { return numbersAtlasUVSize_; }
 
     [[nodiscard]] const Texture2D& buffsAtlas() const { return buffsAtlas_; }
     [[nodiscard]] const Texture2D& numbersAtlas() const { return numbersAtlas_; }
+    // Atlas UVs indexed by Buff::atlasSlot, and number UVs indexed by the number minus two, as read by Grids.hlsl
+    [[nodiscard]] const auto& atlasUVs() const { return atlasUVs_; }
+    [[nodiscard]] const auto& numberUVs() const { return numberUVs_; }
+
+    // Results are cached by the caller so that typing further into the search box only narrows them down
+    bool DrawBuffCombo(const char* name, const Buff*& selectedBuf, std::span<char> searchBuffer, BuffSearchResults& results) const;
 
-    bool DrawBuffCombo(const char* name, const Buff*& selectedBuf, std::span<char> searchBuffer) const;
+    [[nodiscard]] const BuffSearchIndex& searchIndex() const { return searchIndex_; }
 
 protected:
     Texture2D buffsAtlas_;
     Texture2D numbersAtlas_;
+    ComPtr<ID3D11ShaderResourceView> atlasUVs_;
+    ComPtr<ID3D11ShaderResourceView> numberUVs_;
 
-    vec2 buffsAtlasUVSize_;
     vec2 numbersAtlasUVSize_;
 
-    const std::vector<Buff> buffs_;
-    const std::unordered_map<i32, const Buff*> buffsMap_;
+    // Catalog file shipped next to the DLL, if any, used instead of the compiled catalog
+    const std::optional<BuffCatalogFile> catalogFile_;
+    const BuffCatalog& catalog_;
     const std::vector<vec2> numbers_;
-    mutable std::unordered_map<u32, i32> activeBuffs_;
+    BuffSearchIndex searchIndex_;
+    mutable TripleBuffer<ActiveBuffsTable> activeBuffs_;
+    // Counts of the last published table, which the next one is diffed against
+    std::vector<i32> publishedCounts_;
+    mutable std::mutex statsMutex_;
+    mutable BuffStats stats_;
+    u64 activeBuffsGeneration_ = 0;
     i32 lastGetBuffsError_ = 0;
-
-    static std::vector<Buff> GenerateBuffsList(vec2& uvSize);
-    static std::unordered_map<i32, const Buff*> GenerateBuffsMap(const std::vector<Buff>& lst);
+    bool overflowWarned_ = false;
 
 #ifdef _DEBUG
     i32 guildLogId_ = 3;
     std::unordered_map<u32, std::string> buffNames_;
     bool hideInactive_ = false;
     std::set<u32> hiddenBuffs_;
+    std::vector<bool> seenSlots_;
+    std::set<u32> seenUnknownIds_;
+    // Buffs seen by UpdateBuffsTable for the first time since the menu was last drawn, so that buffs only active while it is closed, or
+    // between two frames, are listed too. Only UpdateBuffsTable touches the recorded buffs.
+    std::vector<bool> recordedSlots_;
+    std::set<u32> recordedUnknownIds_;
+    std::mutex pendingSeenMutex_;
+    std::vector<bool> pendingSeenSlots_;
+    std::set<u32> pendingSeenUnknownIds_;
+    bool pendingSeen_ = false;
+    // IDs and counts of the rows shown this frame, kept to reuse its capacity
+    std::vector<std::pair<u32, i32>> shownBuffs_;
 
     void SaveNames() const;
     void LoadNames();
@@ -129,7 +115,9 @@ public:
 
     const auto& name() const { return name_; }
 
-    bool Draw(const char* display = nullptr) { return buffs_->DrawBuffCombo(display ? display : name_.c_str(), selectedBuff_, buffer_); }
+    bool Draw(const char* display = nullptr) {
+        return buffs_->DrawBuffCombo(display ? display : name_.c_str(), selectedBuff_, buffer_, results_);
+    }
 
     const auto* selectedBuff() const { return selectedBuff_; }
 
@@ -138,6 +126,7 @@ protected:
     std::string name_;
     const Buff* selectedBuff_ = nullptr;
     std::array<char, 512> buffer_ { '\0' };
+    BuffSearchResults results_;
 };
 
 } // namespace GW2Clarity
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Reads a configuration value of type T, vectors being stored as arrays of their components
+template<typename T>
+[[nodiscard]] T FromJson(const nlohmann::json& j) {
+    if constexpr(requires { T::length(); }) {
+        T v;
+        for(i32 c = 0; c < i32(T::length()); c++)
+            v[c] = j[c].template get<std::remove_cvref_t<decltype(v[c])>>();
+        return v;
+    }
+    else
+        return j.get<T>();
+}
+
+// The value at key in object j, or def if j has no such key
+template<typename T>
+[[nodiscard]] T ReadOr(const nlohmann::json& j, const char* key, const T& def) {
+    const auto it = j.find(key);
+    return it == j.end() ? def : FromJson<T>(*it);
+}
+
+// The top-level section of a configuration document, or null if it has none, which iterates as empty
+[[nodiscard]] inline const nlohmann::json& ConfigSection(const nlohmann::json& config, const char* key) {
+    static const nlohmann::json Missing;
+    const auto it = config.find(key);
+    return it == config.end() ? Missing : *it;
+}
+
+} // namespace GW2Clarity
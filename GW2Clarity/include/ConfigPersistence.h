@@ -0,0 +1,92 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <mutex>
+#include <set>
+#include <thread>
+
+#include <nlohmann/json.hpp>
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Sole writer of the configuration file, writing it on a background thread so that saving never serializes JSON or touches the disk on the
+// render thread. The file's content is the in-memory document it was loaded into, owned by the thread calling everything but Flush and
+// writeCount, with sections submitted by components on top.
+//
+// Components own top-level keys of the document, their sections, for which they submit a serializer owning an immutable snapshot of their
+// state, run on the background thread. Smaller values, such as options, are set in the document through Set. Either way, the document
+// minus the sections is copied for the background thread, which never reads the file back. Submissions are coalesced for coalesceDelay, the latest
+// one for each key winning, then the whole file is rewritten atomically by writing a temporary file and renaming it over the original.
+// Every write also refreshes the file's ConfigSnapshot.
+class ConfigPersistence
+{
+public:
+    using Serializer = std::function<nlohmann::json()>;
+
+    // The document's own value for each section is only written until the section is first submitted
+    ConfigPersistence(std::filesystem::path path, nlohmann::json& document, std::span<const std::string> sections,
+                      std::chrono::milliseconds coalesceDelay = std::chrono::milliseconds(1000));
+    ConfigPersistence(const ConfigPersistence&) = delete;
+    ConfigPersistence& operator=(const ConfigPersistence&) = delete;
+    // Writes anything still pending before returning
+    ~ConfigPersistence();
+
+    // The serializer runs on the background thread and must not refer to anything its caller may modify or destroy
+    void Submit(const std::string& section, Serializer serializer);
+    // Sets the value of key in the given object of the document and queues it for writing
+    void Set(const std::string& object, const std::string& key, nlohmann::json value);
+
+    // Snapshots the file as it is on disk, in the background, after startup found the snapshot missing or stale
+    void RefreshSnapshot();
+
+    // Thread-safe. Blocks until everything submitted so far is on disk, without waiting out the coalescing delay.
+    void Flush();
+
+    [[nodiscard]] const std::filesystem::path& path() const { return path_; }
+    [[nodiscard]] const nlohmann::json& document() const { return document_; }
+    // Number of times the file was written, read from any thread
+    [[nodiscard]] u64 writeCount() const { return writeCount_.load(std::memory_order_relaxed); }
+
+protected:
+    [[nodiscard]] nlohmann::json CopyDocument() const;
+    // Queues a copy of the document for writing, lock held
+    void QueueDocument();
+    void Run();
+    void Write(std::map<std::string, Serializer>& batch);
+    void SnapshotFile();
+
+    const std::filesystem::path path_;
+    nlohmann::json& document_;
+    const std::chrono::milliseconds coalesceDelay_;
+    // Only touched by the thread owning the document
+    std::set<std::string> sectionKeys_;
+
+    std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable written_;
+    std::map<std::string, Serializer> pending_;
+    std::optional<nlohmann::json> pendingDocument_;
+    // Submissions are numbered so Flush knows when all of those preceding it have been written
+    u64 submitted_ = 0;
+    u64 writtenUpTo_ = 0;
+    bool flushRequested_ = false;
+    bool snapshotRequested_ = false;
+    bool stopping_ = false;
+
+    // Only touched by the background thread. The latest copy of the document and every section, as loaded or as last serialized,
+    // reapplied on top of it each time the file is rewritten so that a failed write is retried by the next one.
+    nlohmann::json base_;
+    std::map<std::string, nlohmann::json> sections_;
+    std::atomic<u64> writeCount_ { 0 };
+
+    // Started once everything above is initialized
+    std::thread thread_;
+};
+
+} // namespace GW2Clarity
@@ -0,0 +1,150 @@
+#pragma once
+
+#include <filesystem>
+
+#include <nlohmann/json.hpp>
+
+#include "GridConfig.h"
+#include "LayoutConfig.h"
+#include "Main.h"
+#include "MappedFile.h"
+#include "StyleTable.h"
+
+namespace GW2Clarity
+{
+
+// Config snapshots hold the styles, grids and layouts of the JSON configuration in flat arrays which are used straight from a memory
+// mapping, to skip parsing the JSON at startup. A snapshot is tied to the exact configuration it was made from by the XXH3 hash of the
+// file's contents, and is otherwise ignored.
+//
+// The file is a Header followed by the arrays it points to. Strings are ranges of a shared blob, deduplicated, so that style names can be
+// resolved once each. Buffs are stored by ID and styles by name, so a snapshot stays valid across changes to the catalog or to the
+// built-in styles.
+namespace ConfigSnapshotFormat
+{
+inline constexpr std::array<char, 4> Magic { 'G', 'C', 'C', 'S' };
+// Bump whenever the layout of the file or the way JSON is converted changes
+inline constexpr u32 Version = 1;
+
+// Byte offset from the start of the file and number of elements
+struct Range
+{
+    u32 offset, count;
+};
+
+// Range of the string blob
+struct String
+{
+    u32 offset, size;
+};
+
+struct Header
+{
+    std::array<char, 4> magic;
+    u32 version;
+    u64 sourceHash;
+    Range strings, styles, thresholds, grids, items, buffIds, layouts, layoutGrids;
+};
+
+struct Style
+{
+    String name;
+    u32 firstThreshold, thresholdCount;
+};
+
+struct Threshold
+{
+    u32 thresholdMin, thresholdMax;
+    f32 tint[4], border[4], glow[4];
+    f32 borderThickness, glowSize;
+    f32 glowPulse[2];
+};
+
+struct Grid
+{
+    String name;
+    i32 spacing[2], offset[2], mouseClipMin[2], mouseClipMax[2];
+    f32 centralWeight;
+    u32 firstItem, itemCount;
+    u8 attached, trackMouseWhileHeld, square, padding;
+};
+
+struct Item
+{
+    i32 pos[2];
+    i32 buffId;
+    String style;
+    // Range of buffIds
+    u32 firstAdditionalBuff, additionalBuffCount;
+};
+
+struct Layout
+{
+    String name;
+    // Range of layoutGrids
+    u32 firstGrid, gridCount;
+    u8 combatOnly, padding[3];
+};
+} // namespace ConfigSnapshotFormat
+
+// Where the snapshot of a JSON configuration file is kept
+[[nodiscard]] std::filesystem::path ConfigSnapshotPath(const std::filesystem::path& configPath);
+
+// XXH3 hash of a configuration file's contents, or nothing if it could not be read
+[[nodiscard]] std::optional<u64> HashConfigFile(const std::filesystem::path& configPath);
+[[nodiscard]] u64 HashConfigText(std::string_view text);
+
+// Converts the "styles", "buff_grids" and "buff_layouts" sections of a configuration document as StyleTable::LoadStyles, LoadGrids and
+// LoadLayouts read them, and writes them atomically. Returns false and logs why if the snapshot could not be written.
+bool WriteConfigSnapshot(const std::filesystem::path& path, u64 sourceHash, const nlohmann::json& config);
+
+class ConfigSnapshot
+{
+public:
+    // Returns nothing if there is no snapshot, or if it is damaged, from another version or not made from the configuration hashing to
+    // sourceHash
+    [[nodiscard]] static std::optional<ConfigSnapshot> Open(const std::filesystem::path& path, u64 sourceHash);
+
+    // User styles, to be passed to StyleTable::LoadStyles
+    [[nodiscard]] std::vector<StyleTable::Style> ReadStyles() const;
+    [[nodiscard]] std::vector<Grid> ReadGrids(const BuffCatalog& catalog, const StyleTable& styles) const;
+    [[nodiscard]] std::vector<Layout> ReadLayouts(size_t gridCount) const;
+
+protected:
+    explicit ConfigSnapshot(MappedFile file) : file_(std::move(file)) { }
+
+    [[nodiscard]] bool Validate() const;
+
+    template<typename T>
+    [[nodiscard]] std::span<const T> Array(ConfigSnapshotFormat::Range r) const {
+        return { reinterpret_cast<const T*>(file_.data().data() + r.offset), r.count };
+    }
+    [[nodiscard]] const ConfigSnapshotFormat::Header& header() const {
+        return *reinterpret_cast<const ConfigSnapshotFormat::Header*>(file_.data().data());
+    }
+    [[nodiscard]] std::string_view String(ConfigSnapshotFormat::String s) const {
+        return { Array<char>(header().strings).data() + s.offset, s.size };
+    }
+
+    MappedFile file_;
+};
+
+// What components load their configuration from at startup: the snapshot when there is an up to date one, the JSON document otherwise
+class ConfigSource
+{
+public:
+    ConfigSource(const nlohmann::json& config, const ConfigSnapshot* snapshot) : config_(config), snapshot_(snapshot) { }
+
+    void LoadStyles(StyleTable& styles) const;
+    [[nodiscard]] std::vector<Grid> LoadGrids(const BuffCatalog& catalog, const StyleTable& styles) const;
+    [[nodiscard]] std::vector<Layout> LoadLayouts(size_t gridCount) const;
+
+    // Sections the snapshot doesn't cover
+    [[nodiscard]] const nlohmann::json& section(const char* key) const;
+
+protected:
+    const nlohmann::json& config_;
+    const ConfigSnapshot* snapshot_;
+};
+
+} // namespace GW2Clarity
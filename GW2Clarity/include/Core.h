@@ -3,12 +3,18 @@
 #include <d3d11_1.h>
 #include <dxgi.h>
 
-#include "ConfigurationOption.h"
+#include "BuffPoller.h"
+#include "BuffSource.h"
+#include "BuffStatsMenu.h"
+#include "BuffTrace.h"
+#include "ConfigPersistence.h"
 #include "Cursor.h"
 #include "Direct3D11Loader.h"
 #include "Grids.h"
 #include "Layouts.h"
 #include "Main.h"
+#include "PersistedOption.h"
+#include "ProfilerMenu.h"
 #include "Resource.h"
 #include "Singleton.h"
 
@@ -17,8 +23,6 @@ class ShaderManager;
 namespace GW2Clarity
 {
 
-using GetBuffsCallback = StackedBuff*(__cdecl*)();
-
 class Core : public BaseCore, public Singleton<Core>
 {
 public:
@@ -35,6 +39,18 @@ public:
 
     vec2 screenDims() const { return vec2(screenWidth_, screenHeight_); }
 
+    // Recording starts or stops on the next frequent update, writing a new trace next to the addon each time it starts
+    [[nodiscard]] bool recordBuffTrace() const { return recordBuffTrace_; }
+    void recordBuffTrace(bool record) { recordBuffTrace_ = record; }
+
+    [[nodiscard]] const BuffPoller::Stats& buffPollStats() const { return buffPoller_.stats(); }
+#ifdef GW2CLARITY_ALLOCATION_TRACKING
+    [[nodiscard]] u64 lastFrameAllocations() const { return lastFrameAllocations_; }
+#endif
+
+    // Every component saves its part of the configuration through this
+    [[nodiscard]] ConfigPersistence& configPersistence() { return *configPersistence_; }
+
 protected:
     void InnerDraw() override;
     void InnerUpdate() override;
@@ -49,14 +65,31 @@ protected:
     [[nodiscard]] const wchar_t* GetShaderDirectory() const override { return SHADERS_DIR; }
     [[nodiscard]] const wchar_t* GetGithubRepoSubUrl() const override { return L"Friendly0Fire/GW2Clarity"; }
 
-    std::unique_ptr<ConfigurationOption<bool>> firstMessageShown_;
+    std::unique_ptr<PersistedOption<bool>> firstMessageShown_;
     std::unique_ptr<Styles> styles_;
     std::unique_ptr<Buffs> buffs_;
     std::unique_ptr<Grids> grids_;
     std::unique_ptr<Layouts> layouts_;
     std::unique_ptr<Cursor> cursor_;
-    HMODULE buffLib_ = nullptr;
-    GetBuffsCallback getBuffs_ = nullptr;
+    std::unique_ptr<BuffStatsMenu> buffStatsMenu_;
+    // Destroyed before the components, writing their last submissions while the buffs they refer to still exist
+    std::unique_ptr<ConfigPersistence> configPersistence_;
+#ifdef GW2CLARITY_PROFILING
+    std::unique_ptr<ProfilerMenu> profilerMenu_;
+#endif
+#ifdef GW2CLARITY_ALLOCATION_TRACKING
+    // Render thread allocations between the starts of the last two frames, settings menus included
+    u64 frameAllocationsStart_ = 0;
+    u64 lastFrameAllocations_ = 0;
+#endif
+    std::unique_ptr<BuffSource> buffSource_;
+    BuffPoller buffPoller_;
+
+    void UpdateBuffTrace(const StackedBuff* buffs);
+    std::atomic<bool> recordBuffTrace_ = false;
+    // Only touched by the frequent update thread
+    BuffTraceWriter buffTrace_;
+    std::chrono::steady_clock::time_point buffTraceStart_;
 
     ImFont* fontBuffCounter_ = nullptr;
 
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <imgui.h>
+#include <nlohmann/json.hpp>
 
 #include "ActivationKeybind.h"
+#include "ConfigSnapshot.h"
 #include "Graphics.h"
 #include "Main.h"
 #include "SettingsMenu.h"
@@ -14,7 +16,7 @@ namespace GW2Clarity
 class Cursor : public SettingsMenu::Implementer
 {
 public:
-    explicit Cursor(ComPtr<ID3D11Device>& dev);
+    Cursor(ComPtr<ID3D11Device>& dev, const ConfigSource& config);
     virtual ~Cursor();
 
     void Draw(ComPtr<ID3D11DeviceContext>& ctx);
@@ -47,8 +49,10 @@ public:
     };
 
 protected:
-    void Load();
+    void Load(const nlohmann::json& layers);
+    // Queues the layers for saving, serialized off the render thread by SaveLayers
     void Save();
+    [[nodiscard]] static nlohmann::json SaveLayers(std::span<const Layer> layers);
 
     struct CursorData
     {
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <format>
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Label formatted on the stack, truncated if need be, for labels which change too often to be worth caching in a LabelCache
+template<size_t N = 256>
+class FixedLabel
+{
+public:
+    template<typename... Args>
+    explicit FixedLabel(std::format_string<Args...> fmt, Args&&... args) {
+        *std::format_to_n(text_.data(), N - 1, fmt, std::forward<Args>(args)...).out = '\0';
+    }
+
+    [[nodiscard]] const char* c_str() const { return text_.data(); }
+
+protected:
+    std::array<char, N> text_;
+};
+
+} // namespace GW2Clarity
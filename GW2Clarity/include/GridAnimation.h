@@ -0,0 +1,40 @@
+#pragma once
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// CPU reference for the animations evaluated in Grids.hlsl, both sides must be kept in sync.
+// Shader time wraps every AnimationTimePeriod seconds; all animation frequencies are quantized so that they complete a whole number of
+// cycles over that period, which keeps them continuous across the wrap.
+inline constexpr u32 AnimationTimePeriod = 3600;
+
+inline f32 WrapAnimationTime(mstime ms) {
+    constexpr mstime periodMs = mstime(AnimationTimePeriod) * 1000;
+    return f32(ms % periodMs) / 1000.f;
+}
+
+// Border pulse towards HighlightColor for highlighted instances
+inline constexpr f32 HighlightPulseFrequency = 1.f;
+inline constexpr vec4 HighlightColor { 1.f, 0.f, 0.f, 1.f };
+
+inline f32 QuantizeAnimationFrequency(f32 hz) { return std::round(hz * f32(AnimationTimePeriod)) / f32(AnimationTimePeriod); }
+
+// Oscillates in [0, 1], starting at 0.5 for a phase of zero
+inline f32 PulseWave(f32 frequency, f32 phase, f32 time) {
+    f32 cycle = frequency * time;
+    cycle -= std::floor(cycle);
+    return std::sin(cycle * 2.f * std::numbers::pi_v<f32> + phase) * 0.5f + 0.5f;
+}
+
+// Fraction of the full glow size to display, pulsing between 1 - amplitude and 1
+inline f32 GlowPulseScale(f32 amplitude, f32 frequency, f32 phase, f32 time) {
+    f32 x = PulseWave(frequency, phase, time);
+    return (1.f - amplitude) + amplitude * x;
+}
+
+// Weight of the pulse color in the border color, zero when the border doesn't pulse
+inline f32 BorderPulseWeight(f32 frequency, f32 time) { return frequency > 0.f ? PulseWave(frequency, 0.f, time) : 0.f; }
+
+} // namespace GW2Clarity
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Sizing policy for the grid instance buffer, kept free of any D3D dependency
+struct GridBufferPolicy
+{
+    // Above this many instances, draws are split into several batches instead of growing the buffer further
+    static inline constexpr size_t MaxCapacity = 1 << 16;
+
+    [[nodiscard]] static size_t GrowCapacity(size_t capacity, size_t required) {
+        if(required <= capacity || capacity >= MaxCapacity)
+            return capacity;
+
+        return std::min(std::max(capacity * 2, std::bit_ceil(required)), MaxCapacity);
+    }
+
+    [[nodiscard]] static u32 BatchCount(size_t count, size_t capacity) { return u32((count + capacity - 1) / capacity); }
+
+    struct Batch
+    {
+        size_t first, count;
+    };
+
+    // Instances drawn by the given batch out of BatchCount(count, capacity)
+    [[nodiscard]] static Batch BatchRange(u32 batch, size_t count, size_t capacity) {
+        const size_t first = batch * capacity;
+        return { first, std::min(capacity, count - first) };
+    }
+};
+
+} // namespace GW2Clarity
@@ -0,0 +1,145 @@
+#pragma once
+
+#include <iosfwd>
+
+#include <nlohmann/json.hpp>
+
+#include "BuffCatalog.h"
+#include "GridInstance.h"
+#include "Main.h"
+#include "StyleTable.h"
+
+namespace GW2Clarity
+{
+
+// Fits a w by h icon into the available width, stretching its smaller side to keep it square
+inline vec2 AdjustToArea(f32 w, f32 h, f32 availW) {
+    vec2 dims(w, h);
+    if(dims.x < dims.y)
+        dims.x = dims.y * w / h;
+    else if(dims.x > dims.y)
+        dims.y = dims.x * h / w;
+
+    if(availW < dims.x) {
+        dims.y *= availW / dims.x;
+        dims.x = availW;
+    }
+
+    return dims;
+}
+
+// Mouse state attached grids follow, supplied by the input layer
+struct GridMouseState
+{
+    vec2 position {};
+    // Where the mouse was when a button started being held, empty while no button is held
+    std::optional<vec2> heldPosition;
+    // Attached grids follow the mouse even while being edited
+    bool testMode = false;
+};
+
+inline constexpr ivec2 GridDefaultSpacing { 64, 64 };
+
+struct GridItem
+{
+    ivec2 pos { 0, 0 };
+    const Buff* buff = &UnknownBuff;
+    u32 style = 0;
+    std::vector<const Buff*> additionalBuffs;
+
+    // Range into the compiled stack sources listing every buff slot contributing to this item's count
+    u32 firstStackSource = 0;
+    u32 stackSourceCount = 0;
+};
+
+struct Grid
+{
+    std::string name { "New Grid" };
+    ivec2 spacing = GridDefaultSpacing;
+    ivec2 offset = {};
+    f32 centralWeight = 0.f;
+    ivec2 mouseClipMin { std::numeric_limits<i32>::max() };
+    ivec2 mouseClipMax { std::numeric_limits<i32>::min() };
+    bool trackMouseWhileHeld = true;
+    std::vector<GridItem> items;
+    bool attached = false;
+    bool square = true;
+
+    [[nodiscard]] vec2 ComputeOrigin(bool editMode, const vec2& screen, const GridMouseState& mouse) const {
+        vec2 gridOrigin;
+        if(!attached || (editMode && !mouse.testMode))
+            gridOrigin = screen * 0.5f + vec2(offset);
+        else {
+            if(!trackMouseWhileHeld && mouse.heldPosition)
+                gridOrigin = *mouse.heldPosition;
+            else
+                gridOrigin = mouse.position;
+
+            if(mouseClipMin.x != std::numeric_limits<i32>::max()) {
+                gridOrigin = glm::max(gridOrigin, vec2(mouseClipMin));
+                gridOrigin = glm::min(gridOrigin, vec2(mouseClipMax));
+            }
+
+            if(centralWeight > 0.f)
+                gridOrigin = glm::mix(gridOrigin, screen * 0.5f, centralWeight);
+        }
+
+        return gridOrigin;
+    }
+};
+
+// Lists the buff slots contributing to every item's count, in item order, and stores each item's range into the list
+void CompileStackSources(std::span<Grid> grids, const BuffSlotMap& slots, std::vector<u32>& stackSources);
+
+[[nodiscard]] inline i32 CountStacks(std::span<const i32> counts, std::span<const u32> stackSources, const GridItem& i) {
+    i32 count = 0;
+    for(u32 slot : stackSources.subspan(i.firstStackSource, i.stackSourceCount))
+        count += counts[slot];
+    return count;
+}
+
+// Inverse of the stack sources: every item whose count a buff slot contributes to, so that a change to one buff's stacks only touches
+// the items depending on it. Covers primary IDs, extra IDs and additional buffs alike, since all of them compile to slots.
+class GridDependencyIndex
+{
+public:
+    // Must be rebuilt whenever the stack sources are compiled
+    void Build(std::span<const Grid> grids, std::span<const u32> stackSources, size_t slotCount);
+
+    // Items depending on the slot, each listed once, in grid then item order
+    [[nodiscard]] std::span<const Id> operator[](u32 slot) const {
+        if(slot + 1 >= offsets_.size())
+            return {};
+        return std::span { items_ }.subspan(offsets_[slot], offsets_[slot + 1] - offsets_[slot]);
+    }
+
+protected:
+    // Range of items_ for every slot, with one past the last slot's end
+    std::vector<u32> offsets_;
+    std::vector<Id> items_;
+};
+
+// Packed instance of the item at index iid of the grid, as BuildGridInstances appends it
+[[nodiscard]] PackedGridInstanceData BuildGridInstance(const Grid& g, i16 iid, const vec2& origin, const vec2& screen,
+                                                       const StyleTable& styles, std::span<const i32> counts,
+                                                       std::span<const u32> stackSources, i16 editingItem, i32 editingCount);
+
+// GPU evaluation input for the item at index iid of the grid, drawn as the given grid index. EvaluateGridItem gives the same instance for it
+// as BuildGridInstance, editing taking the place of editingItem.
+[[nodiscard]] GridItemData BuildGridItemData(const Grid& g, i16 iid, u32 gridIndex, const StyleTable& styles, bool editing, i32 editingCount);
+
+// Appends the packed instance of every item of the grid. The item at index editingItem, if any, is highlighted and displays
+// editingCount instead of its live count.
+void BuildGridInstances(const Grid& g, const vec2& origin, const vec2& screen, const StyleTable& styles, std::span<const i32> counts,
+                        std::span<const u32> stackSources, i16 editingItem, i32 editingCount, std::vector<PackedGridInstanceData>& out);
+
+// Reads the "buff_grids" array. Style names are resolved against the given styles, unknown buffs become UnknownBuff.
+[[nodiscard]] std::vector<Grid> LoadGrids(const nlohmann::json& grids, const BuffCatalog& catalog, const StyleTable& styles);
+// Reads "buff_grids" out of a whole configuration document as it is parsed, without building the document in memory, for configurations
+// too large to comfortably hold twice. Gives the same grids as LoadGrids for any document LoadGrids accepts; values of unexpected types
+// are ignored rather than rejected. Returns nothing if the document is not valid JSON.
+[[nodiscard]] std::optional<std::vector<Grid>> StreamGrids(std::istream& config, const BuffCatalog& catalog, const StyleTable& styles);
+// Item styles are written by name, styleNames being indexed by style ID as in StyleTable::style
+[[nodiscard]] nlohmann::json SaveGrids(std::span<const Grid> grids, std::span<const std::string> styleNames);
+
+} // namespace GW2Clarity
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "GridInstance.h"
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Style appearance for a given count, laid out like the last five words of PackedGridInstanceData
+struct PackedGridAppearance
+{
+    u32 tint;
+    u32 borderColor;
+    u32 glowColor;
+    u32 sizes;
+    u32 pulse;
+};
+static_assert(sizeof(PackedGridAppearance) == 20);
+
+// Row of the GPU appearance table: the appearance applies from minCount up to the next row's minCount within the same style
+struct PackedGridAppearanceInterval
+{
+    u32 minCount;
+    PackedGridAppearance appearance;
+};
+static_assert(sizeof(PackedGridAppearanceInterval) == 24);
+
+inline PackedGridAppearance PackAppearance(const GridInstanceData& in) {
+    const auto p = Pack(in);
+    return { p.tint, p.borderColor, p.glowColor, p.sizes, p.pulse & ~PackedGridInstanceData::HighlightBit };
+}
+
+// Static description of a grid item for GPU evaluation, only rebuilt when the grids or the selection change
+struct GridItemData
+{
+    enum Flags : u32
+    {
+        ShowNumber = 1,
+        // Use fixedCount instead of the stack sources and highlight the item
+        Editing = 2,
+    };
+
+    vec2 offset; // pixels from the grid origin
+    vec2 dims;   // pixels
+    u32 grid;    // index into the per-frame grid origins
+    u32 firstStackSource;
+    u32 stackSourceCount;
+    u32 firstAppearance;
+    u32 appearanceCount;
+    u32 atlasSlot;
+    u32 flags;
+    i32 fixedCount;
+};
+static_assert(sizeof(GridItemData) == 48);
+
+// CPU reference for the evaluation done by GridsEvaluated_VS in Grids.hlsl. The result is bit for bit what the CPU path packs for
+// the same item, so any mismatch points at a divergence between the two.
+inline PackedGridInstanceData EvaluateGridItem(const GridItemData& item, const vec2& origin, const vec2& screen, std::span<const i32> counts,
+                                               std::span<const u32> stackSources, std::span<const PackedGridAppearanceInterval> appearances) {
+    i32 count = item.fixedCount;
+    if(!(item.flags & GridItemData::Editing)) {
+        count = 0;
+        for(u32 slot : stackSources.subspan(item.firstStackSource, item.stackSourceCount))
+            count += counts[slot];
+    }
+
+    // Row 0 is the default appearance, used for negative counts just like Styles::ApplyStyle
+    u32 row = 0;
+    if(count >= 0) {
+        row = item.firstAppearance;
+        for(u32 i = 1; i < item.appearanceCount && appearances[item.firstAppearance + i].minCount <= u32(count); i++)
+            row = item.firstAppearance + i;
+    }
+    const auto& app = appearances[row].appearance;
+
+    GridInstanceData inst;
+    const vec2 pos = origin + item.offset;
+    inst.posDims = { pos.x / screen.x, pos.y / screen.y, item.dims.x / screen.x, item.dims.y / screen.y };
+    inst.atlasSlot = item.atlasSlot;
+    inst.number = (item.flags & GridItemData::ShowNumber) && count > 1 ? count : 0;
+
+    auto packed = Pack(inst);
+    packed.tint = app.tint;
+    packed.borderColor = app.borderColor;
+    packed.glowColor = app.glowColor;
+    packed.sizes = app.sizes;
+    packed.pulse = app.pulse;
+
+    if(item.flags & GridItemData::Editing) {
+        using P = PackedGridInstanceData;
+        // PackUnorm is monotonic, so this matches packing max(borderThickness, 1)
+        const u32 minThickness = PackUnorm(1.f, 16, P::BorderThicknessRange) << 16;
+        packed.sizes = (packed.sizes & 0xFFFF) | std::max(packed.sizes & 0xFFFF0000, minThickness);
+        packed.pulse |= P::HighlightBit;
+    }
+
+    return packed;
+}
+
+} // namespace GW2Clarity
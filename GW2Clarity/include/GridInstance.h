@@ -0,0 +1,106 @@
+#pragma once
+
+#include "GridAnimation.h"
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Full precision description of a grid icon, as built on the CPU
+struct GridInstanceData
+{
+    vec4 posDims {};
+    u32 atlasSlot = 0;
+    // Stack count to display, zero hides the number
+    i32 number = 0;
+    vec4 tint { 1.f };
+    vec4 borderColor {};
+    vec4 glowColor {};
+    f32 glowSize = 0.f;
+    f32 borderThickness = 0.f;
+    // x: amplitude, y: frequency, z: phase
+    vec3 glowPulse {};
+    // Pulses the border towards HighlightColor, used to show the item being edited
+    bool highlight = false;
+};
+
+// Compact form of GridInstanceData uploaded to the GPU, unpacked by Grids.hlsl.
+// Values are clamped to their range, after which the round trip error is at most half a step: 2.3e-5 for positions, 1.5e-5 for
+// dimensions, 2e-3 for colors and glow amplitude, 7.6e-5 for glow size, 4e-3 pixels for border thickness and 0.013 rad for glow phase.
+struct PackedGridInstanceData
+{
+    u32 pos;         // unorm16 x2, mapped to PositionRange
+    u32 dims;        // unorm16 x2, mapped to DimensionsRange
+    u32 slots;       // atlas slot (low 16 bits), displayed number (high 16 bits)
+    u32 tint;        // rgba8
+    u32 borderColor; // rgba8
+    u32 glowColor;   // rgba8
+    u32 sizes;       // unorm16 glow size mapped to GlowSizeRange, unorm16 border thickness mapped to BorderThicknessRange
+    u32 pulse;       // unorm8 amplitude, unorm8 phase, 15 bit frequency in cycles per AnimationTimePeriod, highlight bit
+
+    static inline constexpr vec2 PositionRange { -1.f, 2.f };
+    static inline constexpr vec2 DimensionsRange { 0.f, 2.f };
+    static inline constexpr vec2 GlowSizeRange { 0.f, 10.f };
+    static inline constexpr vec2 BorderThicknessRange { 0.f, 512.f };
+    static inline constexpr u32 MaxFrequencyCycles = 0x7FFF;
+    static inline constexpr u32 HighlightBit = 0x80000000;
+
+    bool operator==(const PackedGridInstanceData&) const = default;
+};
+static_assert(sizeof(PackedGridInstanceData) == 32);
+
+inline u32 PackUnorm(f32 v, u32 bits, const vec2& range = { 0.f, 1.f }) {
+    const f32 maxValue = f32((1u << bits) - 1);
+    return u32(std::lround(std::clamp((v - range.x) / (range.y - range.x), 0.f, 1.f) * maxValue));
+}
+
+inline f32 UnpackUnorm(u32 v, u32 bits, const vec2& range = { 0.f, 1.f }) {
+    const u32 mask = (1u << bits) - 1;
+    return range.x + f32(v & mask) / f32(mask) * (range.y - range.x);
+}
+
+inline u32 PackColor(const vec4& c) { return PackUnorm(c.x, 8) | PackUnorm(c.y, 8) << 8 | PackUnorm(c.z, 8) << 16 | PackUnorm(c.w, 8) << 24; }
+
+inline vec4 UnpackColor(u32 c) { return { UnpackUnorm(c, 8), UnpackUnorm(c >> 8, 8), UnpackUnorm(c >> 16, 8), UnpackUnorm(c >> 24, 8) }; }
+
+inline PackedGridInstanceData Pack(const GridInstanceData& in) {
+    using P = PackedGridInstanceData;
+
+    const f32 cycles = QuantizeAnimationFrequency(std::max(in.glowPulse.y, 0.f)) * f32(AnimationTimePeriod);
+    const u32 frequency = std::min(u32(std::lround(cycles)), P::MaxFrequencyCycles);
+    const f32 phase = std::fmod(in.glowPulse.z, 2.f * std::numbers::pi_v<f32>) / (2.f * std::numbers::pi_v<f32>);
+
+    return {
+        .pos = PackUnorm(in.posDims.x, 16, P::PositionRange) | PackUnorm(in.posDims.y, 16, P::PositionRange) << 16,
+        .dims = PackUnorm(in.posDims.z, 16, P::DimensionsRange) | PackUnorm(in.posDims.w, 16, P::DimensionsRange) << 16,
+        .slots = std::min(in.atlasSlot, 0xFFFFu) | u32(std::clamp(in.number, 0, 0xFFFF)) << 16,
+        .tint = PackColor(in.tint),
+        .borderColor = PackColor(in.borderColor),
+        .glowColor = PackColor(in.glowColor),
+        .sizes = PackUnorm(in.glowSize, 16, P::GlowSizeRange) | PackUnorm(in.borderThickness, 16, P::BorderThicknessRange) << 16,
+        .pulse = PackUnorm(in.glowPulse.x, 8) | PackUnorm(phase < 0.f ? phase + 1.f : phase, 8) << 8 | frequency << 16 |
+                 (in.highlight ? P::HighlightBit : 0u),
+    };
+}
+
+// Reference for the unpacking done in Grids.hlsl
+inline GridInstanceData Unpack(const PackedGridInstanceData& in) {
+    using P = PackedGridInstanceData;
+
+    GridInstanceData out;
+    out.posDims = { UnpackUnorm(in.pos, 16, P::PositionRange), UnpackUnorm(in.pos >> 16, 16, P::PositionRange),
+                    UnpackUnorm(in.dims, 16, P::DimensionsRange), UnpackUnorm(in.dims >> 16, 16, P::DimensionsRange) };
+    out.atlasSlot = in.slots & 0xFFFF;
+    out.number = i32(in.slots >> 16);
+    out.tint = UnpackColor(in.tint);
+    out.borderColor = UnpackColor(in.borderColor);
+    out.glowColor = UnpackColor(in.glowColor);
+    out.glowSize = UnpackUnorm(in.sizes, 16, P::GlowSizeRange);
+    out.borderThickness = UnpackUnorm(in.sizes >> 16, 16, P::BorderThicknessRange);
+    out.glowPulse = { UnpackUnorm(in.pulse, 8), f32((in.pulse >> 16) & P::MaxFrequencyCycles) / f32(AnimationTimePeriod),
+                      UnpackUnorm(in.pulse >> 8, 8) * 2.f * std::numbers::pi_v<f32> };
+    out.highlight = (in.pulse & P::HighlightBit) != 0;
+    return out;
+}
+
+} // namespace GW2Clarity
@@ -1,35 +1,53 @@
 #pragma once
 
 #include "Buffs.h"
+#include "GridBufferPolicy.h"
+#include "GridEvaluation.h"
+#include "GridInstance.h"
 #include "Graphics.h"
 #include "ShaderManager.h"
 
 namespace GW2Clarity
 {
-struct GridInstanceData
-{
-    vec4 posDims;
-    vec2 uv;
-    vec2 numberUV;
-    vec4 tint;
-    vec4 borderColor;
-    vec4 glowColor;
-    vec2 glowSize;
-    f32 borderThickness;
-    i32 showNumber;
-};
-
 class BaseGridRenderer
 {
-    using InstanceData = GridInstanceData;
+    using InstanceData = PackedGridInstanceData;
 
 public:
     BaseGridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs, size_t sz);
 
+    struct Stats
+    {
+        size_t highWaterMark = 0;
+        size_t capacity = 0;
+        u32 batches = 0;
+    };
+
+    [[nodiscard]] const Stats& stats() const { return stats_; }
+
 protected:
-    void Draw(ComPtr<ID3D11DeviceContext>& ctx, std::span<InstanceData> data, bool betterFiltering, RenderTarget* rt, bool expandVS);
+    // Uploads data unless upload is false, in which case the previously uploaded instances are drawn again
+    void Draw(ComPtr<ID3D11DeviceContext>& ctx, std::span<const InstanceData> data, bool upload, bool betterFiltering, RenderTarget* rt,
+              bool expandVS);
+
+    void CreateInstanceBuffer(size_t capacity);
+
+    // Binds every resource shared by the grid shaders, returning the previous viewport to be restored by EndDraw() when drawing to rt
+    D3D11_VIEWPORT BeginDraw(ComPtr<ID3D11DeviceContext>& ctx, ShaderId vs, bool betterFiltering, RenderTarget* rt);
+    void EndDraw(ComPtr<ID3D11DeviceContext>& ctx, RenderTarget* rt, const D3D11_VIEWPORT& oldVP);
+
+    struct StructuredBuffer
+    {
+        ComPtr<ID3D11Buffer> buffer;
+        ComPtr<ID3D11ShaderResourceView> srv;
+        size_t capacity = 0;
+    };
+
+    // Immutable when data is provided, dynamic otherwise
+    void CreateStructuredBuffer(StructuredBuffer& buffer, size_t stride, size_t capacity, const void* data);
 
     const Buffs* buffs_;
+    ComPtr<ID3D11Device> device_;
 
     ShaderId screenSpaceVS_;
     ShaderId screenSpaceNoExpandVS_;
@@ -45,42 +63,95 @@ protected:
     };
     ConstantBufferSPtr<GridConstants> gridCB_;
 
-    ComPtr<ID3D11Buffer> instanceBuffer_;
-    ComPtr<ID3D11ShaderResourceView> instanceBufferView_;
+    StructuredBuffer instanceBuffer_;
     ComPtr<ID3D11BlendState> defaultBlend_;
     ComPtr<ID3D11SamplerState> defaultSampler_;
 
-    size_t bufferSize_;
+    size_t uploadedCount_ = 0;
+    Stats stats_;
 };
 
+// N is the initial capacity, the renderer grows as needed
 template<size_t N>
 class GridRenderer : public BaseGridRenderer
 {
-    using InstanceData = GridInstanceData;
+    using InstanceData = PackedGridInstanceData;
 
 public:
-    GridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs) : BaseGridRenderer(dev, buffs, N) { }
+    GridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs) : BaseGridRenderer(dev, buffs, N) { instances_.reserve(N); }
     GridRenderer(const GridRenderer&) = delete;
     GridRenderer(GridRenderer&&) = delete;
     GridRenderer& operator=(const GridRenderer&) = delete;
     GridRenderer& operator=(GridRenderer&&) = delete;
     ~GridRenderer() = default;
 
-    void Add(InstanceData&& data) {
-        if(instanceBufferCount_ >= instanceBufferSize_s)
-            return;
+    void Add(const GridInstanceData& data) {
+        BeginFrame();
+        instances_.push_back(Pack(data));
+    }
 
-        instanceBufferSource_[instanceBufferCount_++] = std::move(data);
+    void Add(std::span<const InstanceData> data) {
+        BeginFrame();
+        instances_.insert(instances_.end(), data.begin(), data.end());
     }
 
     void Draw(ComPtr<ID3D11DeviceContext>& ctx, bool betterFiltering, RenderTarget* rt = nullptr, bool expandVS = true) {
-        BaseGridRenderer::Draw(ctx, std::span { instanceBufferSource_.begin(), instanceBufferCount_ }, betterFiltering, rt, expandVS);
-        instanceBufferCount_ = 0;
+        BeginFrame();
+        BaseGridRenderer::Draw(ctx, instances_, true, betterFiltering, rt, expandVS);
+        drawn_ = true;
     }
 
+    // Draws the instances uploaded by the last call to Draw() again, only touching the instance buffer if they needed several batches
+    void Redraw(ComPtr<ID3D11DeviceContext>& ctx, bool betterFiltering, RenderTarget* rt = nullptr, bool expandVS = true) {
+        BaseGridRenderer::Draw(ctx, instances_, stats_.batches > 1, betterFiltering, rt, expandVS);
+    }
+
+protected:
+    // Instances are kept after drawing so they can be redrawn, the first Add() or Draw() afterwards starts over
+    void BeginFrame() {
+        if(drawn_) {
+            instances_.clear();
+            drawn_ = false;
+        }
+    }
+
+    std::vector<InstanceData> instances_;
+    bool drawn_ = false;
+};
+
+// Draws grid items evaluated by the vertex shader: items, stack sources and style appearances are static and only uploaded when they
+// change, leaving the buff counts and grid origins as the only per-frame uploads. See EvaluateGridItem() for the CPU equivalent.
+class EvaluatedGridRenderer : public BaseGridRenderer
+{
+public:
+    EvaluatedGridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs);
+
+    void SetItems(std::span<const GridItemData> items, std::span<const u32> stackSources);
+    void SetAppearances(std::span<const PackedGridAppearanceInterval> appearances);
+
+    // Counts are only uploaded when their generation differs from the last upload
+    void Draw(ComPtr<ID3D11DeviceContext>& ctx, const ActiveBuffsTable& activeBuffs, std::span<const vec2> gridOrigins, bool betterFiltering);
+
 protected:
-    static constexpr size_t instanceBufferSize_s = N;
-    std::array<InstanceData, instanceBufferSize_s> instanceBufferSource_ {};
-    u32 instanceBufferCount_ = 0;
+    template<typename T>
+    void Upload(ComPtr<ID3D11DeviceContext>& ctx, StructuredBuffer& buffer, std::span<const T> data) {
+        if(data.size() > buffer.capacity)
+            CreateStructuredBuffer(buffer, sizeof(T), std::bit_ceil(data.size()), nullptr);
+
+        D3D11_MAPPED_SUBRESOURCE map;
+        ctx->Map(buffer.buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
+        memcpy_s(map.pData, buffer.capacity * sizeof(T), data.data(), data.size_bytes());
+        ctx->Unmap(buffer.buffer.Get(), 0);
+    }
+
+    ShaderId gridsEvaluatedVS_;
+
+    StructuredBuffer items_;
+    StructuredBuffer stackSources_;
+    StructuredBuffer appearances_;
+    StructuredBuffer counts_;
+    StructuredBuffer gridOrigins_;
+    size_t itemCount_ = 0;
+    std::optional<u64> uploadedCountsGeneration_;
 };
 } // namespace GW2Clarity
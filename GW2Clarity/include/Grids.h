@@ -4,9 +4,12 @@
 
 #include "ActivationKeybind.h"
 #include "Buffs.h"
+#include "GridConfig.h"
 #include "GridRenderer.h"
+#include "LabelCache.h"
 #include "Layouts.h"
 #include "Main.h"
+#include "PersistedOption.h"
 #include "SettingsMenu.h"
 #include "Styles.h"
 
@@ -17,7 +20,7 @@ class Grids : public SettingsMenu::Implementer
     using Style = Styles::Style;
 
 public:
-    Grids(ComPtr<ID3D11Device>& dev, const Buffs* buffs, const Styles* styles);
+    Grids(ComPtr<ID3D11Device>& dev, const Buffs* buffs, const Styles* styles, const ConfigSource& config);
     Grids(const Grids&) = delete;
     Grids(Grids&&) = delete;
     Grids& operator=(const Grids&) = delete;
@@ -33,59 +36,29 @@ public:
     void StyleDeleted(u32 id);
 
 protected:
-    void Load();
+    void Load(const ConfigSource& config);
     void Save();
 
     void DrawEditingGrid();
     void DrawGridList();
+    void InvalidateLabels() {
+        gridLabels_.Invalidate();
+        itemLabels_.Invalidate();
+    }
     void DrawItems(ComPtr<ID3D11DeviceContext>& ctx, const Layouts::Layout* layout, bool shouldIgnoreLayout);
-
-    static inline constexpr ivec2 GridDefaultSpacing { 64, 64 };
-
-    struct Item
-    {
-        ivec2 pos { 0, 0 };
-        const Buff* buff = &Buffs::UnknownBuff;
-        u32 style = 0;
-        std::vector<const Buff*> additionalBuffs;
-    };
+    void CompileStackSources();
+    [[nodiscard]] GridMouseState mouseState(const vec2& mouse) const {
+        return { mouse, holdingMouseButton_ != ScanCode::None ? std::optional { vec2 { heldMousePos_.x, heldMousePos_.y } } : std::nullopt,
+                 testMouseMode_ };
+    }
+    void BuildEvaluatedItems(bool editMode);
+#ifdef _DEBUG
+    void VerifyEvaluation(const ActiveBuffsTable& activeBuffs, const vec2& screen, bool editMode);
+#endif
 
 public:
-    struct Grid
-    {
-        std::string name { "New Grid" };
-        ivec2 spacing = GridDefaultSpacing;
-        ivec2 offset = {};
-        f32 centralWeight = 0.f;
-        ivec2 mouseClipMin { std::numeric_limits<i32>::max() };
-        ivec2 mouseClipMax { std::numeric_limits<i32>::min() };
-        bool trackMouseWhileHeld = true;
-        std::vector<Item> items;
-        bool attached = false;
-        bool square = true;
-
-        auto ComputeOrigin(const Grids& grids, bool editMode, const vec2& screen, const vec2& mouse) const {
-            vec2 gridOrigin;
-            if(!attached || (editMode && !grids.testMouseMode_))
-                gridOrigin = screen * 0.5f + vec2(offset);
-            else {
-                if(!trackMouseWhileHeld && grids.holdingMouseButton_ != ScanCode::None)
-                    gridOrigin = vec2 { grids.heldMousePos_.x, grids.heldMousePos_.y };
-                else
-                    gridOrigin = mouse;
-
-                if(mouseClipMin.x != std::numeric_limits<i32>::max()) {
-                    gridOrigin = glm::max(gridOrigin, vec2(mouseClipMin));
-                    gridOrigin = glm::min(gridOrigin, vec2(mouseClipMax));
-                }
-
-                if(centralWeight > 0.f)
-                    gridOrigin = glm::mix(gridOrigin, screen * 0.5f, centralWeight);
-            }
-
-            return gridOrigin;
-        }
-    };
+    using Item = GridItem;
+    using Grid = GW2Clarity::Grid;
 
     [[nodiscard]] const std::vector<Grid>& grids() const { return grids_; }
 
@@ -121,9 +94,65 @@ protected:
     const Buffs* buffs_;
     const Styles* styles_;
     GridRenderer<1024> gridRenderer_;
+    EvaluatedGridRenderer evaluatedRenderer_;
     Id currentHovered_ = Unselected();
 
+    // Labels of the grid list and of the selected grid's item list, rebuilt after any edit
+    LabelCache gridLabels_;
+    LabelCache itemLabels_;
+    i16 itemLabelsGrid_ = UnselectedSubId;
+    // Kept alive for the deletion popup, which only views it
+    std::string deletionTail_;
+
     std::vector<Grid> grids_;
+    std::vector<u32> stackSources_;
+    GridDependencyIndex dependencies_;
+    bool stackSourcesDirty_ = true;
+
+    struct GridInstanceCache
+    {
+        std::vector<PackedGridInstanceData> instances;
+        vec2 origin {};
+        bool dirty = true;
+    };
+
+    // Anything which invalidates every cached grid at once. Buff changes only invalidate the items depending on them, see
+    // instanceBuffsGeneration_.
+    struct InstanceCacheKey
+    {
+        u64 stylesGeneration = 0;
+        u64 gridsGeneration = 0;
+        vec2 screen {};
+        Id selectedId = Unselected();
+
+        bool operator==(const InstanceCacheKey&) const = default;
+    };
+
+    std::vector<GridInstanceCache> instanceCaches_;
+    InstanceCacheKey instanceCacheKey_;
+    // Generation of the buffs table the cached instances reflect
+    u64 instanceBuffsGeneration_ = 0;
+    u64 gridsGeneration_ = 0;
+    std::vector<i16> drawnGrids_;
+    std::vector<i16> uploadedGrids_;
+
+    // Anything which requires rebuilding the static items used for GPU evaluation
+    struct EvaluationKey
+    {
+        u64 stylesGeneration = 0;
+        u64 gridsGeneration = 0;
+        Id selectedId = Unselected();
+        i32 editingCount = 0;
+        std::vector<i16> grids;
+
+        bool operator==(const EvaluationKey&) const = default;
+    };
+
+    std::vector<GridItemData> evaluatedItems_;
+    std::vector<PackedGridAppearanceInterval> evaluatedAppearances_;
+    std::vector<vec2> evaluatedOrigins_;
+    std::optional<EvaluationKey> evaluationKey_;
+    std::optional<u64> evaluatedStylesGeneration_;
 
     Id selectedId_ = Unselected();
 
@@ -139,13 +168,15 @@ protected:
     ScanCode holdingMouseButton_ = ScanCode::None;
     ImVec2 heldMousePos_ {};
 
-    ConfigurationOption<bool> enableBetterFiltering_;
+    PersistedOption<bool> enableBetterFiltering_;
+    PersistedOption<bool> enableGpuEvaluation_;
 
     static constexpr i32 InvisibleWindowFlags = ImGuiWindowFlags_NoDecoration | ImGuiWindowFlags_NoBackground | ImGuiWindowFlags_NoInputs |
                                                 ImGuiWindowFlags_NoNav | ImGuiWindowFlags_NoScrollWithMouse;
 
 #ifdef _DEBUG
     std::string debugGridFilter_;
+    bool verifyEvaluation_ = false;
 #endif
 };
 } // namespace GW2Clarity
@@ -0,0 +1,41 @@
+#pragma once
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Labels of a settings list, formatted once and kept until invalidated so that drawing the list every frame neither formats nor
+// allocates. Labels are stored back to back in a single buffer, each followed by a null character, and the buffers keep their capacity
+// across rebuilds.
+class LabelCache
+{
+public:
+    void Invalidate() { valid_ = false; }
+
+    // Rebuilds every label if the cache was invalidated or the list changed size, build(i, out) appending label i to out
+    template<typename F>
+    void Update(size_t count, F&& build) {
+        if(valid_ && offsets_.size() == count)
+            return;
+
+        text_.clear();
+        offsets_.clear();
+        for(size_t i = 0; i < count; i++) {
+            offsets_.push_back(u32(text_.size()));
+            build(i, text_);
+            text_.push_back('\0');
+        }
+        valid_ = true;
+    }
+
+    [[nodiscard]] size_t size() const { return offsets_.size(); }
+    [[nodiscard]] const char* operator[](size_t i) const { return text_.data() + offsets_[i]; }
+
+protected:
+    std::string text_;
+    std::vector<u32> offsets_;
+    bool valid_ = false;
+};
+
+} // namespace GW2Clarity
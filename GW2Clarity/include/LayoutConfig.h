@@ -0,0 +1,21 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+struct Layout
+{
+    std::string name;
+    std::set<i32> grids;
+    bool combatOnly = false;
+};
+
+// Reads the "buff_layouts" array, dropping references to grids past gridCount
+[[nodiscard]] std::vector<Layout> LoadLayouts(const nlohmann::json& layouts, size_t gridCount);
+[[nodiscard]] nlohmann::json SaveLayouts(std::span<const Layout> layouts);
+
+} // namespace GW2Clarity
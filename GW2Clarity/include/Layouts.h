@@ -1,7 +1,10 @@
 #pragma once
 
 #include "ActivationKeybind.h"
+#include "ConfigSnapshot.h"
+#include "LayoutConfig.h"
 #include "Main.h"
+#include "PersistedOption.h"
 #include "SettingsMenu.h"
 
 namespace GW2Clarity
@@ -12,7 +15,7 @@ class Grids;
 class Layouts : public SettingsMenu::Implementer
 {
 public:
-    Layouts(ComPtr<ID3D11Device>& dev, Grids* grids);
+    Layouts(ComPtr<ID3D11Device>& dev, Grids* grids, const ConfigSource& config);
     virtual ~Layouts();
 
     void Draw(ComPtr<ID3D11DeviceContext>& ctx);
@@ -24,16 +27,11 @@ public:
     void GridDeleted(Id id);
 
 protected:
-    void Load(size_t gridCount);
+    void Load(const ConfigSource& config, size_t gridCount);
     void Save();
 
 public:
-    struct Layout
-    {
-        std::string name;
-        std::set<i32> grids;
-        bool combatOnly = false;
-    };
+    using Layout = GW2Clarity::Layout;
 
     const std::vector<Layout>& sets() const { return layouts_; }
 
@@ -61,7 +59,7 @@ protected:
     bool firstDraw_ = true;
 
     ActivationKeybind changeGridLayoutKey_;
-    ConfigurationOption<bool> rememberLayout_;
-    ConfigurationOption<i16> rememberedLayoutId_;
+    PersistedOption<bool> rememberLayout_;
+    PersistedOption<i16> rememberedLayoutId_;
 };
 } // namespace GW2Clarity
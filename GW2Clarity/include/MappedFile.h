@@ -0,0 +1,33 @@
+#pragma once
+
+#include <filesystem>
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Read-only memory mapping of a whole file
+class MappedFile
+{
+public:
+    // Returns nothing if the file does not exist or could not be mapped. Empty files cannot be mapped.
+    [[nodiscard]] static std::optional<MappedFile> Open(const std::filesystem::path& path);
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile();
+
+    [[nodiscard]] std::span<const std::byte> data() const { return { data_, size_ }; }
+
+protected:
+    MappedFile(const std::byte* data, size_t size) : data_(data), size_(size) { }
+    void Close();
+
+    const std::byte* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+} // namespace GW2Clarity
@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ConfigJson.h"
+#include "ConfigPersistence.h"
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Option stored in the configuration document as key of the category object, like GW2Common's ConfigurationOption, but saved through
+// ConfigPersistence so that changing it neither writes the file on the render thread nor races the background writes
+template<typename T>
+class PersistedOption
+{
+public:
+    PersistedOption(ConfigPersistence& persistence, std::string displayName, std::string key, std::string category, const T& defaultValue)
+        : persistence_(persistence), displayName_(std::move(displayName)), key_(std::move(key)), category_(std::move(category)),
+          value_(ReadOr(ConfigSection(persistence.document(), category_.c_str()), key_.c_str(), defaultValue)) { }
+
+    [[nodiscard]] const T& value() const { return value_; }
+    void value(const T& value) {
+        if(value == value_)
+            return;
+
+        value_ = value;
+        persistence_.Set(category_, key_, value_);
+    }
+
+    [[nodiscard]] const std::string& displayName() const { return displayName_; }
+
+protected:
+    ConfigPersistence& persistence_;
+    std::string displayName_;
+    std::string key_;
+    std::string category_;
+    T value_;
+};
+
+} // namespace GW2Clarity
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <iosfwd>
+#include <mutex>
+
+#include "Main.h"
+
+// Scoped timers for the addon's hot paths. Define GW2CLARITY_PROFILING to enable them; otherwise GW2_PROFILE_SCOPE expands to nothing
+// and the profiler is not compiled at all.
+#ifdef GW2CLARITY_PROFILING
+#define GW2_PROFILE_CONCAT_INNER(a, b) a##b
+#define GW2_PROFILE_CONCAT(a, b) GW2_PROFILE_CONCAT_INNER(a, b)
+#define GW2_PROFILE_SCOPE(name)                                                                                           \
+    static const u16 GW2_PROFILE_CONCAT(profileScope_, __LINE__) = ::GW2Clarity::Profiler::RegisterScope(name); \
+    const ::GW2Clarity::ScopedTimer GW2_PROFILE_CONCAT(profileTimer_, __LINE__)(GW2_PROFILE_CONCAT(profileScope_, __LINE__))
+#else
+#define GW2_PROFILE_SCOPE(name) ((void)0)
+#endif
+
+#ifdef GW2CLARITY_PROFILING
+namespace GW2Clarity
+{
+
+struct ProfileEvent
+{
+    // Nanoseconds since the profiler started
+    u64 start;
+    u32 duration;
+    u16 scope;
+};
+
+struct ProfileScopeStats
+{
+    std::string_view name;
+    size_t calls;
+    u64 p50, p99, max, total;
+};
+
+// Every thread records its events into its own ring buffer, without locking. Readers copy the rings and discard any event the owning
+// thread may have overwritten while they were copying.
+class Profiler
+{
+public:
+    // Only the most recent events are kept, per thread
+    static inline constexpr size_t RingCapacity = 1 << 14;
+
+    // Thread-safe, called once per GW2_PROFILE_SCOPE
+    static u16 RegisterScope(const char* name);
+
+    static void Record(u16 scope, u64 start, u64 end) {
+        ThreadRing& ring = LocalRing();
+        const u64 written = ring.written.load(std::memory_order_relaxed);
+        ring.events[written & (RingCapacity - 1)] = { start, u32(std::min<u64>(end - start, std::numeric_limits<u32>::max())), scope };
+        ring.written.store(written + 1, std::memory_order_release);
+    }
+
+    [[nodiscard]] static u64 Now() {
+        return u64(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - Epoch).count());
+    }
+
+    // Statistics of every scope over the events currently held, in registration order
+    static void ComputeStats(std::vector<ProfileScopeStats>& stats);
+
+    // Writes the events currently held in the Chrome trace event format, for chrome://tracing or Perfetto
+    static void ExportChromeTrace(std::ostream& out);
+
+protected:
+    struct ThreadRing
+    {
+        std::array<ProfileEvent, RingCapacity> events;
+        std::atomic<u64> written { 0 };
+        u32 index = 0;
+    };
+
+    static ThreadRing& LocalRing() {
+        thread_local ThreadRing* ring = nullptr;
+        if(!ring)
+            ring = &RegisterThread();
+        return *ring;
+    }
+    static ThreadRing& RegisterThread();
+
+    // Calls f(threadIndex, event) for every consistent event held by any thread
+    template<typename F>
+    static void ForEachEvent(F&& f);
+
+    static inline const std::chrono::steady_clock::time_point Epoch = std::chrono::steady_clock::now();
+
+    // Guards registration, rings are never freed so that threads can keep their pointer without locking
+    static inline std::mutex mutex_;
+    static inline std::vector<std::string> scopes_;
+    static inline std::vector<std::unique_ptr<ThreadRing>> rings_;
+};
+
+class ScopedTimer
+{
+public:
+    explicit ScopedTimer(u16 scope) : scope_(scope), start_(Profiler::Now()) { }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+    ~ScopedTimer() { Profiler::Record(scope_, start_, Profiler::Now()); }
+
+private:
+    u16 scope_;
+    u64 start_;
+};
+
+} // namespace GW2Clarity
+#endif
@@ -0,0 +1,35 @@
+#pragma once
+
+#ifdef GW2CLARITY_PROFILING
+
+#include "Main.h"
+#include "Profiler.h"
+#include "SettingsMenu.h"
+
+namespace GW2Clarity
+{
+
+// Settings tab listing how long each profiled scope takes, to tell how much frame time the addon costs
+class ProfilerMenu : public SettingsMenu::Implementer
+{
+public:
+    ProfilerMenu();
+    ~ProfilerMenu();
+
+    void DrawMenu(Keybind** currentEditedKeybind) override;
+
+    [[nodiscard]] const char* GetTabName() const override { return "Profiler"; }
+
+protected:
+    void Export();
+
+    std::vector<ProfileScopeStats> stats_;
+    mstime lastRefreshTime_ = 0;
+    std::string lastExportPath_;
+
+    static inline constexpr mstime RefreshDelay = 500;
+};
+
+} // namespace GW2Clarity
+
+#endif
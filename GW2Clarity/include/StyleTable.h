@@ -0,0 +1,228 @@
+#pragma once
+
+#include <nlohmann/json.hpp>
+#include <range/v3/all.hpp>
+
+#include "GridEvaluation.h"
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Style definitions and their compiled threshold lookup, independent of the settings UI
+class StyleTable
+{
+public:
+    struct Appearance
+    {
+        vec4 tint { 1, 1, 1, 1 };
+        vec4 border { 0 };
+        vec4 glow { 0 };
+        f32 borderThickness = 0.f;
+        f32 glowSize = 0.f;
+        vec2 glowPulse { 0 };
+
+        bool operator==(const Appearance&) const = default;
+    };
+
+    struct Threshold
+    {
+        u32 thresholdMin = 0;
+        u32 thresholdMax = 0;
+
+        Appearance appearance {};
+    };
+
+    struct ThresholdBuilder
+    {
+        using S = ThresholdBuilder&;
+
+        Threshold t {};
+
+        operator Threshold() const { return t; }
+
+        S min(u32 min) {
+            t.thresholdMin = min;
+            return *this;
+        }
+
+        S max(u32 max) {
+            t.thresholdMax = max;
+            return *this;
+        }
+
+        S tint(f32 rgb, f32 a) {
+            t.appearance.tint = vec4(rgb, rgb, rgb, a);
+            return *this;
+        }
+
+        S tint(f32 r, f32 g, f32 b, f32 a) {
+            t.appearance.tint = vec4(r, g, b, a);
+            return *this;
+        }
+
+        S border(f32 rgb, f32 a) {
+            t.appearance.border = vec4(rgb, rgb, rgb, a);
+            return *this;
+        }
+
+        S border(f32 r, f32 g, f32 b, f32 a) {
+            t.appearance.border = vec4(r, g, b, a);
+            return *this;
+        }
+
+        S glow(f32 rgb, f32 a) {
+            t.appearance.glow = vec4(rgb, rgb, rgb, a);
+            return *this;
+        }
+
+        S glow(f32 r, f32 g, f32 b, f32 a) {
+            t.appearance.glow = vec4(r, g, b, a);
+            return *this;
+        }
+
+        S borderThickness(f32 borderThickness) {
+            t.appearance.borderThickness = borderThickness;
+            return *this;
+        }
+
+        S glowSize(f32 glowSize) {
+            t.appearance.glowSize = glowSize;
+            return *this;
+        }
+
+        S glowPulse(const vec2& glowPulse) {
+            t.appearance.glowPulse = glowPulse;
+            return *this;
+        }
+
+        auto build() const { return t; }
+    };
+
+    struct Style
+    {
+        inline static const std::string BuiltInPrefix = "[Default] ";
+
+        Style() = default;
+        Style(Style&&) = default;
+
+        Style(const Style& s) : builtIn(false), thresholds(s.thresholds), breakpoints(s.breakpoints), appearances(s.appearances) {
+            if(s.name.starts_with(BuiltInPrefix))
+                name = s.name.substr(BuiltInPrefix.size());
+            else
+                name = s.name;
+        }
+
+        Style(std::string_view name) : name(name) { }
+
+        Style(std::string_view name, auto&&... thresholds)
+            : name(BuiltInPrefix + std::string(name)), thresholds(std::initializer_list<Threshold> { thresholds... }), builtIn(true) { }
+
+        Style& operator=(const Style& s) {
+            GW2_ASSERT(!builtIn);
+
+            if(s.name.starts_with(BuiltInPrefix))
+                name = s.name.substr(BuiltInPrefix.size());
+            else
+                name = s.name;
+
+            thresholds = s.thresholds;
+            breakpoints = s.breakpoints;
+            appearances = s.appearances;
+
+            return *this;
+        }
+
+        Style& operator=(Style&& s) {
+            GW2_ASSERT(builtIn == s.builtIn);
+
+            std::swap(name, s.name);
+            std::swap(thresholds, s.thresholds);
+            std::swap(breakpoints, s.breakpoints);
+            std::swap(appearances, s.appearances);
+            std::swap(tableRow, s.tableRow);
+
+            return *this;
+        }
+
+        std::string name;
+        const bool builtIn = false;
+
+        std::vector<Threshold> thresholds;
+
+        // Thresholds compiled by BuildCache into sorted, non-overlapping intervals: counts from breakpoints[i] up to
+        // breakpoints[i + 1] - 1 (or any higher count for the last one) use palette entry appearances[i]. The first breakpoint is always 0.
+        std::vector<u32> breakpoints { 0 };
+        std::vector<u16> appearances { 0 };
+        // First row of this style in the GPU appearance table
+        u32 tableRow = 0;
+
+        [[nodiscard]] u16 Lookup(u32 count) const {
+            // Most styles have a handful of breakpoints, a linear scan beats a binary search there
+            if(breakpoints.size() <= LinearLookupMax) {
+                size_t i = 0;
+                for(size_t j = 1; j < breakpoints.size(); j++)
+                    i += count >= breakpoints[j];
+                return appearances[i];
+            }
+
+            return appearances[std::distance(breakpoints.begin(), ranges::upper_bound(breakpoints, count)) - 1];
+        }
+
+        static inline constexpr size_t LinearLookupMax = 8;
+    };
+
+    [[nodiscard]] const auto& styles() const { return styles_; }
+
+    [[nodiscard]] const Style& style(u32 id) const { return id < styles_.size() ? styles_[id] : styles_[0]; }
+
+    [[nodiscard]] u32 FindStyle(const std::string& name) const {
+        auto it = ranges::find_if(styles_, [&](const auto& s) { return s.name == name; });
+        if(it != styles_.end())
+            return u32(std::distance(styles_.begin(), it));
+        else
+            return 0;
+    }
+
+    void ApplyStyle(u32 id, i32 count, GridInstanceData& out) const;
+
+    [[nodiscard]] const Appearance& appearance(u32 id, i32 count) const {
+        if(id >= styles_.size() || count < 0)
+            return palette_[0];
+        return palette_[styles_[id].Lookup(u32(count))];
+    }
+
+    // Every style's compiled intervals, as produced by ApplyStyle. Row 0 is the default appearance, style s spans
+    // AppearanceRowCount(s) rows from AppearanceTableRow(s).
+    void BuildAppearanceTable(std::vector<PackedGridAppearanceInterval>& table) const;
+    [[nodiscard]] u32 AppearanceTableRow(u32 id) const { return id < styles_.size() ? styles_[id].tableRow : 0; }
+    [[nodiscard]] u32 AppearanceRowCount(u32 id) const { return id < styles_.size() ? u32(styles_[id].breakpoints.size()) : 1; }
+
+    // Incremented whenever style appearances change
+    [[nodiscard]] u64 generation() const { return generation_; }
+
+    // Replaces every style with the built-in styles followed by the ones in the given "styles" array or list, then compiles them
+    void LoadStyles(const nlohmann::json& styles);
+    void LoadStyles(std::vector<Style> userStyles);
+    // Serializes every style except the built-in ones into a "styles" array
+    [[nodiscard]] nlohmann::json SaveStyles() const { return SaveStyles(styles_); }
+    [[nodiscard]] static nlohmann::json SaveStyles(std::span<const Style> styles);
+
+protected:
+    // Recompiles every style and compacts the palette
+    void BuildCache();
+    // Recompiles a single style after an edit
+    void BuildCache(u32 id);
+    void CompileStyle(Style& s);
+    void UpdateTableRows();
+
+    std::vector<Style> styles_;
+    // Deduplicated appearances referenced by the compiled styles, entry 0 is the default appearance
+    std::vector<Appearance> palette_ { Appearance {} };
+    u64 generation_ = 0;
+
+    static inline constexpr size_t PaletteCompactionThreshold = 256;
+    // Highest stack count of any buff in the catalog
+    static inline constexpr u32 MaxThresholdCount = 1500;
+};
+} // namespace GW2Clarity
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "Main.h"
+
+namespace GW2Clarity
+{
+
+// Single producer, single consumer triple buffer. The writer fills back() and publishes it, the reader acquires the most recently
+// published buffer. Neither side ever blocks, allocates or observes a buffer the other side is using.
+template<typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+    explicit TripleBuffer(const T& init) : buffers_ { init, init, init } { }
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Writer side
+    [[nodiscard]] T& back() { return buffers_[backIndex_]; }
+
+    void Publish() {
+        u32 prev = shared_.exchange(backIndex_ | FreshBit, std::memory_order_acq_rel);
+        backIndex_ = prev & IndexMask;
+    }
+
+    // Reader side, the returned buffer remains valid and unchanged until the next call to Acquire()
+    const T& Acquire() {
+        if(shared_.load(std::memory_order_relaxed) & FreshBit) {
+            u32 prev = shared_.exchange(frontIndex_, std::memory_order_acq_rel);
+            frontIndex_ = prev & IndexMask;
+        }
+
+        return buffers_[frontIndex_];
+    }
+
+    [[nodiscard]] const T& front() const { return buffers_[frontIndex_]; }
+
+protected:
+    static inline constexpr u32 IndexMask = 0b011;
+    static inline constexpr u32 FreshBit = 0b100;
+
+    std::array<T, 3> buffers_ {};
+    alignas(64) u32 backIndex_ = 0;
+    alignas(64) std::atomic<u32> shared_ { 1 };
+    alignas(64) u32 frontIndex_ = 2;
+};
+
+} // namespace GW2Clarity
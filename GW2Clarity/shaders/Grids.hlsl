@@ -9,22 +9,170 @@ cbuffer Common : register(b0)
     float  time;
 };
 
+// Must match PackedGridInstanceData in GridInstance.h
+struct PackedInstanceData
+{
+    uint pos;
+    uint dims;
+    uint slots;
+    uint tint;
+    uint borderColor;
+    uint glowColor;
+    uint sizes;
+    uint pulse;
+};
+
 struct InstanceData
 {
     float4 posDims;
-    float2 uv;
-    float2 numberUV;
+    uint atlasSlot;
+    uint number;
     float4 tint;
     float4 borderColor;
     float4 glowColor;
-    float2 glowSize;
+    float glowSize;
     float borderThickness;
-    int   showNumber;
+    float3 glowPulse;
+    bool highlight;
 };
 
-StructuredBuffer<InstanceData> Instances : register(t0);
+// Must match GridAnimation.h
+static const float AnimationTimePeriod = 3600.f;
+// Close to the previous 2 rad/s while completing a whole number of turns per period
+static const float GlowSwirlFrequency = 1146.f / AnimationTimePeriod;
+
+static const float HighlightPulseFrequency = 1.f;
+static const float4 HighlightColor = float4(1.f, 0.f, 0.f, 1.f);
+
+float PulseWave(float frequency, float phase)
+{
+    return sin(frac(frequency * time) * 2.f * PI + phase) * 0.5f + 0.5f;
+}
+
+StructuredBuffer<PackedInstanceData> Instances : register(t0);
 Texture2D<float4> Atlas : register(t1);
 Texture2D<float4> Numbers : register(t2);
+StructuredBuffer<float2> AtlasUVs : register(t3);
+StructuredBuffer<float2> NumberUVs : register(t4);
+
+float2 UnpackUnorm16(uint v, float2 range)
+{
+    return range.x + float2(v & 0xFFFF, v >> 16) / 65535.f * (range.y - range.x);
+}
+
+float4 UnpackColor(uint c)
+{
+    return float4(c & 0xFF, (c >> 8) & 0xFF, (c >> 16) & 0xFF, c >> 24) / 255.f;
+}
+
+// Must match PackedGridAppearance in GridEvaluation.h
+struct PackedAppearance
+{
+    uint tint;
+    uint borderColor;
+    uint glowColor;
+    uint sizes;
+    uint pulse;
+};
+
+void UnpackAppearance(PackedAppearance p, inout InstanceData d)
+{
+    d.tint = UnpackColor(p.tint);
+    d.borderColor = UnpackColor(p.borderColor);
+    d.glowColor = UnpackColor(p.glowColor);
+    d.glowSize = UnpackUnorm16(p.sizes, float2(0.f, 10.f)).x;
+    d.borderThickness = UnpackUnorm16(p.sizes, float2(0.f, 512.f)).y;
+    d.glowPulse = float3((p.pulse & 0xFF) / 255.f, ((p.pulse >> 16) & 0x7FFF) / AnimationTimePeriod, ((p.pulse >> 8) & 0xFF) / 255.f * 2.f * PI);
+    d.highlight = (p.pulse & 0x80000000) != 0;
+}
+
+InstanceData Unpack(PackedInstanceData p)
+{
+    InstanceData d;
+    d.posDims = float4(UnpackUnorm16(p.pos, float2(-1.f, 2.f)), UnpackUnorm16(p.dims, float2(0.f, 2.f)));
+    d.atlasSlot = p.slots & 0xFFFF;
+    d.number = p.slots >> 16;
+
+    PackedAppearance a = { p.tint, p.borderColor, p.glowColor, p.sizes, p.pulse };
+    UnpackAppearance(a, d);
+    return d;
+}
+
+// Must match GridItemData in GridEvaluation.h
+struct ItemData
+{
+    float2 offset;
+    float2 dims;
+    uint grid;
+    uint firstStackSource;
+    uint stackSourceCount;
+    uint firstAppearance;
+    uint appearanceCount;
+    uint atlasSlot;
+    uint flags;
+    int fixedCount;
+};
+
+static const uint ItemShowNumber = 1;
+static const uint ItemEditing = 2;
+
+StructuredBuffer<ItemData> Items : register(t5);
+StructuredBuffer<uint> StackSources : register(t6);
+// Must match PackedGridAppearanceInterval in GridEvaluation.h
+struct AppearanceInterval
+{
+    uint minCount;
+    PackedAppearance appearance;
+};
+
+StructuredBuffer<AppearanceInterval> Appearances : register(t7);
+StructuredBuffer<int> Counts : register(t8);
+StructuredBuffer<float2> GridOrigins : register(t9);
+
+// GPU side of EvaluateGridItem() in GridEvaluation.h
+InstanceData Evaluate(uint instance)
+{
+    ItemData item = Items[instance];
+
+    int count = item.fixedCount;
+    if(!(item.flags & ItemEditing))
+    {
+        count = 0;
+        for(uint i = 0; i < item.stackSourceCount; i++)
+            count += Counts[StackSources[item.firstStackSource + i]];
+    }
+
+    InstanceData d;
+    d.posDims = float4((GridOrigins[item.grid] + item.offset) / screenSize.xy, item.dims / screenSize.xy);
+    d.atlasSlot = item.atlasSlot;
+    d.number = (item.flags & ItemShowNumber) && count > 1 ? min(uint(count), 0xFFFF) : 0;
+
+    // Intervals are sorted by minCount, styles only have a handful of them
+    uint row = 0;
+    if(count >= 0)
+    {
+        row = item.firstAppearance;
+        for(uint i = 1; i < item.appearanceCount && Appearances[item.firstAppearance + i].minCount <= uint(count); i++)
+            row = item.firstAppearance + i;
+    }
+    UnpackAppearance(Appearances[row].appearance, d);
+
+    if(item.flags & ItemEditing)
+    {
+        d.borderThickness = max(d.borderThickness, 1.f);
+        d.highlight = true;
+    }
+
+    return d;
+}
+
+float2 NumberUV(uint number)
+{
+    uint count, stride;
+    NumberUVs.GetDimensions(count, stride);
+    // 0 and 1 are not in the array, so 2 is at index 0
+    return number < 2 ? float2(0.f, 0.f) : NumberUVs[min(number - 2, count - 1)];
+}
 
 struct VS_OUT
 {
@@ -39,14 +187,14 @@ struct VS_OUT
     nointerpolation float  ShowNumber  : TEXCOORD7;
 };
 
-VS_OUT Base_VS(in uint instance, in uint id, in bool expand)
+VS_OUT Base_VS(in InstanceData data, in uint id, in bool expand)
 {
-    InstanceData data = Instances[instance];
     VS_OUT Out = (VS_OUT)0;
 
     float2 UV = float2(id & 1, id >> 1);
 
-    float2 glowSize = data.glowSize * 50000.f * screenSize.z;
+    float glowPulse = (1.f - data.glowPulse.x) + data.glowPulse.x * PulseWave(data.glowPulse.y, data.glowPulse.z);
+    float2 glowSize = float2(glowPulse, 1.f) * data.glowSize * 50000.f * screenSize.z;
 
 	float2 expandedDims = data.posDims.zw + 2.f * glowSize.xx * screenSize.zw;
     float2 dimsRatio = expandedDims / data.posDims.zw;
@@ -64,11 +212,11 @@ VS_OUT Base_VS(in uint instance, in uint id, in bool expand)
     Out.Position = float4((UV * 2 - 1) * expandedDims.xy + data.posDims.xy * 2 - 1, 0.5f, 1.f);
 	Out.Position.y *= -1;
 
-    Out.TexUVs = float4(data.uv, data.numberUV);
+    Out.TexUVs = float4(AtlasUVs[data.atlasSlot], NumberUV(data.number));
     Out.Tint = data.tint;
-    Out.BorderColor = data.borderColor;
+    Out.BorderColor = data.highlight ? lerp(data.borderColor, HighlightColor, PulseWave(HighlightPulseFrequency, 0.f)) : data.borderColor;
     Out.GlowColor = data.glowColor;
-    Out.ShowNumber = data.showNumber ? 1.f : 0.f;
+    Out.ShowNumber = data.number >= 2 ? 1.f : 0.f;
     Out.Border = float2(2.f * data.borderThickness / (data.posDims.zw * screenSize.xy));
 
     return Out;
@@ -76,12 +224,17 @@ VS_OUT Base_VS(in uint instance, in uint id, in bool expand)
 
 VS_OUT GridsNoExpand_VS(in uint instance : SV_InstanceID, in uint id : SV_VertexID)
 {
-    return Base_VS(instance, id, false);
+    return Base_VS(Unpack(Instances[instance]), id, false);
 }
 
 VS_OUT Grids_VS(in uint instance : SV_InstanceID, in uint id : SV_VertexID)
 {
-    return Base_VS(instance, id, true);
+    return Base_VS(Unpack(Instances[instance]), id, true);
+}
+
+VS_OUT GridsEvaluated_VS(in uint instance : SV_InstanceID, in uint id : SV_VertexID)
+{
+    return Base_VS(Evaluate(instance), id, true);
 }
 
 float4 MaybeFiltered(in Texture2D<float4> tex, in float2 uv, in bool filtered)
@@ -100,8 +253,8 @@ float glowShape(float2 d, float2 tuv)
 {
     d *= 2.f;
     float theta = atan2(d.y, d.x);
-    float rng = noise(float3(tuv * 1000.f + theta * 10.f, time * 1.f));
-    return dot(d, d) * saturate(0.1f * sin(theta * 12.f + 2 * time) * rng + 0.9f);
+    float rng = noisePeriodicZ(float3(tuv * 1000.f + theta * 10.f, time), AnimationTimePeriod);
+    return dot(d, d) * saturate(0.1f * sin(theta * 12.f + frac(GlowSwirlFrequency * time) * 2.f * PI) * rng + 0.9f);
 }
 
 float4 Grids(in VS_OUT In, bool filtered)
@@ -24,4 +24,20 @@ float noise( float3 x )
                    lerp( hash(n+57.0), hash(n+58.0),f.x),f.y),
                lerp(lerp( hash(n+113.0), hash(n+114.0),f.x),
                    lerp( hash(n+170.0), hash(n+171.0),f.x),f.y),f.z);
-}
\ No newline at end of file
+}
+
+// Same as noise(), but wraps around every period units along z (period must be an integer)
+float noisePeriodicZ( float3 x, float period )
+{
+    float3 p = floor(x);
+    float3 f = frac(x);
+
+    f       = f*f*(3.0-2.0*f);
+    float n0 = p.x + p.y*57.0 + 113.0*fmod(p.z, period);
+    float n1 = p.x + p.y*57.0 + 113.0*fmod(p.z + 1.0, period);
+
+    return lerp(lerp(lerp( hash(n0+0.0), hash(n0+1.0),f.x),
+                   lerp( hash(n0+57.0), hash(n0+58.0),f.x),f.y),
+               lerp(lerp( hash(n1+0.0), hash(n1+1.0),f.x),
+                   lerp( hash(n1+57.0), hash(n1+58.0),f.x),f.y),f.z);
+}
@@ -0,0 +1,75 @@
+#include "AllocationTracker.h"
+
+#ifdef GW2CLARITY_ALLOCATION_TRACKING
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+thread_local u64 t_AllocationCount = 0;
+}
+
+namespace
+{
+void* Allocate(size_t size) noexcept {
+    t_AllocationCount++;
+    return std::malloc(size ? size : 1);
+}
+} // namespace
+
+// Every replaceable form except the aligned ones is replaced together, so that memory always returns to the allocator it came from
+void* operator new(size_t size) {
+    if(void* p = Allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if(void* p = Allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+namespace GW2Clarity
+{
+
+u64 ThreadAllocationCount() {
+    return t_AllocationCount;
+}
+
+} // namespace GW2Clarity
+
+#endif
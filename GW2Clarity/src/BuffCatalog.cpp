@@ -0,0 +1,252 @@
+#include "BuffCatalog.h"
+
+#include <set>
+#include <unordered_set>
+
+namespace GW2Clarity
+{
+
+namespace
+{
+// Entry of BuffsList.inc, along with the name of the atlas entry holding its icon, which is only needed to resolve its UVs
+struct BuffDefinition
+{
+    Buff buff;
+    // Empty when the atlas entry is derived from the name, see Buff::AtlasEntryChar
+    std::string_view atlasEntry;
+
+    constexpr implicit BuffDefinition(std::string_view name) : buff(name) { }
+
+    constexpr BuffDefinition(u32 id, std::string_view name, i32 maxStacks = std::numeric_limits<i32>::max()) : buff(id, name, maxStacks) { }
+
+    constexpr BuffDefinition(u32 id, std::string_view name, std::string_view atlas, i32 maxStacks = std::numeric_limits<i32>::max())
+        : buff(id, name, maxStacks), atlasEntry(atlas) { }
+
+    constexpr BuffDefinition(std::initializer_list<u32> ids, std::string_view name, i32 maxStacks = std::numeric_limits<i32>::max())
+        : buff(ids, name, maxStacks) { }
+
+    constexpr BuffDefinition(std::initializer_list<u32> ids, std::string_view name, std::string_view atlas,
+                             i32 maxStacks = std::numeric_limits<i32>::max())
+        : buff(ids, name, maxStacks), atlasEntry(atlas) { }
+};
+
+#include "BuffsList.inc"
+
+struct AtlasElement
+{
+    std::string_view name;
+    AtlasUV uv;
+};
+
+// Sorted by name for lookups, the unnamed entry holding the UV size of an icon
+constexpr auto AtlasElements = [] {
+    auto elements = std::to_array<AtlasElement>({
+#include <assets/atlas.inc>
+    });
+    std::ranges::sort(elements, {}, &AtlasElement::name);
+    return elements;
+}();
+static_assert(AtlasElements.front().name.empty(), "The atlas table has no UV size entry");
+
+// Only the size entry exists when the atlas wasn't generated, in which case no buff has an icon
+constexpr bool AtlasPopulated = AtlasElements.size() > 1;
+
+constexpr size_t NotFound = std::numeric_limits<size_t>::max();
+
+// Compares an atlas entry name to the entry d uses, which is spelled out or derived from its name, in the order of string_view
+constexpr std::strong_ordering CompareAtlasEntry(std::string_view entry, const BuffDefinition& d) {
+    if(!d.atlasEntry.empty())
+        return entry <=> d.atlasEntry;
+
+    const std::string_view name = d.buff.name;
+    for(size_t i = 0; i < entry.size() && i < name.size(); i++)
+        if(auto c = u8(entry[i]) <=> u8(Buff::AtlasEntryChar(name[i])); c != 0)
+            return c;
+    return entry.size() <=> name.size();
+}
+
+constexpr const AtlasElement* FindAtlasElement(const BuffDefinition& d) {
+    const auto it = std::lower_bound(AtlasElements.begin(), AtlasElements.end(), d,
+                                     [](const AtlasElement& e, const BuffDefinition& d) { return CompareAtlasEntry(e.name, d) < 0; });
+    return it != AtlasElements.end() && CompareAtlasEntry(it->name, d) == 0 ? &*it : nullptr;
+}
+
+// Every primary and extra ID in catalog order, each listed once where it first appears. Their indices are the buff slots.
+constexpr std::vector<u32> CollectSlotIds() {
+    std::vector<std::pair<u32, size_t>> seen;
+    for(const auto& [b, atlasEntry] : g_Buffs) {
+        if(b.isCategory())
+            continue;
+        seen.emplace_back(b.id, seen.size());
+        for(u32 id : b.extraIds)
+            seen.emplace_back(id, seen.size());
+    }
+
+    std::ranges::sort(seen);
+    const auto duplicates = std::ranges::unique(seen, {}, &std::pair<u32, size_t>::first);
+    seen.erase(duplicates.begin(), duplicates.end());
+    std::ranges::sort(seen, {}, &std::pair<u32, size_t>::second);
+
+    std::vector<u32> ids;
+    for(const auto& [id, order] : seen)
+        ids.push_back(id);
+    return ids;
+}
+
+constexpr auto SlotIds = [] {
+    std::array<u32, CollectSlotIds().size()> ids;
+    std::ranges::copy(CollectSlotIds(), ids.begin());
+    return ids;
+}();
+
+constexpr auto SlotHashSizes = [] {
+    const auto hash = BuildSlotHash(SlotIds);
+    return std::pair { hash.displacements.size(), hash.entries.size() };
+}();
+
+constexpr auto SlotDisplacements = [] {
+    std::array<u32, SlotHashSizes.first> displacements;
+    std::ranges::copy(BuildSlotHash(SlotIds).displacements, displacements.begin());
+    return displacements;
+}();
+
+constexpr auto SlotEntries = [] {
+    std::array<BuffSlotMap::Entry, SlotHashSizes.second> entries;
+    std::ranges::copy(BuildSlotHash(SlotIds).entries, entries.begin());
+    return entries;
+}();
+
+constexpr BuffSlotMap CompiledSlots { SlotIds, SlotDisplacements, SlotEntries };
+
+// Atlas entries are dropped once resolved
+constexpr auto CatalogBuffs = [] {
+    auto buffs = [&]<size_t... I>(std::index_sequence<I...>) {
+        return std::array<Buff, g_Buffs.size()> { g_Buffs[I].buff... };
+    }(std::make_index_sequence<g_Buffs.size()>());
+
+    std::string_view category;
+    for(size_t i = 0; i < buffs.size(); i++) {
+        auto& b = buffs[i];
+        b.atlasSlot = u16(i + 1);
+        if(const auto* e = FindAtlasElement(g_Buffs[i]))
+            b.uv = e->uv;
+
+        if(b.isCategory()) {
+            category = b.name;
+            continue;
+        }
+
+        b.category = category;
+        b.slot = CompiledSlots[b.id];
+    }
+
+    return buffs;
+}();
+
+constexpr auto BuffsById = [] {
+    std::array<BuffIdIndex, std::ranges::count_if(g_Buffs, [](const BuffDefinition& d) { return !d.buff.isCategory(); })> byId;
+    size_t n = 0;
+    for(size_t i = 0; i < CatalogBuffs.size(); i++)
+        if(!CatalogBuffs[i].isCategory())
+            byId[n++] = { CatalogBuffs[i].id, u32(i) };
+    std::ranges::sort(byId, {}, &BuffIdIndex::id);
+    return byId;
+}();
+
+// The checks below evaluate to the index of the first offending buff, which compilers usually show when the assertion fails
+
+constexpr size_t FirstDuplicateId() {
+    const auto it = std::ranges::adjacent_find(BuffsById, {}, &BuffIdIndex::id);
+    return it != BuffsById.end() ? it[1].index : NotFound;
+}
+static_assert(FirstDuplicateId() == NotFound, "Two buffs share a primary ID");
+
+constexpr size_t FirstDuplicateName() {
+    std::array<std::pair<std::string_view, size_t>, CatalogBuffs.size()> names;
+    for(size_t i = 0; i < CatalogBuffs.size(); i++)
+        names[i] = { CatalogBuffs[i].name, i };
+    std::ranges::sort(names);
+    const auto it = std::ranges::adjacent_find(names, {}, &std::pair<std::string_view, size_t>::first);
+    return it != names.end() ? it[1].second : NotFound;
+}
+static_assert(FirstDuplicateName() == NotFound, "Two buffs share a name");
+
+constexpr size_t FirstMissingIcon() {
+    if(!AtlasPopulated)
+        return NotFound;
+    for(size_t i = 0; i < CatalogBuffs.size(); i++)
+        if(!CatalogBuffs[i].isCategory() && !FindAtlasElement(g_Buffs[i]))
+            return i;
+    return NotFound;
+}
+static_assert(FirstMissingIcon() == NotFound, "A buff has no atlas icon");
+
+constexpr BuffCatalog Catalog { CatalogBuffs, BuffsById, CompiledSlots, AtlasElements.front().uv };
+} // namespace
+
+const BuffCatalog& CompiledBuffCatalog() {
+    return Catalog;
+}
+
+namespace
+{
+// Heap blocks as assumed by EstimateLegacyFootprint
+size_t HeapBlock(size_t bytes) {
+    return ((bytes + 15) & ~size_t(15)) + 16;
+}
+
+size_t LegacyStringHeap(size_t length) {
+    // Short strings are stored inline
+    return length > std::string().capacity() ? HeapBlock(length + 1) : 0;
+}
+} // namespace
+
+BuffCatalogFootprint MeasureFootprint(const BuffCatalog& catalog) {
+    BuffCatalogFootprint f;
+    f.buffs = catalog.buffs().size_bytes();
+    f.lookups = catalog.byId().size_bytes() + catalog.slots().ids().size_bytes() + catalog.slots().displacements().size_bytes() +
+                catalog.slots().entries().size_bytes();
+
+    std::unordered_set<const char*> strings;
+    auto addString = [&](std::string_view s) {
+        if(strings.insert(s.data()).second)
+            f.strings += s.size() + 1;
+    };
+    for(const auto& b : catalog.buffs()) {
+        addString(b.name);
+        addString(b.category);
+    }
+
+    return f;
+}
+
+BuffCatalogFootprint EstimateLegacyFootprint(const BuffCatalog& catalog) {
+    struct LegacyBuff
+    {
+        u32 id;
+        i32 maxStacks;
+        std::string name;
+        std::string atlasEntry;
+        vec2 uv;
+        std::set<u32> extraIds;
+        std::string category;
+    };
+    // Three pointers, the color and the value
+    constexpr size_t SetNode = 4 * sizeof(void*) + sizeof(u32);
+    // Next pointer and the key-value pair
+    constexpr size_t MapNode = sizeof(void*) + sizeof(std::pair<const i32, const Buff*>);
+
+    BuffCatalogFootprint f;
+    f.buffs = catalog.buffs().size() * sizeof(LegacyBuff);
+    for(const auto& b : catalog.buffs()) {
+        f.strings += 2 * LegacyStringHeap(b.name.size()) + LegacyStringHeap(b.category.size());
+        f.extraIds += b.extraIds.size() * HeapBlock(SetNode);
+    }
+
+    const size_t mapped = catalog.byId().size();
+    f.lookups = std::bit_ceil(mapped) * sizeof(void*) + mapped * HeapBlock(MapNode);
+
+    return f;
+}
+
+} // namespace GW2Clarity
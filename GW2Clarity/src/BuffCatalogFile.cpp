@@ -0,0 +1,243 @@
+#include "BuffCatalogFile.h"
+
+#include <fstream>
+
+namespace GW2Clarity
+{
+
+namespace cat = BuffCatalogFormat;
+
+static_assert(std::is_trivially_copyable_v<cat::Header> && sizeof(cat::Header) == 72);
+static_assert(sizeof(cat::Buff) == 48);
+static_assert(std::is_trivially_copyable_v<BuffIdIndex> && sizeof(BuffIdIndex) == 8);
+static_assert(std::is_trivially_copyable_v<BuffSlotMap::Entry> && sizeof(BuffSlotMap::Entry) == 8);
+
+namespace
+{
+class CatalogBuilder
+{
+public:
+    explicit CatalogBuilder(const BuffCatalog& catalog) : catalog_(catalog) {
+        for(const auto& b : catalog.buffs()) {
+            cat::Buff r {};
+            r.id = b.id;
+            r.maxStacks = b.maxStacks;
+            r.name = AddString(b.name);
+            r.category = AddString(b.category);
+            r.uv[0] = b.uv.u;
+            r.uv[1] = b.uv.v;
+            r.firstExtraId = u32(extraIds.size());
+            extraIds.insert(extraIds.end(), b.extraIds.begin(), b.extraIds.end());
+            r.extraIdCount = u32(b.extraIds.size());
+            r.slot = b.slot;
+            r.atlasSlot = b.atlasSlot;
+            buffs.push_back(r);
+        }
+    }
+
+    cat::String AddString(std::string_view s) {
+        auto [it, inserted] = stringOffsets_.try_emplace(s, cat::String { u32(strings.size()), u32(s.size()) });
+        if(inserted) {
+            strings.insert(strings.end(), s.begin(), s.end());
+            strings.push_back('\0');
+        }
+        return it->second;
+    }
+
+    [[nodiscard]] std::string Serialize() const {
+        std::string out(sizeof(cat::Header), '\0');
+        cat::Header h {};
+        h.magic = cat::Magic;
+        h.version = cat::Version;
+        const vec2 uvSize = catalog_.atlasUVSize();
+        h.atlasUVSize[0] = uvSize.x;
+        h.atlasUVSize[1] = uvSize.y;
+        h.strings = Append(out, std::span(strings));
+        h.buffs = Append(out, std::span(buffs));
+        h.extraIds = Append(out, std::span(extraIds));
+        h.byId = Append(out, catalog_.byId());
+        h.slotIds = Append(out, catalog_.slots().ids());
+        h.slotDisplacements = Append(out, catalog_.slots().displacements());
+        h.slotEntries = Append(out, catalog_.slots().entries());
+        std::memcpy(out.data(), &h, sizeof(h));
+        return out;
+    }
+
+    std::vector<char> strings;
+    std::vector<cat::Buff> buffs;
+    std::vector<u32> extraIds;
+
+private:
+    // Every array starts on an 8-byte boundary
+    template<typename T>
+    static cat::Range Append(std::string& out, std::span<const T> values) {
+        out.resize((out.size() + 7) & ~size_t(7));
+        const cat::Range r { u32(out.size()), u32(values.size()) };
+        out.append(reinterpret_cast<const char*>(values.data()), values.size_bytes());
+        return r;
+    }
+
+    const BuffCatalog& catalog_;
+    std::unordered_map<std::string_view, cat::String> stringOffsets_;
+};
+
+template<typename T>
+bool Fits(cat::Range r, size_t size) {
+    return r.offset % alignof(T) == 0 && u64(r.offset) + u64(r.count) * sizeof(T) <= size;
+}
+
+template<typename T>
+std::span<const T> Array(std::span<const std::byte> data, cat::Range r) {
+    return { reinterpret_cast<const T*>(data.data() + r.offset), r.count };
+}
+} // namespace
+
+bool WriteBuffCatalogFile(const std::filesystem::path& path, const BuffCatalog& catalog) {
+    const std::string data = CatalogBuilder(catalog).Serialize();
+
+    auto temporaryPath = path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), std::streamsize(data.size()));
+        out.close();
+        if(out.fail()) {
+            LogError("Could not write buff catalog to '{}'.", temporaryPath.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporaryPath, path, ec);
+    if(ec) {
+        LogError("Could not replace buff catalog '{}': {}", path.string(), ec.message());
+        return false;
+    }
+
+    return true;
+}
+
+bool SameBuffCatalog(const BuffCatalog& a, const BuffCatalog& b) {
+    if(a.buffs().size() != b.buffs().size()) {
+        LogError("Catalogs have {} and {} buffs.", a.buffs().size(), b.buffs().size());
+        return false;
+    }
+    if(a.atlasUVSize() != b.atlasUVSize()) {
+        LogError("Catalogs have different atlas UV sizes.");
+        return false;
+    }
+
+    for(size_t i = 0; i < a.buffs().size(); i++) {
+        const Buff& x = a.buffs()[i];
+        const Buff& y = b.buffs()[i];
+        const bool same = x.id == y.id && x.maxStacks == y.maxStacks && x.name == y.name && x.category == y.category &&
+                          x.uv.u == y.uv.u && x.uv.v == y.uv.v && std::ranges::equal(x.extraIds, y.extraIds) && x.slot == y.slot &&
+                          x.atlasSlot == y.atlasSlot;
+        if(!same) {
+            LogError("Catalogs differ at buff {}: {} ({}) and {} ({}).", i, x.name, x.id, y.name, y.id);
+            return false;
+        }
+        // Categories share an ID and are never looked up
+        if(!x.isCategory() && (a.find(x.id) != &x || b.find(y.id) != &y)) {
+            LogError("Catalogs differ in looking up buff {} ({}).", x.name, x.id);
+            return false;
+        }
+    }
+
+    if(!std::ranges::equal(a.slots().ids(), b.slots().ids())) {
+        LogError("Catalogs assign different slots.");
+        return false;
+    }
+    for(u32 id : a.slots().ids())
+        if(a.slots()[id] != b.slots()[id]) {
+            LogError("Catalogs differ in looking up the slot of {}.", id);
+            return false;
+        }
+
+    return true;
+}
+
+std::optional<BuffCatalogFile> BuffCatalogFile::Open(const std::filesystem::path& path) {
+    auto file = MappedFile::Open(path);
+    if(!file)
+        return std::nullopt;
+
+    if(!Validate(file->data())) {
+        LogWarn("Ignoring damaged or outdated buff catalog '{}'.", path.string());
+        return std::nullopt;
+    }
+
+    const auto data = file->data();
+    const auto& h = *reinterpret_cast<const cat::Header*>(data.data());
+    const auto strings = Array<char>(data, h.strings);
+    const auto extraIds = Array<u32>(data, h.extraIds);
+    auto string = [&](cat::String s) { return std::string_view(strings.data() + s.offset, s.size); };
+
+    std::vector<Buff> buffs;
+    buffs.reserve(h.buffs.count);
+    for(const auto& r : Array<cat::Buff>(data, h.buffs)) {
+        Buff& b = buffs.emplace_back(r.id, string(r.name), r.maxStacks);
+        b.category = string(r.category);
+        b.uv = { r.uv[0], r.uv[1] };
+        b.extraIds = extraIds.subspan(r.firstExtraId, r.extraIdCount);
+        b.slot = r.slot;
+        b.atlasSlot = r.atlasSlot;
+    }
+
+    return BuffCatalogFile(std::move(*file), std::move(buffs), h);
+}
+
+BuffCatalogFile::BuffCatalogFile(MappedFile file, std::vector<Buff> buffs, const cat::Header& h)
+    : file_(std::move(file)), buffs_(std::move(buffs)),
+      catalog_(buffs_, Array<BuffIdIndex>(file_.data(), h.byId),
+               BuffSlotMap(Array<u32>(file_.data(), h.slotIds), Array<u32>(file_.data(), h.slotDisplacements),
+                           Array<BuffSlotMap::Entry>(file_.data(), h.slotEntries)),
+               AtlasUV { h.atlasUVSize[0], h.atlasUVSize[1] }) { }
+
+bool BuffCatalogFile::Validate(std::span<const std::byte> data) {
+    if(data.size() < sizeof(cat::Header))
+        return false;
+
+    const auto& h = *reinterpret_cast<const cat::Header*>(data.data());
+    // Only the magic is checked before the version, later versions may change everything else
+    if(h.magic != cat::Magic || h.version != cat::Version)
+        return false;
+
+    const size_t size = data.size();
+    if(!Fits<char>(h.strings, size) || !Fits<cat::Buff>(h.buffs, size) || !Fits<u32>(h.extraIds, size) ||
+       !Fits<BuffIdIndex>(h.byId, size) || !Fits<u32>(h.slotIds, size) || !Fits<u32>(h.slotDisplacements, size) ||
+       !Fits<BuffSlotMap::Entry>(h.slotEntries, size))
+        return false;
+
+    // BuffSlotMap masks hashes with the table sizes, which must be powers of two
+    if(!std::has_single_bit(h.slotDisplacements.count) || !std::has_single_bit(h.slotEntries.count))
+        return false;
+
+    const auto strings = Array<char>(data, h.strings);
+    const auto buffs = Array<cat::Buff>(data, h.buffs);
+    auto within = [](u64 first, u64 count, u64 size) { return first + count <= size; };
+    // The null character following every string must be in the pool too
+    auto validString = [&](cat::String s) {
+        return within(s.offset, u64(s.size) + 1, h.strings.count) && strings[s.offset + s.size] == '\0';
+    };
+    auto validSlot = [&](u32 slot) { return slot == BuffSlotMap::InvalidSlot || slot < h.slotIds.count; };
+
+    for(const auto& b : buffs)
+        if(!validString(b.name) || !validString(b.category) ||
+           !within(b.firstExtraId, b.extraIdCount, h.extraIds.count) || b.extraIdCount > BuffExtraIds::Capacity || !validSlot(b.slot))
+            return false;
+
+    // Lookups binary search the ID table and trust the indices it holds
+    const auto byId = Array<BuffIdIndex>(data, h.byId);
+    for(size_t i = 0; i < byId.size(); i++)
+        if(byId[i].index >= buffs.size() || buffs[byId[i].index].id != byId[i].id || (i > 0 && byId[i - 1].id >= byId[i].id))
+            return false;
+
+    for(const auto& e : Array<BuffSlotMap::Entry>(data, h.slotEntries))
+        if(!validSlot(e.slot))
+            return false;
+
+    return true;
+}
+
+} // namespace GW2Clarity
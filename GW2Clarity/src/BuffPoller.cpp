@@ -0,0 +1,48 @@
+#include "BuffPoller.h"
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+namespace GW2Clarity
+{
+
+u64 BuffPoller::Hash(const StackedBuff* buffs) {
+    size_t count = 0;
+    while(buffs[count].id)
+        count++;
+
+    // The terminator carries the error code, if any
+    return XXH3_64bits(buffs, (count + 1) * sizeof(StackedBuff));
+}
+
+bool BuffPoller::ShouldPoll() {
+    stats_.updates.fetch_add(1, std::memory_order_relaxed);
+    if(skipLeft_ == 0)
+        return true;
+
+    skipLeft_--;
+    stats_.backedOff.fetch_add(1, std::memory_order_relaxed);
+    return false;
+}
+
+bool BuffPoller::Changed(const StackedBuff* buffs) {
+    const i32 error = buffs[0].id == 0 ? buffs[0].count : 0;
+    if(error != 0 && error == lastError_) {
+        backOff_ = std::min(backOff_ == 0 ? 1 : backOff_ * 2, MaxBackOff);
+        skipLeft_ = backOff_;
+    }
+    else
+        backOff_ = 0;
+    lastError_ = error;
+
+    const u64 hash = Hash(buffs);
+    if(lastHash_ == hash) {
+        stats_.unchanged.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    lastHash_ = hash;
+    return true;
+}
+
+} // namespace GW2Clarity
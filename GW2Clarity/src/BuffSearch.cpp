@@ -0,0 +1,97 @@
+#include "BuffSearch.h"
+
+#include <range/v3/all.hpp>
+
+namespace GW2Clarity
+{
+
+namespace
+{
+char LowerChar(char c) {
+    return char(std::tolower(static_cast<unsigned char>(c)));
+}
+} // namespace
+
+void BuffSearchIndex::Add(std::string_view name, std::string_view category) {
+    GW2_ASSERT(trigrams_.empty());
+
+    for(char c : name)
+        haystacks_.push_back(LowerChar(c));
+    haystacks_.push_back(Separator);
+    for(char c : category)
+        haystacks_.push_back(LowerChar(c));
+
+    offsets_.push_back(u32(haystacks_.size()));
+}
+
+void BuffSearchIndex::Build() {
+    std::vector<std::pair<u32, u32>> pairs;
+    for(u32 index = 0; index < size(); index++) {
+        const auto h = haystack(index);
+        for(size_t i = 0; i + 3 <= h.size(); i++) {
+            if(h.substr(i, 3).find(Separator) != std::string_view::npos)
+                continue;
+            pairs.emplace_back(Trigram(h.data() + i), index);
+        }
+    }
+
+    // Sorting by index as well drops trigrams repeated within an entry and leaves each posting list sorted
+    ranges::sort(pairs);
+    pairs.erase(ranges::unique(pairs), pairs.end());
+
+    trigrams_.clear();
+    postings_.clear();
+    postings_.reserve(pairs.size());
+    for(const auto& [trigram, index] : pairs) {
+        if(trigrams_.empty() || trigrams_.back().trigram != trigram)
+            trigrams_.push_back({ trigram, u32(postings_.size()) });
+        postings_.push_back(index);
+    }
+}
+
+void BuffSearchIndex::Search(std::string_view query, BuffSearchResults& results) const {
+    std::string lowerQuery(query.size(), '\0');
+    ranges::transform(query, lowerQuery.begin(), LowerChar);
+
+    if(results.valid && lowerQuery == results.query)
+        return;
+
+    const bool narrowing = results.valid && lowerQuery.starts_with(results.query);
+    results.query = std::move(lowerQuery);
+    results.valid = true;
+    const std::string_view q = results.query;
+
+    if(narrowing) {
+        // Anything matching the longer query also matched the previous one
+        std::erase_if(results.indices, [&](u32 index) { return !Matches(index, q); });
+        return;
+    }
+
+    results.indices.clear();
+
+    if(q.size() < 3) {
+        for(u32 index = 0; index < size(); index++)
+            if(q.empty() || Matches(index, q))
+                results.indices.push_back(index);
+        return;
+    }
+
+    std::span<const u32> candidates;
+    for(size_t i = 0; i + 3 <= q.size(); i++) {
+        const u32 trigram = Trigram(q.data() + i);
+        auto it = ranges::lower_bound(trigrams_, trigram, std::less {}, &TrigramEntry::trigram);
+        if(it == trigrams_.end() || it->trigram != trigram)
+            return;
+
+        const u32 last = std::next(it) == trigrams_.end() ? u32(postings_.size()) : std::next(it)->first;
+        std::span<const u32> postings { postings_.data() + it->first, last - it->first };
+        if(candidates.empty() || postings.size() < candidates.size())
+            candidates = postings;
+    }
+
+    for(u32 index : candidates)
+        if(Matches(index, q))
+            results.indices.push_back(index);
+}
+
+} // namespace GW2Clarity
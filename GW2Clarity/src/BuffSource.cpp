@@ -0,0 +1,139 @@
+#include "BuffSource.h"
+
+#include <chrono>
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace GW2Clarity
+{
+
+std::unique_ptr<LibraryBuffSource> LibraryBuffSource::Load(const std::filesystem::path& path) {
+#ifdef _WIN32
+    HMODULE module = LoadLibraryW(path.c_str());
+    if(!module) {
+        LogError("Could not find {}!", path.filename().string());
+        return nullptr;
+    }
+
+    auto getBuffs = reinterpret_cast<GetBuffsCallback>(GetProcAddress(module, GetBuffsExportName));
+    if(!getBuffs) {
+        FreeLibrary(module);
+        LogError("Could not find get buffs callback!");
+        return nullptr;
+    }
+#else
+    void* module = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if(!module) {
+        LogError("Could not load {}: {}", path.string(), dlerror());
+        return nullptr;
+    }
+
+    auto getBuffs = reinterpret_cast<GetBuffsCallback>(dlsym(module, GetBuffsExportName));
+    if(!getBuffs) {
+        dlclose(module);
+        LogError("Could not find get buffs callback!");
+        return nullptr;
+    }
+#endif
+
+    return std::unique_ptr<LibraryBuffSource>(new LibraryBuffSource(module, getBuffs));
+}
+
+LibraryBuffSource::~LibraryBuffSource() {
+#ifdef _WIN32
+    FreeLibrary(static_cast<HMODULE>(module_));
+#else
+    dlclose(module_);
+#endif
+}
+
+ScriptedBuffSource::ScriptedBuffSource(const nlohmann::json& scenario, std::vector<u32> knownIds)
+    : knownIds_(std::move(knownIds)), loop_(scenario.value("loop", true)), rng_(scenario.value("seed", 0u)) {
+    if(auto it = scenario.find("phases"); it != scenario.end()) {
+        for(const auto& pIn : *it) {
+            Phase p;
+            p.frames = std::max(1u, pIn.value("frames", p.frames));
+            p.error = pIn.value("error", p.error);
+            p.active = pIn.value("active", p.active);
+            p.churn = pIn.value("churn", p.churn);
+            p.stackChange = pIn.value("stack_change", p.stackChange);
+            p.maxStacks = std::max(1, pIn.value("max_stacks", p.maxStacks));
+            p.unknown = pIn.value("unknown", p.unknown);
+            p.latencyUs = pIn.value("latency_us", p.latencyUs);
+            phases_.push_back(p);
+        }
+    }
+
+    if(phases_.empty())
+        LogWarn("Buff scenario has no phases, no buff will ever be active.");
+}
+
+StackedBuff* ScriptedBuffSource::GetBuffs() {
+    result_.clear();
+    if(phases_.empty()) {
+        result_.push_back({ 0, 0 });
+        return result_.data();
+    }
+
+    const Phase& p = phases_[phase_];
+
+    if(p.latencyUs > 0) {
+        const auto end = std::chrono::steady_clock::now() + std::chrono::microseconds(p.latencyUs);
+        while(std::chrono::steady_clock::now() < end)
+            ;
+    }
+
+    if(p.error != 0) {
+        active_.clear();
+        result_.push_back({ 0, p.error });
+    }
+    else {
+        std::uniform_real_distribution<f32> unit;
+        for(auto& b : active_) {
+            if(unit(rng_) < p.churn)
+                b = NewBuff(p);
+            else if(unit(rng_) < p.stackChange)
+                b.count = 1 + i32(rng_() % u32(p.maxStacks));
+        }
+
+        if(active_.size() > p.active)
+            active_.resize(p.active);
+        while(active_.size() < p.active)
+            active_.push_back(NewBuff(p));
+
+        result_.assign(active_.begin(), active_.end());
+        result_.push_back({ 0, 0 });
+    }
+
+    if(++phaseFrame_ >= p.frames) {
+        phaseFrame_ = 0;
+        if(phase_ + 1 < phases_.size())
+            phase_++;
+        else if(loop_)
+            phase_ = 0;
+    }
+
+    return result_.data();
+}
+
+StackedBuff ScriptedBuffSource::NewBuff(const Phase& p) {
+    const i32 count = 1 + i32(rng_() % u32(p.maxStacks));
+
+    std::uniform_real_distribution<f32> unit;
+    if(!knownIds_.empty() && unit(rng_) >= p.unknown) {
+        // Active IDs are few compared to the catalog, so a handful of attempts finds an unused one
+        for(u32 attempt = 0; attempt < 8; attempt++) {
+            const u32 id = knownIds_[rng_() % knownIds_.size()];
+            if(std::ranges::none_of(active_, [id](const StackedBuff& b) { return b.id == id; }))
+                return { id, count };
+        }
+    }
+
+    return { nextUnknownId_++, count };
+}
+
+} // namespace GW2Clarity
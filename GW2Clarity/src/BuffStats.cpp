@@ -0,0 +1,246 @@
+#include "BuffStats.h"
+
+#include <iomanip>
+#include <ostream>
+
+namespace GW2Clarity
+{
+
+void BuffStats::Totals::Reset(size_t slotCount) {
+    activeMs.assign(slotCount, 0);
+    stackMs.assign(slotCount, 0);
+    longestGap.assign(slotCount, 0);
+}
+
+BuffStats::BuffStats(size_t slotCount, mstime now)
+    : counts_(slotCount, 0), since_(slotCount), inactiveSince_(slotCount), bucketActiveMs_(BucketCount * slotCount),
+      bucketStackMs_(BucketCount * slotCount), bucketLongestGap_(BucketCount * slotCount), bucketLongestGapEnd_(BucketCount * slotCount),
+      bucketLongestGapInBucket_(BucketCount * slotCount), lastNow_(now) {
+    Reset(now);
+}
+
+void BuffStats::Reset(mstime now) {
+    now = Now(now);
+
+    std::ranges::fill(since_, now);
+    std::ranges::fill(inactiveSince_, now);
+    std::ranges::fill(bucketActiveMs_, 0);
+    std::ranges::fill(bucketStackMs_, 0);
+    std::ranges::fill(bucketLongestGap_, 0);
+    std::ranges::fill(bucketLongestGapEnd_, 0);
+    std::ranges::fill(bucketLongestGapInBucket_, 0);
+    bucket_ = 0;
+    bucketStart_ = now;
+
+    session_.Reset(counts_.size());
+    sessionStart_ = now;
+    fight_.Reset(counts_.size());
+    fightStart_ = fightEnd_ = now;
+    hadFight_ = inFight_;
+}
+
+void BuffStats::Update(mstime now, std::span<const BuffCountChange> changes) {
+    now = Now(now);
+    Advance(now);
+
+    for(const auto& c : changes) {
+        const u32 s = c.slot;
+        Fold(s, now);
+
+        const bool wasActive = counts_[s] > 0, active = c.current > 0;
+        if(!wasActive && active)
+            EndGap(s, now);
+        else if(wasActive && !active)
+            inactiveSince_[s] = now;
+
+        counts_[s] = c.current;
+    }
+}
+
+void BuffStats::UpdateCombat(mstime now, bool inCombat) {
+    now = Now(now);
+    Advance(now);
+    if(inCombat == inFight_)
+        return;
+
+    // Time before the fight mustn't count towards it, and time after it is folded in without it
+    FoldAll(now);
+    inFight_ = inCombat;
+    if(inCombat) {
+        fight_.Reset(counts_.size());
+        fightStart_ = now;
+        hadFight_ = true;
+    }
+    else {
+        // Gaps still open when the fight ends last until its end as far as the fight is concerned
+        for(u32 s = 0; s < counts_.size(); s++)
+            if(counts_[s] <= 0)
+                fight_.longestGap[s] = std::max(fight_.longestGap[s], std::min(now - inactiveSince_[s], now - fightStart_));
+        fightEnd_ = now;
+    }
+}
+
+void BuffStats::Advance(mstime now) {
+    while(now >= bucketStart_ + BucketDuration) {
+        bucketStart_ += BucketDuration;
+        FoldAll(bucketStart_);
+
+        bucket_ = (bucket_ + 1) % BucketCount;
+        const size_t o = bucketOffset(bucket_);
+        std::fill_n(bucketActiveMs_.begin() + o, counts_.size(), 0);
+        std::fill_n(bucketStackMs_.begin() + o, counts_.size(), 0);
+        std::fill_n(bucketLongestGap_.begin() + o, counts_.size(), 0);
+        std::fill_n(bucketLongestGapEnd_.begin() + o, counts_.size(), 0);
+        std::fill_n(bucketLongestGapInBucket_.begin() + o, counts_.size(), 0);
+    }
+}
+
+void BuffStats::Fold(u32 s, mstime until) {
+    const mstime dt = until - since_[s];
+    since_[s] = until;
+    if(counts_[s] <= 0 || dt == 0)
+        return;
+
+    // Folds happen at least once per bucket, so dt never exceeds BucketDuration
+    const u64 stackMs = u64(counts_[s]) * dt;
+    const size_t i = bucketOffset(bucket_) + s;
+    bucketActiveMs_[i] += u32(dt);
+    bucketStackMs_[i] += u32(std::min<u64>(stackMs, std::numeric_limits<u32>::max() - bucketStackMs_[i]));
+
+    session_.activeMs[s] += dt;
+    session_.stackMs[s] += stackMs;
+    if(inFight_) {
+        fight_.activeMs[s] += dt;
+        fight_.stackMs[s] += stackMs;
+    }
+}
+
+void BuffStats::FoldAll(mstime until) {
+    for(u32 s = 0; s < counts_.size(); s++)
+        Fold(s, until);
+}
+
+void BuffStats::EndGap(u32 s, mstime now) {
+    const mstime gap = now - inactiveSince_[s];
+    session_.longestGap[s] = std::max(session_.longestGap[s], std::min(gap, now - sessionStart_));
+    if(inFight_)
+        fight_.longestGap[s] = std::max(fight_.longestGap[s], std::min(gap, now - fightStart_));
+
+    const size_t i = bucketOffset(bucket_) + s;
+    const u16 end = u16(now - bucketStart_);
+    if(const u32 g = u32(std::min<mstime>(gap, std::numeric_limits<u32>::max())); g > bucketLongestGap_[i]) {
+        bucketLongestGap_[i] = g;
+        bucketLongestGapEnd_[i] = end;
+    }
+    bucketLongestGapInBucket_[i] = std::max(bucketLongestGapInBucket_[i], u16(std::min<mstime>(gap, end)));
+}
+
+void BuffStats::Snapshot(mstime now, BuffStatsWindow window, BuffStatsSnapshot& out) {
+    now = Now(now);
+    Advance(now);
+
+    out.window = window;
+    out.slots.clear();
+
+    // Time since the last fold only counts towards windows still running
+    mstime start = sessionStart_, end = now;
+    bool running = true;
+    switch(window) {
+    case BuffStatsWindow::Fight:
+        if(!hadFight_) {
+            out.duration = 0;
+            return;
+        }
+        start = fightStart_;
+        running = inFight_;
+        end = running ? now : fightEnd_;
+        break;
+    case BuffStatsWindow::Recent:
+        start = std::max(sessionStart_, bucketStart_ - std::min(bucketStart_, (BucketCount - 1) * BucketDuration));
+        break;
+    case BuffStatsWindow::Session:
+        break;
+    }
+    out.duration = end - start;
+    if(out.duration == 0)
+        return;
+
+    for(u32 s = 0; s < counts_.size(); s++) {
+        u64 activeMs = 0, stackMs = 0;
+        mstime longestGap = 0;
+        switch(window) {
+        case BuffStatsWindow::Fight:
+            activeMs = fight_.activeMs[s];
+            stackMs = fight_.stackMs[s];
+            longestGap = fight_.longestGap[s];
+            break;
+        case BuffStatsWindow::Recent:
+            for(size_t b = 0; b < BucketCount; b++) {
+                const size_t i = bucketOffset(b) + s;
+                activeMs += bucketActiveMs_[i];
+                stackMs += bucketStackMs_[i];
+                // Gaps are clipped to the start of the window, which is at the start of a bucket
+                const mstime bs = bucketStart(b);
+                if(bs <= start)
+                    longestGap = std::max<mstime>(longestGap, bucketLongestGapInBucket_[i]);
+                else
+                    longestGap = std::max(longestGap, std::min<mstime>(bucketLongestGap_[i], bs + bucketLongestGapEnd_[i] - start));
+            }
+            break;
+        case BuffStatsWindow::Session:
+            activeMs = session_.activeMs[s];
+            stackMs = session_.stackMs[s];
+            longestGap = session_.longestGap[s];
+            break;
+        }
+
+        if(running) {
+            if(counts_[s] > 0) {
+                activeMs += now - since_[s];
+                stackMs += u64(counts_[s]) * (now - since_[s]);
+            }
+            else
+                longestGap = std::max(longestGap, now - inactiveSince_[s]);
+        }
+
+        if(activeMs == 0)
+            continue;
+
+        out.slots.push_back({ s, f32(f64(activeMs) / f64(out.duration)), f32(f64(stackMs) / f64(activeMs)), f64(stackMs) / 1000.0,
+                              f32(f64(std::min(longestGap, out.duration)) / 1000.0) });
+    }
+}
+
+std::vector<const Buff*> BuffSlotOwners(const BuffCatalog& catalog) {
+    std::vector<const Buff*> owners(catalog.slots().size(), nullptr);
+    for(const auto& b : catalog.buffs()) {
+        if(b.isCategory())
+            continue;
+
+        if(b.slot != BuffSlotMap::InvalidSlot)
+            owners[b.slot] = &b;
+        for(u32 id : b.extraIds)
+            if(u32 slot = catalog.slots()[id]; slot != BuffSlotMap::InvalidSlot && !owners[slot])
+                owners[slot] = &b;
+    }
+    return owners;
+}
+
+void WriteBuffStatsCsv(std::ostream& out, std::span<const BuffStatsSnapshot> snapshots, const BuffCatalog& catalog) {
+    const auto owners = BuffSlotOwners(catalog);
+
+    out << "window,window_seconds,id,buff,uptime_percent,average_stacks,stack_seconds,longest_gap_seconds\n" << std::fixed;
+    for(const auto& snapshot : snapshots)
+        for(const auto& s : snapshot.slots) {
+            // Names may hold commas and quotes
+            std::string name = owners[s.slot] ? std::string(owners[s.slot]->name) : std::string();
+            for(size_t i = name.find('"'); i != std::string::npos; i = name.find('"', i + 2))
+                name.insert(i, 1, '"');
+
+            out << BuffStatsWindowNames[size_t(snapshot.window)] << ',' << std::setprecision(1) << f64(snapshot.duration) / 1000.0 << ','
+                << catalog.slots().id(s.slot) << ",\"" << name << "\"," << std::setprecision(2) << s.uptime * 100.f << ','
+                << s.averageStacks << ',' << std::setprecision(1) << s.stackSeconds << ',' << s.longestGapSeconds << '\n';
+        }
+}
+
+} // namespace GW2Clarity
@@ -0,0 +1,137 @@
+#include "BuffStatsMenu.h"
+
+#include <imgui.h>
+
+#include "Core.h"
+
+namespace GW2Clarity
+{
+
+BuffStatsMenu::BuffStatsMenu(Buffs* buffs) : buffs_(buffs), owners_(BuffSlotOwners(buffs->catalog())) {
+    SettingsMenu::i().AddImplementer(this);
+}
+
+BuffStatsMenu::~BuffStatsMenu() {
+    SettingsMenu::f([&](auto& i) { i.RemoveImplementer(this); });
+}
+
+void BuffStatsMenu::DrawMenu(Keybind** currentEditedKeybind) {
+    bool refresh = TimeInMilliseconds() - lastRefreshTime_ > RefreshDelay;
+    for(size_t w = 0; w < BuffStatsWindowNames.size(); w++) {
+        if(w > 0)
+            ImGui::SameLine();
+        if(ImGui::RadioButton(BuffStatsWindowNames[w], window_ == BuffStatsWindow(w))) {
+            window_ = BuffStatsWindow(w);
+            refresh = true;
+        }
+    }
+
+    ImGui::SameLine();
+    if(ImGui::Button("Reset")) {
+        buffs_->ResetStats();
+        refresh = true;
+    }
+
+    if(refresh) {
+        buffs_->SnapshotStats(window_, snapshot_);
+        lastRefreshTime_ = TimeInMilliseconds();
+    }
+
+    if(snapshot_.duration == 0) {
+        ImGui::TextUnformatted(window_ == BuffStatsWindow::Fight ? "No fight yet." : "No statistics yet.");
+        return;
+    }
+
+    ImGui::Text("Over %.0f seconds. Gaps are the longest stretches without the buff.", f64(snapshot_.duration) / 1000.0);
+
+    constexpr i32 TableFlags = ImGuiTableFlags_RowBg | ImGuiTableFlags_ScrollY | ImGuiTableFlags_Sortable;
+    // Leaves room for the export button below
+    const ImVec2 tableSize(0.f, ImGui::GetContentRegionAvail().y - ImGui::GetFrameHeightWithSpacing());
+    if(ImGui::BeginTable("Buff Statistics", 5, TableFlags, tableSize)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Buff", ImGuiTableColumnFlags_WidthStretch, 5.f);
+        ImGui::TableSetupColumn("Uptime", ImGuiTableColumnFlags_WidthFixed | ImGuiTableColumnFlags_DefaultSort |
+                                              ImGuiTableColumnFlags_PreferSortDescending, 70.f);
+        ImGui::TableSetupColumn("Avg. stacks", ImGuiTableColumnFlags_WidthFixed, 80.f);
+        ImGui::TableSetupColumn("Stack-seconds", ImGuiTableColumnFlags_WidthFixed, 100.f);
+        ImGui::TableSetupColumn("Longest gap", ImGuiTableColumnFlags_WidthFixed, 90.f);
+        ImGui::TableHeadersRow();
+
+        // Sorted in place, and again whenever the snapshot is refreshed
+        if(auto* sort = ImGui::TableGetSortSpecs(); sort && sort->SpecsCount > 0 && (sort->SpecsDirty || refresh)) {
+            const auto& spec = sort->Specs[0];
+            auto key = [&](const BuffSlotStats& s) -> f64 {
+                switch(spec.ColumnIndex) {
+                case 1:
+                    return s.uptime;
+                case 2:
+                    return s.averageStacks;
+                case 3:
+                    return s.stackSeconds;
+                case 4:
+                    return s.longestGapSeconds;
+                default:
+                    return f64(s.slot);
+                }
+            };
+            if(spec.SortDirection == ImGuiSortDirection_Descending)
+                std::ranges::stable_sort(snapshot_.slots, std::greater {}, key);
+            else
+                std::ranges::stable_sort(snapshot_.slots, std::less {}, key);
+            sort->SpecsDirty = false;
+        }
+
+        for(const auto& s : snapshot_.slots) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            if(const Buff* owner = owners_[s.slot])
+                ImGui::TextUnformatted(owner->name.data(), owner->name.data() + owner->name.size());
+            else
+                ImGui::Text("%u", buffs_->buffSlots().id(s.slot));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f%%", s.uptime * 100.f);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.2f", s.averageStacks);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.0f", s.stackSeconds);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1fs", s.longestGapSeconds);
+        }
+
+        ImGui::EndTable();
+    }
+
+    if(ImGui::Button("Export CSV"))
+        Export();
+    if(!lastExportPath_.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(lastExportPath_.c_str());
+    }
+}
+
+void BuffStatsMenu::Export() {
+    using namespace std::chrono;
+
+    wchar_t fn[MAX_PATH];
+    GetModuleFileName(GetBaseCore().dllModule(), fn, MAX_PATH);
+
+    std::filesystem::path statsPath = fn;
+    statsPath = statsPath.remove_filename() / std::format("buff_stats_{:%Y%m%d_%H%M%S}.csv", floor<seconds>(system_clock::now()));
+
+    std::ofstream file(statsPath);
+    if(!file.good()) {
+        LogError("Could not write buff statistics to {}.", statsPath.string());
+        lastExportPath_.clear();
+        return;
+    }
+
+    std::array<BuffStatsSnapshot, BuffStatsWindowNames.size()> snapshots;
+    for(size_t w = 0; w < snapshots.size(); w++)
+        buffs_->SnapshotStats(BuffStatsWindow(w), snapshots[w]);
+    WriteBuffStatsCsv(file, snapshots, buffs_->catalog());
+
+    lastExportPath_ = statsPath.string();
+    LogInfo("Buff statistics written to {}.", lastExportPath_);
+}
+
+} // namespace GW2Clarity
@@ -0,0 +1,273 @@
+#include "BuffTrace.h"
+
+#include <zlib.h>
+
+namespace GW2Clarity
+{
+
+namespace
+{
+void WriteVarint(std::string& out, u64 v) {
+    while(v >= 0x80) {
+        out.push_back(char((v & 0x7F) | 0x80));
+        v >>= 7;
+    }
+    out.push_back(char(v));
+}
+
+bool ReadVarint(std::string_view in, size_t& offset, u64& v) {
+    v = 0;
+    for(u32 shift = 0; shift < 64 && offset < in.size(); shift += 7) {
+        const u8 b = u8(in[offset++]);
+        v |= u64(b & 0x7F) << shift;
+        if(!(b & 0x80))
+            return true;
+    }
+    return false;
+}
+
+u64 ZigZag(i32 v) { return u64(u32(v) << 1 ^ u32(v >> 31)); }
+i32 UnZigZag(u64 v) { return i32(u32(v >> 1) ^ -u32(v & 1)); }
+
+template<typename T>
+void WriteRaw(std::ostream& out, const T& v) {
+    out.write(reinterpret_cast<const char*>(&v), sizeof(T));
+}
+
+template<typename T>
+bool ReadRaw(std::istream& in, T& v) {
+    in.read(reinterpret_cast<char*>(&v), sizeof(T));
+    return in.gcount() == sizeof(T);
+}
+
+// Sorts by ID, keeping only the last occurrence of any repeated ID as ActiveBuffsTable would
+void Normalize(std::vector<StackedBuff>& buffs) {
+    std::ranges::stable_sort(buffs, {}, &StackedBuff::id);
+    auto out = buffs.begin();
+    for(auto it = buffs.begin(); it != buffs.end(); ++it)
+        if(std::next(it) == buffs.end() || std::next(it)->id != it->id)
+            *out++ = *it;
+    buffs.erase(out, buffs.end());
+}
+} // namespace
+
+bool BuffTraceWriter::Open(const std::filesystem::path& path) {
+    Close();
+
+    file_.open(path, std::ios::binary | std::ios::trunc);
+    if(!file_.is_open()) {
+        LogError("Could not open buff trace '{}' for writing.", path.string());
+        return false;
+    }
+
+    file_.write(BuffTrace::Magic.data(), BuffTrace::Magic.size());
+    WriteRaw(file_, BuffTrace::Version);
+
+    block_.clear();
+    blockFrames_ = 0;
+    frameCount_ = 0;
+    lastTimeUs_ = 0;
+    previous_.clear();
+
+    return true;
+}
+
+void BuffTraceWriter::Close() {
+    if(!file_.is_open())
+        return;
+
+    FlushBlock();
+    file_.close();
+}
+
+void BuffTraceWriter::Record(u64 timeUs, const StackedBuff* buffs) {
+    if(!file_.is_open())
+        return;
+
+    current_.clear();
+    const i32 status = buffs[0].id == 0 ? buffs[0].count : 0;
+    for(size_t i = 0; buffs[i].id; i++)
+        current_.push_back(buffs[i]);
+    Normalize(current_);
+
+    const u64 base = blockFrames_ == 0 ? 0 : lastTimeUs_;
+    WriteVarint(block_, timeUs > base ? timeUs - base : 0);
+    lastTimeUs_ = std::max(timeUs, base);
+
+    WriteVarint(block_, ZigZag(status));
+    if(status == 0) {
+        // Both lists are sorted, so a merge walk finds ended buffs, then started or changed ones
+        auto writeDiff = [&](const std::vector<StackedBuff>& from, const std::vector<StackedBuff>& to, bool withCounts) {
+            auto differs = [&](auto it) {
+                auto other = std::ranges::lower_bound(from, it->id, {}, &StackedBuff::id);
+                return other == from.end() || other->id != it->id || (withCounts && other->count != it->count);
+            };
+
+            u64 count = 0;
+            for(auto it = to.begin(); it != to.end(); ++it)
+                count += differs(it);
+            WriteVarint(block_, count);
+
+            u32 lastId = 0;
+            for(auto it = to.begin(); it != to.end(); ++it) {
+                if(!differs(it))
+                    continue;
+                WriteVarint(block_, it->id - lastId);
+                if(withCounts)
+                    WriteVarint(block_, ZigZag(it->count));
+                lastId = it->id;
+            }
+        };
+
+        writeDiff(current_, previous_, false);
+        writeDiff(previous_, current_, true);
+    }
+
+    previous_.swap(current_);
+    frameCount_++;
+
+    if(++blockFrames_ == BuffTrace::FramesPerBlock)
+        FlushBlock();
+}
+
+void BuffTraceWriter::FlushBlock() {
+    if(blockFrames_ == 0)
+        return;
+
+    uLongf compressedSize = compressBound(uLong(block_.size()));
+    compressed_.resize(compressedSize);
+    if(compress2(reinterpret_cast<Bytef*>(compressed_.data()), &compressedSize, reinterpret_cast<const Bytef*>(block_.data()),
+                 uLong(block_.size()), Z_BEST_SPEED) != Z_OK) {
+        LogError("Could not compress buff trace block, {} frames lost.", blockFrames_);
+    }
+    else {
+        WriteRaw(file_, blockFrames_);
+        WriteRaw(file_, u32(block_.size()));
+        WriteRaw(file_, u32(compressedSize));
+        file_.write(compressed_.data(), std::streamsize(compressedSize));
+        // Keep completed blocks if the game crashes, which is often when a trace is most interesting
+        file_.flush();
+    }
+
+    block_.clear();
+    blockFrames_ = 0;
+    previous_.clear();
+}
+
+bool BuffTraceReader::Open(const std::filesystem::path& path) {
+    file_.open(path, std::ios::binary);
+    failed_ = false;
+    blockFramesLeft_ = 0;
+    if(!file_.is_open())
+        return Fail("could not open file");
+
+    std::array<char, BuffTrace::Magic.size()> magic;
+    u32 version = 0;
+    file_.read(magic.data(), magic.size());
+    if(file_.gcount() != std::streamsize(magic.size()) || magic != BuffTrace::Magic || !ReadRaw(file_, version))
+        return Fail("not a buff trace");
+    if(version != BuffTrace::Version)
+        return Fail("unsupported version");
+
+    return true;
+}
+
+bool BuffTraceReader::ReadBlock() {
+    u32 frames = 0, rawSize = 0, compressedSize = 0;
+    if(!ReadRaw(file_, frames)) {
+        // A trace ending between blocks is complete, anything else was cut short
+        if(file_.gcount() != 0)
+            return Fail("truncated block header");
+        return false;
+    }
+    if(!ReadRaw(file_, rawSize) || !ReadRaw(file_, compressedSize))
+        return Fail("truncated block header");
+    if(frames == 0 || rawSize > BuffTrace::MaxBlockSize || compressedSize > BuffTrace::MaxBlockSize)
+        return Fail("invalid block header");
+
+    compressed_.resize(compressedSize);
+    file_.read(compressed_.data(), compressedSize);
+    if(file_.gcount() != std::streamsize(compressedSize))
+        return Fail("truncated block");
+
+    block_.resize(rawSize);
+    uLongf size = rawSize;
+    if(uncompress(reinterpret_cast<Bytef*>(block_.data()), &size, reinterpret_cast<const Bytef*>(compressed_.data()), compressedSize) !=
+           Z_OK ||
+       size != rawSize)
+        return Fail("corrupted block");
+
+    blockOffset_ = 0;
+    blockFramesLeft_ = frames;
+    lastTimeUs_ = 0;
+    previous_.clear();
+
+    return true;
+}
+
+bool BuffTraceReader::Next(BuffTraceFrame& frame) {
+    if(failed_ || !file_.is_open())
+        return false;
+    if(blockFramesLeft_ == 0 && !ReadBlock())
+        return false;
+
+    u64 dt, status;
+    if(!ReadVarint(block_, blockOffset_, dt) || !ReadVarint(block_, blockOffset_, status))
+        return Fail("truncated frame");
+    lastTimeUs_ += dt;
+
+    current_.clear();
+    if(status == 0) {
+        auto readIds = [&](auto&& add, bool withCounts) {
+            u64 count, id = 0;
+            if(!ReadVarint(block_, blockOffset_, count) || count > block_.size())
+                return false;
+            for(u64 i = 0; i < count; i++) {
+                u64 delta, zigzagCount = 0;
+                if(!ReadVarint(block_, blockOffset_, delta) || (withCounts && !ReadVarint(block_, blockOffset_, zigzagCount)))
+                    return false;
+                id += delta;
+                if(id > std::numeric_limits<u32>::max())
+                    return false;
+                add(u32(id), UnZigZag(zigzagCount));
+            }
+            return true;
+        };
+
+        removed_.clear();
+        changed_.clear();
+        if(!readIds([&](u32 id, i32) { removed_.push_back(id); }, false) ||
+           !readIds([&](u32 id, i32 count) { changed_.push_back({ id, count }); }, true))
+            return Fail("truncated frame");
+
+        // Previous buffs minus the ended ones, merged with the started and changed ones, all sorted by ID
+        auto changed = changed_.begin();
+        for(const auto& b : previous_) {
+            for(; changed != changed_.end() && changed->id < b.id; ++changed)
+                current_.push_back(*changed);
+            if(changed != changed_.end() && changed->id == b.id)
+                current_.push_back(*changed++);
+            else if(!std::ranges::binary_search(removed_, b.id))
+                current_.push_back(b);
+        }
+        current_.insert(current_.end(), changed, changed_.end());
+    }
+
+    frame.timeUs = lastTimeUs_;
+    frame.buffs.assign(current_.begin(), current_.end());
+    frame.buffs.push_back({ 0, status == 0 ? 0 : UnZigZag(status) });
+
+    previous_.swap(current_);
+    if(--blockFramesLeft_ == 0 && blockOffset_ != block_.size())
+        return Fail("trailing data in block");
+
+    return true;
+}
+
+bool BuffTraceReader::Fail(std::string_view reason) {
+    LogError("Could not read buff trace: {}.", reason);
+    failed_ = true;
+    return false;
+}
+
+} // namespace GW2Clarity
@@ -2,12 +2,13 @@
 
 #include <cppcodec/base64_rfc4648.hpp>
 #include <misc/cpp/imgui_stdlib.h>
-#include <range/v3/all.hpp>
 #include <shellapi.h>
 #include <skyr/percent_encoding/percent_encode.hpp>
 
 #include "Core.h"
+#include "FixedLabel.h"
 #include "ImGuiExtensions.h"
+#include "Profiler.h"
 #include "Resource.h"
 
 namespace GW2Clarity
@@ -37,20 +38,78 @@ std::vector<vec2> GenerateNumbersMap(vec2& uvSize) {
     return numbers;
 }
 
+ComPtr<ID3D11ShaderResourceView> CreateUVBuffer(ID3D11Device* dev, std::span<const vec2> uvs) {
+    D3D11_BUFFER_DESC desc;
+    desc.Usage = D3D11_USAGE_IMMUTABLE;
+    desc.ByteWidth = UINT(uvs.size_bytes());
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = 0;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    desc.StructureByteStride = sizeof(vec2);
+
+    D3D11_SUBRESOURCE_DATA data { uvs.data(), 0, 0 };
+
+    ComPtr<ID3D11Buffer> buffer;
+    GW2_CHECKED_HRESULT(dev->CreateBuffer(&desc, &data, buffer.GetAddressOf()));
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    srvDesc.Buffer.FirstElement = 0;
+    srvDesc.Buffer.NumElements = UINT(uvs.size());
+
+    ComPtr<ID3D11ShaderResourceView> srv;
+    GW2_CHECKED_HRESULT(dev->CreateShaderResourceView(buffer.Get(), &srvDesc, srv.GetAddressOf()));
+    return srv;
+}
+
+std::optional<BuffCatalogFile> OpenCatalogFile() {
+    wchar_t fn[MAX_PATH];
+    GetModuleFileName(Core::i().dllModule(), fn, MAX_PATH);
+
+    std::filesystem::path path = fn;
+    path = path.remove_filename() / BuffCatalogFileName;
+
+    auto file = BuffCatalogFile::Open(path);
+    if(file)
+        LogInfo("Using buff catalog '{}' with {} entries.", path.string(), file->catalog().buffs().size());
+    return file;
+}
+
 Buffs::Buffs(ComPtr<ID3D11Device>& dev)
-    : buffs_(GenerateBuffsList(buffsAtlasUVSize_)), buffsMap_(GenerateBuffsMap(buffs_)), numbers_(GenerateNumbersMap(numbersAtlasUVSize_)) {
+    : catalogFile_(OpenCatalogFile())
+    , catalog_(catalogFile_ ? catalogFile_->catalog() : CompiledBuffCatalog())
+    , numbers_(GenerateNumbersMap(numbersAtlasUVSize_))
+    , activeBuffs_(ActiveBuffsTable(&catalog_.slots()))
+    , publishedCounts_(catalog_.slots().size(), 0)
+    , stats_(catalog_.slots().size(), TimeInMilliseconds()) {
     buffsAtlas_ = CreateTextureFromResource(dev.Get(), Core::i().dllModule(), IDR_BUFFS);
     numbersAtlas_ = CreateTextureFromResource(dev.Get(), Core::i().dllModule(), IDR_NUMBERS);
 
+    std::vector<vec2> atlasUVs(buffs().size() + 1);
+    for(const auto& b : buffs())
+        atlasUVs[b.atlasSlot] = b.uv.vec();
+    atlasUVs_ = CreateUVBuffer(dev.Get(), atlasUVs);
+    numberUVs_ = CreateUVBuffer(dev.Get(), numbers_);
+
+    for(const auto& b : buffs())
+        searchIndex_.Add(b.name, b.category);
+    searchIndex_.Build();
+
 #ifdef _DEBUG
     SettingsMenu::i().AddImplementer(this);
 
+    seenSlots_.resize(buffSlots().size(), false);
+    recordedSlots_.resize(buffSlots().size(), false);
+    pendingSeenSlots_.resize(buffSlots().size(), false);
     LoadNames();
 #endif
 }
 
 #ifdef _DEBUG
 void Buffs::LoadNames() {
+    GW2_PROFILE_SCOPE("Buffs::LoadNames");
+
     buffNames_.clear();
 
     wchar_t fn[MAX_PATH];
@@ -80,6 +139,8 @@ void Buffs::LoadNames() {
 }
 
 void Buffs::SaveNames() const {
+    GW2_PROFILE_SCOPE("Buffs::SaveNames");
+
     wchar_t fn[MAX_PATH];
     GetModuleFileName(GetBaseCore().dllModule(), fn, MAX_PATH);
 
@@ -95,21 +156,46 @@ void Buffs::SaveNames() const {
 }
 
 void Buffs::DrawMenu(Keybind** currentEditedKeybind) {
+    const auto& activeBuffs = AcquireActiveBuffs();
+    {
+        std::lock_guard lock(pendingSeenMutex_);
+        if(pendingSeen_) {
+            for(size_t slot = 0; slot < pendingSeenSlots_.size(); slot++)
+                if(pendingSeenSlots_[slot]) {
+                    seenSlots_[slot] = true;
+                    pendingSeenSlots_[slot] = false;
+                }
+            seenUnknownIds_.merge(pendingSeenUnknownIds_);
+            pendingSeenUnknownIds_.clear();
+            pendingSeen_ = false;
+        }
+    }
+
+    auto forEachSeen = [&](auto&& cb) {
+        for(u32 slot = 0; slot < seenSlots_.size(); slot++)
+            if(seenSlots_[slot])
+                cb(buffSlots().id(slot), activeBuffs.slot(slot));
+        for(u32 id : seenUnknownIds_)
+            cb(id, activeBuffs[id]);
+    };
+
     ImGui::InputInt("Say in Guild", &guildLogId_, 1);
     if(guildLogId_ < 0 || guildLogId_ > 5)
         guildLogId_ = 1;
 
     ImGui::Checkbox("Hide any inactive", &hideInactive_);
     if(ImGui::Button("Hide currently inactive")) {
-        for(auto& [id, buff] : activeBuffs_)
+        forEachSeen([&](u32 id, i32 buff) {
             if(buff == 0)
                 hiddenBuffs_.insert(id);
+        });
     }
     ImGui::SameLine();
     if(ImGui::Button("Hide currently active")) {
-        for(auto& [id, buff] : activeBuffs_)
+        forEachSeen([&](u32 id, i32 buff) {
             if(buff > 0)
                 hiddenBuffs_.insert(id);
+        });
     }
     ImGui::SameLine();
     if(ImGui::Button("Unhide all"))
@@ -121,108 +207,124 @@ void Buffs::DrawMenu(Keybind** currentEditedKeybind) {
         ImGui::TableSetupColumn("Name", ImGuiTableColumnFlags_WidthStretch, 5.f);
         ImGui::TableSetupColumn("Chat Link", ImGuiTableColumnFlags_WidthStretch, 5.f);
         ImGui::TableHeadersRow();
-        for(auto& [id, buff] : activeBuffs_) {
+        shownBuffs_.clear();
+        forEachSeen([&](u32 id, i32 buff) {
             if(buff == 0 && hideInactive_ || hiddenBuffs_.count(id) > 0)
-                continue;
-
-            ImGui::TableNextRow();
-            ImGui::TableSetColumnIndex(0);
-
-            ImGui::Text("%u", id);
-
-            ImGui::TableNextColumn();
-
-            ImGui::Text("%d", buff);
-
-            ImGui::TableNextColumn();
-
-            if(auto it = buffsMap_.find(id); it != buffsMap_.end())
-                ImGui::TextUnformatted(it->second->name.c_str());
-            else {
-                auto& str = buffNames_[id];
-                if(ImGui::InputText(std::format("##Name{}", id).c_str(), &str))
-                    SaveNames();
-            }
-
-            ImGui::TableNextColumn();
-
-            byte chatCode[1 + 3 + 1];
-            chatCode[0] = 0x06;
-            chatCode[1 + 3] = 0x0;
-            chatCode[1] = id & 0xFF;
-            chatCode[2] = (id >> 8) & 0xFF;
-            chatCode[3] = (id >> 16) & 0xFF;
-
-            using base64 = cppcodec::base64_rfc4648;
-
-            std::string chatCodeStr = std::format("[&{}]", base64::encode(chatCode));
-
-            ImGui::TextUnformatted(chatCodeStr.c_str());
-            ImGui::SameLine();
-            if(ImGui::Button(("Copy##" + chatCodeStr).c_str()))
-                ImGui::SetClipboardText(chatCodeStr.c_str());
-            ImGui::SameLine();
-            if(ImGui::Button(std::format("Say in G{}##{}", guildLogId_, chatCodeStr).c_str())) {
-                ImGui::SetClipboardText(std::format("/g{} {}: {}", guildLogId_, id, chatCodeStr).c_str());
-
-                auto wait = [](i32 i) {
-                    std::this_thread::sleep_for(std::chrono::milliseconds(i));
-                };
-                auto sendKeyEvent = [](u32 vk, ScanCode sc, bool down) {
-                    INPUT i;
-                    ZeroMemory(&i, sizeof(INPUT));
-                    i.type = INPUT_KEYBOARD;
-                    i.ki.wVk = vk;
-                    i.ki.wScan = ToUnderlying(sc);
-                    i.ki.dwFlags = down ? 0 : KEYEVENTF_KEYUP;
-
-                    SendInput(1, &i, sizeof(INPUT));
-                };
-
-                std::thread([=] {
-                    wait(100);
-
-                    sendKeyEvent(VK_RETURN, ScanCode::Enter, true);
-                    wait(50);
-                    sendKeyEvent(VK_RETURN, ScanCode::Enter, false);
-                    wait(100);
-
-                    sendKeyEvent(VK_CONTROL, ScanCode::ControlLeft, true);
-                    wait(50);
-                    sendKeyEvent('V', ScanCode::V, true);
-                    wait(100);
-
-                    sendKeyEvent('V', ScanCode::V, false);
-                    wait(50);
-                    sendKeyEvent(VK_CONTROL, ScanCode::ControlLeft, false);
-                    wait(100);
-
-                    sendKeyEvent(VK_RETURN, ScanCode::Enter, true);
-                    wait(50);
-                    sendKeyEvent(VK_RETURN, ScanCode::Enter, false);
-                }).detach();
-            }
-            ImGui::SameLine();
-            if(ImGui::Button(("Wiki##" + chatCodeStr).c_str())) {
-                ShellExecute(0, 0,
-                             std::format(L"https://wiki.guildwars2.com/index.php?title=Special:Search&search={}",
-                                         utf8_decode(skyr::percent_encode(chatCodeStr)))
-                                 .c_str(),
-                             0, 0, SW_SHOW);
+                return;
+            shownBuffs_.emplace_back(id, buff);
+        });
+
+        ImGuiListClipper clipper;
+        clipper.Begin(i32(shownBuffs_.size()));
+        while(clipper.Step())
+            for(i32 row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                const auto [id, buff] = shownBuffs_[row];
+                ImGui::PushID(i32(id));
+
+                ImGui::TableNextRow();
+                ImGui::TableSetColumnIndex(0);
+
+                ImGui::Text("%u", id);
+
+                ImGui::TableNextColumn();
+
+                ImGui::Text("%d", buff);
+
+                ImGui::TableNextColumn();
+
+                if(const Buff* b = catalog_.find(id))
+                    ImGui::TextUnformatted(b->name.data(), b->name.data() + b->name.size());
+                else {
+                    auto& str = buffNames_[id];
+                    if(ImGui::InputText("##Name", &str))
+                        SaveNames();
+                }
+
+                ImGui::TableNextColumn();
+
+                byte chatCode[1 + 3 + 1];
+                chatCode[0] = 0x06;
+                chatCode[1 + 3] = 0x0;
+                chatCode[1] = id & 0xFF;
+                chatCode[2] = (id >> 8) & 0xFF;
+                chatCode[3] = (id >> 16) & 0xFF;
+
+                using base64 = cppcodec::base64_rfc4648;
+
+                // "[&", the code, "]" and a null character, encoded in place rather than through temporary strings
+                std::array<char, 2 + base64::encoded_size(sizeof(chatCode)) + 2> chatCode64 { '[', '&' };
+                const size_t codeSize = base64::encode(chatCode64.data() + 2, chatCode64.size() - 2, chatCode, sizeof(chatCode));
+                chatCode64[2 + codeSize] = ']';
+                chatCode64[3 + codeSize] = '\0';
+                const std::string_view chatCodeStr(chatCode64.data(), 3 + codeSize);
+
+                ImGui::TextUnformatted(chatCodeStr.data(), chatCodeStr.data() + chatCodeStr.size());
+                ImGui::SameLine();
+                if(ImGui::Button("Copy"))
+                    ImGui::SetClipboardText(chatCodeStr.data());
+                ImGui::SameLine();
+                if(ImGui::Button(FixedLabel<16>("Say in G{}", guildLogId_).c_str())) {
+                    ImGui::SetClipboardText(std::format("/g{} {}: {}", guildLogId_, id, chatCodeStr).c_str());
+
+                    auto wait = [](i32 i) {
+                        std::this_thread::sleep_for(std::chrono::milliseconds(i));
+                    };
+                    auto sendKeyEvent = [](u32 vk, ScanCode sc, bool down) {
+                        INPUT i;
+                        ZeroMemory(&i, sizeof(INPUT));
+                        i.type = INPUT_KEYBOARD;
+                        i.ki.wVk = vk;
+                        i.ki.wScan = ToUnderlying(sc);
+                        i.ki.dwFlags = down ? 0 : KEYEVENTF_KEYUP;
+
+                        SendInput(1, &i, sizeof(INPUT));
+                    };
+
+                    std::thread([=] {
+                        wait(100);
+
+                        sendKeyEvent(VK_RETURN, ScanCode::Enter, true);
+                        wait(50);
+                        sendKeyEvent(VK_RETURN, ScanCode::Enter, false);
+                        wait(100);
+
+                        sendKeyEvent(VK_CONTROL, ScanCode::ControlLeft, true);
+                        wait(50);
+                        sendKeyEvent('V', ScanCode::V, true);
+                        wait(100);
+
+                        sendKeyEvent('V', ScanCode::V, false);
+                        wait(50);
+                        sendKeyEvent(VK_CONTROL, ScanCode::ControlLeft, false);
+                        wait(100);
+
+                        sendKeyEvent(VK_RETURN, ScanCode::Enter, true);
+                        wait(50);
+                        sendKeyEvent(VK_RETURN, ScanCode::Enter, false);
+                    }).detach();
+                }
+                ImGui::SameLine();
+                if(ImGui::Button("Wiki")) {
+                    ShellExecute(0, 0,
+                                 std::format(L"https://wiki.guildwars2.com/index.php?title=Special:Search&search={}",
+                                             utf8_decode(skyr::percent_encode(chatCodeStr)))
+                                     .c_str(),
+                                 0, 0, SW_SHOW);
+                }
+
+                ImGui::PopID();
             }
-        }
         ImGui::EndTable();
     }
 }
 #endif
 
 void Buffs::UpdateBuffsTable(StackedBuff* buffs) {
-#ifdef _DEBUG
-    for(auto& b : activeBuffs_)
-        b.second = 0;
-#else
-    activeBuffs_.clear();
-#endif
+    auto& table = activeBuffs_.back();
+    if(u32 dropped = table.Assign(buffs); dropped != 0 && !overflowWarned_) {
+        overflowWarned_ = true;
+        LogWarn("Too many unknown buffs active, dropping buff {}.", dropped);
+    }
 
     if(buffs[0].id == 0) {
         i32 e = lastGetBuffsError_;
@@ -255,96 +357,90 @@ void Buffs::UpdateBuffsTable(StackedBuff* buffs) {
                 break;
             }
         }
-        return;
     }
 
-    for(size_t i = 0; buffs[i].id; i++)
-        activeBuffs_[buffs[i].id] = buffs[i].count;
-}
-
-bool Buffs::DrawBuffCombo(const char* name, const Buff*& selectedBuf, std::span<char> searchBuffer) const {
-    bool changed = false;
-    if(ImGui::BeginCombo(name, selectedBuf ? selectedBuf->name.c_str() : "<none>")) {
-        ImGui::InputText("Search...", searchBuffer.data(), searchBuffer.size());
-        std::string_view bs { searchBuffer.data() };
+    table.Diff(publishedCounts_);
+    std::ranges::copy(table.counts(), publishedCounts_.begin());
+#ifdef _DEBUG
+    // A buff becoming active always shows up as a change, however many tables the render thread skips
+    for(const auto& c : table.changes())
+        if(c.current != 0 && !recordedSlots_[c.slot]) {
+            recordedSlots_[c.slot] = true;
+            std::lock_guard lock(pendingSeenMutex_);
+            pendingSeenSlots_[c.slot] = true;
+            pendingSeen_ = true;
+        }
+    for(const auto& b : table.overflow())
+        if(recordedUnknownIds_.insert(b.id).second) {
+            std::lock_guard lock(pendingSeenMutex_);
+            pendingSeenUnknownIds_.insert(b.id);
+            pendingSeen_ = true;
+        }
+#endif
+    {
+        std::lock_guard lock(statsMutex_);
+        stats_.Update(TimeInMilliseconds(), table.changes());
+    }
 
-        for(auto& b : buffs_) {
-            auto caseInsensitive = [](char l, char r) {
-                return std::tolower(l) == std::tolower(r);
-            };
-            bool filtered = !bs.empty() && ranges::search(b.name, bs, caseInsensitive).empty() &&
-                            ranges::search(b.category, bs, caseInsensitive).empty();
+    table.generation(++activeBuffsGeneration_);
+    activeBuffs_.Publish();
+}
 
-            if(filtered)
-                continue;
+void Buffs::UpdateStatsCombat(bool inCombat) {
+    std::lock_guard lock(statsMutex_);
+    stats_.UpdateCombat(TimeInMilliseconds(), inCombat);
+}
 
-            if(b.id == 0xFFFFFFFF) {
-                ImGui::PushFont(Core::i().fontBold());
-                ImGui::Text(b.name.c_str());
-                ImGui::PopFont();
-                ImGui::Separator();
-                continue;
-            }
+void Buffs::SnapshotStats(BuffStatsWindow window, BuffStatsSnapshot& out) const {
+    std::lock_guard lock(statsMutex_);
+    stats_.Snapshot(TimeInMilliseconds(), window, out);
+}
 
-            ImGui::SetCursorPosX(ImGui::GetCursorPosX() + 20.f);
+void Buffs::ResetStats() {
+    std::lock_guard lock(statsMutex_);
+    stats_.Reset(TimeInMilliseconds());
+}
 
-            ImGui::Image(buffsAtlas_.srv.Get(), ImVec2(32, 32), ToImGui(b.uv.xy), ToImGui(b.uv.xy + buffsAtlasUVSize()));
-            ImGui::SameLine();
-            if(ImGui::Selectable(b.name.c_str(), false)) {
-                selectedBuf = &b;
-                changed = true;
+bool Buffs::DrawBuffCombo(const char* name, const Buff*& selectedBuf, std::span<char> searchBuffer, BuffSearchResults& results) const {
+    bool changed = false;
+    // Catalog names are string literals, and so null-terminated
+    if(ImGui::BeginCombo(name, selectedBuf ? selectedBuf->name.data() : "<none>")) {
+        ImGui::InputText("Search...", searchBuffer.data(), searchBuffer.size());
+        searchIndex_.Search(searchBuffer.data(), results);
+
+        // Category headers are padded to the height of a buff row so the clipper can skip rows without submitting them
+        const f32 iconSize = 32.f;
+        ImGuiListClipper clipper;
+        clipper.Begin(i32(results.indices.size()), iconSize + ImGui::GetStyle().ItemSpacing.y);
+        while(clipper.Step()) {
+            for(i32 row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                const auto& b = buffs()[results.indices[row]];
+
+                if(b.isCategory()) {
+                    ImGui::Dummy(ImVec2(0.f, iconSize));
+                    ImGui::SameLine();
+                    ImGui::PushFont(Core::i().fontBold());
+                    ImGui::TextUnformatted(b.name.data(), b.name.data() + b.name.size());
+                    ImGui::PopFont();
+                    continue;
+                }
+
+                ImGui::SetCursorPosX(ImGui::GetCursorPosX() + 20.f);
+
+                ImGui::Image(buffsAtlas_.srv.Get(), ImVec2(iconSize, iconSize), ToImGui(b.uv.vec()),
+                             ToImGui(b.uv.vec() + buffsAtlasUVSize()));
+                ImGui::SameLine();
+                if(ImGui::Selectable(b.name.data(), false)) {
+                    selectedBuf = &b;
+                    changed = true;
+                }
             }
         }
+        clipper.End();
         ImGui::EndCombo();
     }
 
     return changed;
 }
 
-#include "BuffsList.inc"
-
-std::vector<Buff> Buffs::GenerateBuffsList(vec2& uvSize) {
-    const std::unordered_map<std::string, vec2> atlasElements {
-#include <assets/atlas.inc>
-    };
-
-    uvSize = atlasElements.at("");
-
-    std::vector<Buff> buffs;
-    buffs.assign(g_Buffs.begin(), g_Buffs.end());
-
-#ifdef _DEBUG
-    std::set<std::string> buffNames;
-    for(auto& b : buffs) {
-        auto r = buffNames.insert(b.name);
-        if(!r.second)
-            LogWarn("Duplicate buff name: {}", b.name);
-    }
-#endif
-
-    std::string cat;
-    for(auto& b : buffs) {
-        if(b.id == 0xFFFFFFFF)
-            cat = b.name;
-        else
-            b.category = cat;
-
-        auto it = atlasElements.find(b.atlasEntry);
-        b.uv = it != atlasElements.end() ? it->second : vec4 { 0.f, 0.f, 0.f, 0.f };
-
-        if(b.id != 0xFFFFFFFF && it == atlasElements.end())
-            LogWarn("Buff {} ({}) has no atlas icon.", b.name, b.id);
-    }
-
-    return buffs;
-}
-
-std::unordered_map<i32, const Buff*> Buffs::GenerateBuffsMap(const std::vector<Buff>& lst) {
-    std::unordered_map<i32, const Buff*> m;
-    for(auto& b : lst) {
-        m[b.id] = &b;
-    }
-    return m;
-}
-
 } // namespace GW2Clarity
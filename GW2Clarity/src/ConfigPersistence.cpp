@@ -0,0 +1,171 @@
+#include "ConfigPersistence.h"
+
+#include <fstream>
+
+#include "ConfigSnapshot.h"
+#include "Profiler.h"
+
+namespace GW2Clarity
+{
+
+ConfigPersistence::ConfigPersistence(std::filesystem::path path, nlohmann::json& document, std::span<const std::string> sections,
+                                     std::chrono::milliseconds coalesceDelay)
+    : path_(std::move(path)), document_(document), coalesceDelay_(coalesceDelay), sectionKeys_(sections.begin(), sections.end()),
+      base_(CopyDocument()) {
+    for(const auto& section : sectionKeys_)
+        if(const auto it = document_.find(section); it != document_.end())
+            sections_.emplace(section, *it);
+
+    thread_ = std::thread([this] { Run(); });
+}
+
+ConfigPersistence::~ConfigPersistence() {
+    {
+        std::lock_guard lock(mutex_);
+        stopping_ = true;
+    }
+    wake_.notify_all();
+    thread_.join();
+}
+
+void ConfigPersistence::Submit(const std::string& section, Serializer serializer) {
+    sectionKeys_.insert(section);
+    {
+        std::lock_guard lock(mutex_);
+        pending_.insert_or_assign(section, std::move(serializer));
+        QueueDocument();
+    }
+    wake_.notify_all();
+}
+
+void ConfigPersistence::Set(const std::string& object, const std::string& key, nlohmann::json value) {
+    document_[object][key] = std::move(value);
+    {
+        std::lock_guard lock(mutex_);
+        QueueDocument();
+    }
+    wake_.notify_all();
+}
+
+nlohmann::json ConfigPersistence::CopyDocument() const {
+    // Sections are the bulk of the document, and the background thread has its own copy of them
+    nlohmann::json copy = nlohmann::json::object();
+    for(const auto& [key, value] : document_.items())
+        if(!sectionKeys_.contains(key))
+            copy[key] = value;
+    return copy;
+}
+
+void ConfigPersistence::QueueDocument() {
+    pendingDocument_ = CopyDocument();
+    submitted_++;
+}
+
+void ConfigPersistence::RefreshSnapshot() {
+    {
+        std::lock_guard lock(mutex_);
+        snapshotRequested_ = true;
+    }
+    wake_.notify_all();
+}
+
+void ConfigPersistence::Flush() {
+    std::unique_lock lock(mutex_);
+    const u64 target = submitted_;
+    if(writtenUpTo_ >= target)
+        return;
+
+    flushRequested_ = true;
+    wake_.notify_all();
+    written_.wait(lock, [&] { return writtenUpTo_ >= target; });
+}
+
+void ConfigPersistence::Run() {
+    std::unique_lock lock(mutex_);
+    while(true) {
+        wake_.wait(lock, [&] { return stopping_ || pendingDocument_ || snapshotRequested_; });
+        if(!pendingDocument_) {
+            if(!snapshotRequested_)
+                break;
+
+            snapshotRequested_ = false;
+            lock.unlock();
+            SnapshotFile();
+            lock.lock();
+            continue;
+        }
+
+        // Edits usually come in bursts across several components, such as a layout and the grids it references
+        wake_.wait_for(lock, coalesceDelay_, [&] { return stopping_ || flushRequested_; });
+
+        auto batch = std::move(pending_);
+        pending_.clear();
+        base_ = std::move(*pendingDocument_);
+        pendingDocument_.reset();
+        flushRequested_ = false;
+        // Rewriting the file refreshes the snapshot anyway
+        snapshotRequested_ = false;
+        const u64 sequence = submitted_;
+
+        lock.unlock();
+        Write(batch);
+        batch.clear();
+        lock.lock();
+
+        writtenUpTo_ = sequence;
+        written_.notify_all();
+    }
+}
+
+void ConfigPersistence::Write(std::map<std::string, Serializer>& batch) {
+    GW2_PROFILE_SCOPE("ConfigPersistence::Write");
+
+    for(auto& [section, serialize] : batch)
+        sections_.insert_or_assign(section, serialize());
+
+    nlohmann::json document = base_;
+    for(const auto& [section, value] : sections_)
+        document[section] = value;
+
+    const std::string text = document.dump(4);
+
+    auto temporaryPath = path_;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        out << text;
+        out.close();
+        if(out.fail()) {
+            LogError("Could not write configuration to '{}'.", temporaryPath.string());
+            return;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporaryPath, path_, ec);
+    if(ec) {
+        LogError("Could not replace configuration file '{}': {}", path_.string(), ec.message());
+        return;
+    }
+
+    writeCount_.fetch_add(1, std::memory_order_relaxed);
+
+    WriteConfigSnapshot(ConfigSnapshotPath(path_), HashConfigText(text), document);
+}
+
+void ConfigPersistence::SnapshotFile() {
+    GW2_PROFILE_SCOPE("ConfigPersistence::SnapshotFile");
+
+    std::ifstream in(path_, std::ios::binary);
+    if(!in)
+        return;
+    const std::string text { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+
+    const auto document = nlohmann::json::parse(text, nullptr, false);
+    if(document.is_discarded())
+        return;
+
+    WriteConfigSnapshot(ConfigSnapshotPath(path_), HashConfigText(text), document);
+}
+
+} // namespace GW2Clarity
@@ -0,0 +1,380 @@
+#include "ConfigSnapshot.h"
+
+#include <fstream>
+
+#include "ConfigJson.h"
+
+#define XXH_INLINE_ALL
+#include <xxhash.h>
+
+namespace GW2Clarity
+{
+
+namespace snap = ConfigSnapshotFormat;
+
+static_assert(std::is_trivially_copyable_v<snap::Header> && sizeof(snap::Header) == 80);
+static_assert(sizeof(snap::Threshold) == 72 && sizeof(snap::Grid) == 56 && sizeof(snap::Item) == 28 && sizeof(snap::Layout) == 20);
+
+std::filesystem::path ConfigSnapshotPath(const std::filesystem::path& configPath) {
+    auto path = configPath;
+    path += ".snapshot";
+    return path;
+}
+
+u64 HashConfigText(std::string_view text) { return XXH3_64bits(text.data(), text.size()); }
+
+std::optional<u64> HashConfigFile(const std::filesystem::path& configPath) {
+    std::ifstream in(configPath, std::ios::binary);
+    if(!in)
+        return std::nullopt;
+
+    std::string text(size_t(std::filesystem::file_size(configPath)), '\0');
+    in.read(text.data(), std::streamsize(text.size()));
+    if(size_t(in.gcount()) != text.size())
+        return std::nullopt;
+
+    return HashConfigText(text);
+}
+
+namespace
+{
+class SnapshotBuilder
+{
+public:
+    snap::String AddString(const std::string& s) {
+        auto [it, inserted] = stringOffsets_.try_emplace(s, snap::String { u32(strings.size()), u32(s.size()) });
+        if(inserted)
+            strings.insert(strings.end(), s.begin(), s.end());
+        return it->second;
+    }
+
+    void AddStyles(const nlohmann::json& stylesIn) {
+        for(const auto& sIn : stylesIn) {
+            auto& s = styles.emplace_back(snap::Style { AddString(sIn.at("name")), u32(thresholds.size()), 0 });
+            for(const auto& tIn : sIn.at("thresholds")) {
+                snap::Threshold t {};
+                t.thresholdMin = ReadOr(tIn, "threshold_min", 0);
+                t.thresholdMax = ReadOr(tIn, "threshold_max", 1);
+                Store(t.tint, ReadOr(tIn, "tint", vec4(1)));
+                Store(t.border, ReadOr(tIn, "border", vec4(0)));
+                Store(t.glow, ReadOr(tIn, "glow", vec4(0)));
+                t.borderThickness = ReadOr(tIn, "border_thickness", 0.f);
+                t.glowSize = ReadOr(tIn, "glow_size", 0.f);
+                Store(t.glowPulse, ReadOr(tIn, "glow_pulse", vec2(0)));
+                thresholds.push_back(t);
+                s.thresholdCount++;
+            }
+        }
+    }
+
+    void AddGrids(const nlohmann::json& gridsIn) {
+        for(const auto& gIn : gridsIn) {
+            snap::Grid g {};
+            Store(g.spacing, ReadOr(gIn, "spacing", ivec2(32, 32)));
+            Store(g.offset, ReadOr(gIn, "offset", ivec2()));
+            g.attached = ReadOr(gIn, "attached", false);
+            g.centralWeight = ReadOr(gIn, "central_weight", 0.f);
+            Store(g.mouseClipMin, ReadOr(gIn, "mouse_clip_min", ivec2 { std::numeric_limits<i32>::max() }));
+            Store(g.mouseClipMax, ReadOr(gIn, "mouse_clip_max", ivec2 { std::numeric_limits<i32>::min() }));
+            g.trackMouseWhileHeld = ReadOr(gIn, "track_mouse_while_held", true);
+            g.square = ReadOr(gIn, "square", true);
+            g.name = AddString(gIn.at("name"));
+            g.firstItem = u32(items.size());
+
+            for(const auto& iIn : gIn.at("items")) {
+                snap::Item i {};
+                Store(i.pos, FromJson<ivec2>(iIn.at("pos")));
+                i.buffId = iIn.at("buff_id");
+                i.style = AddString(ReadOr(iIn, "style", std::string {}));
+                i.firstAdditionalBuff = u32(buffIds.size());
+                if(auto it = iIn.find("additional_buff_ids"); it != iIn.end())
+                    for(const auto& bIn : *it)
+                        buffIds.push_back(bIn);
+                i.additionalBuffCount = u32(buffIds.size()) - i.firstAdditionalBuff;
+                items.push_back(i);
+            }
+
+            g.itemCount = u32(items.size()) - g.firstItem;
+            grids.push_back(g);
+        }
+    }
+
+    void AddLayouts(const nlohmann::json& layoutsIn) {
+        for(const auto& lIn : layoutsIn) {
+            snap::Layout l {};
+            l.name = AddString(lIn.at("name"));
+            l.combatOnly = ReadOr(lIn, "combat_only", false);
+            l.firstGrid = u32(layoutGrids.size());
+            for(const auto& gIn : lIn.at("grids"))
+                layoutGrids.push_back(gIn);
+            l.gridCount = u32(layoutGrids.size()) - l.firstGrid;
+            layouts.push_back(l);
+        }
+    }
+
+    [[nodiscard]] std::string Serialize(u64 sourceHash) const {
+        std::string out(sizeof(snap::Header), '\0');
+        snap::Header h {};
+        h.magic = snap::Magic;
+        h.version = snap::Version;
+        h.sourceHash = sourceHash;
+        h.strings = Append(out, std::span(strings));
+        h.styles = Append(out, std::span(styles));
+        h.thresholds = Append(out, std::span(thresholds));
+        h.grids = Append(out, std::span(grids));
+        h.items = Append(out, std::span(items));
+        h.buffIds = Append(out, std::span(buffIds));
+        h.layouts = Append(out, std::span(layouts));
+        h.layoutGrids = Append(out, std::span(layoutGrids));
+        std::memcpy(out.data(), &h, sizeof(h));
+        return out;
+    }
+
+    std::vector<char> strings;
+    std::vector<snap::Style> styles;
+    std::vector<snap::Threshold> thresholds;
+    std::vector<snap::Grid> grids;
+    std::vector<snap::Item> items;
+    std::vector<i32> buffIds;
+    std::vector<snap::Layout> layouts;
+    std::vector<i32> layoutGrids;
+
+private:
+    template<typename T, size_t N, typename V>
+    static void Store(T (&out)[N], const V& v) {
+        for(size_t c = 0; c < N; c++)
+            out[c] = v[i32(c)];
+    }
+
+    // Every array starts on an 8-byte boundary
+    template<typename T>
+    static snap::Range Append(std::string& out, std::span<const T> values) {
+        out.resize((out.size() + 7) & ~size_t(7));
+        const snap::Range r { u32(out.size()), u32(values.size()) };
+        out.append(reinterpret_cast<const char*>(values.data()), values.size_bytes());
+        return r;
+    }
+
+    std::unordered_map<std::string, snap::String> stringOffsets_;
+};
+
+template<typename T>
+bool Fits(snap::Range r, size_t size) {
+    return r.offset % alignof(T) == 0 && u64(r.offset) + u64(r.count) * sizeof(T) <= size;
+}
+
+template<typename V, typename T>
+V Load(const T* in) {
+    V v;
+    for(i32 c = 0; c < i32(V::length()); c++)
+        v[c] = in[c];
+    return v;
+}
+} // namespace
+
+bool WriteConfigSnapshot(const std::filesystem::path& path, u64 sourceHash, const nlohmann::json& config) {
+    SnapshotBuilder builder;
+    try {
+        builder.AddStyles(ConfigSection(config, "styles"));
+        builder.AddGrids(ConfigSection(config, "buff_grids"));
+        builder.AddLayouts(ConfigSection(config, "buff_layouts"));
+    }
+    catch(const nlohmann::json::exception& e) {
+        LogError("Could not snapshot configuration: {}", e.what());
+        return false;
+    }
+
+    const std::string data = builder.Serialize(sourceHash);
+    if(data.size() > std::numeric_limits<u32>::max()) {
+        LogError("Configuration too large to snapshot.");
+        return false;
+    }
+
+    auto temporaryPath = path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream out(temporaryPath, std::ios::binary | std::ios::trunc);
+        out.write(data.data(), std::streamsize(data.size()));
+        out.close();
+        if(out.fail()) {
+            LogError("Could not write configuration snapshot to '{}'.", temporaryPath.string());
+            return false;
+        }
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(temporaryPath, path, ec);
+    if(ec) {
+        LogError("Could not replace configuration snapshot '{}': {}", path.string(), ec.message());
+        return false;
+    }
+
+    return true;
+}
+
+std::optional<ConfigSnapshot> ConfigSnapshot::Open(const std::filesystem::path& path, u64 sourceHash) {
+    auto file = MappedFile::Open(path);
+    if(!file)
+        return std::nullopt;
+
+    ConfigSnapshot snapshot(std::move(*file));
+    if(!snapshot.Validate()) {
+        LogWarn("Ignoring damaged configuration snapshot '{}'.", path.string());
+        return std::nullopt;
+    }
+    if(snapshot.header().sourceHash != sourceHash)
+        return std::nullopt;
+
+    return snapshot;
+}
+
+bool ConfigSnapshot::Validate() const {
+    const auto data = file_.data();
+    if(data.size() < sizeof(snap::Header))
+        return false;
+
+    const auto& h = header();
+    // Only the magic is checked before the version, later versions may change everything else
+    if(h.magic != snap::Magic || h.version != snap::Version)
+        return false;
+
+    const size_t size = data.size();
+    if(!Fits<char>(h.strings, size) || !Fits<snap::Style>(h.styles, size) || !Fits<snap::Threshold>(h.thresholds, size) ||
+       !Fits<snap::Grid>(h.grids, size) || !Fits<snap::Item>(h.items, size) || !Fits<i32>(h.buffIds, size) ||
+       !Fits<snap::Layout>(h.layouts, size) || !Fits<i32>(h.layoutGrids, size))
+        return false;
+
+    auto within = [](u32 first, u32 count, u32 size) { return u64(first) + count <= size; };
+    auto validString = [&](snap::String s) { return within(s.offset, s.size, h.strings.count); };
+
+    for(const auto& s : Array<snap::Style>(h.styles))
+        if(!validString(s.name) || !within(s.firstThreshold, s.thresholdCount, h.thresholds.count))
+            return false;
+    for(const auto& g : Array<snap::Grid>(h.grids))
+        if(!validString(g.name) || !within(g.firstItem, g.itemCount, h.items.count))
+            return false;
+    for(const auto& i : Array<snap::Item>(h.items))
+        if(!validString(i.style) || !within(i.firstAdditionalBuff, i.additionalBuffCount, h.buffIds.count))
+            return false;
+    for(const auto& l : Array<snap::Layout>(h.layouts))
+        if(!validString(l.name) || !within(l.firstGrid, l.gridCount, h.layoutGrids.count))
+            return false;
+
+    return true;
+}
+
+std::vector<StyleTable::Style> ConfigSnapshot::ReadStyles() const {
+    const auto thresholds = Array<snap::Threshold>(header().thresholds);
+
+    std::vector<StyleTable::Style> out;
+    out.reserve(header().styles.count);
+    for(const auto& sIn : Array<snap::Style>(header().styles)) {
+        auto& s = out.emplace_back(String(sIn.name));
+        s.thresholds.reserve(sIn.thresholdCount);
+        for(const auto& tIn : thresholds.subspan(sIn.firstThreshold, sIn.thresholdCount)) {
+            StyleTable::Threshold t;
+            t.thresholdMin = tIn.thresholdMin;
+            t.thresholdMax = tIn.thresholdMax;
+            auto& app = t.appearance;
+            app.tint = Load<vec4>(tIn.tint);
+            app.border = Load<vec4>(tIn.border);
+            app.glow = Load<vec4>(tIn.glow);
+            app.borderThickness = tIn.borderThickness;
+            app.glowSize = tIn.glowSize;
+            app.glowPulse = Load<vec2>(tIn.glowPulse);
+            s.thresholds.push_back(t);
+        }
+    }
+
+    return out;
+}
+
+std::vector<Grid> ConfigSnapshot::ReadGrids(const BuffCatalog& catalog, const StyleTable& styles) const {
+    const auto items = Array<snap::Item>(header().items);
+    const auto buffIds = Array<i32>(header().buffIds);
+
+    auto getBuff = [&](i32 id) { return catalog.find(u32(id)); };
+    // Strings are deduplicated, so each style name only needs looking up once
+    std::unordered_map<u32, u32> styleIds;
+    auto getStyle = [&](snap::String name) {
+        auto [it, inserted] = styleIds.try_emplace(name.offset);
+        if(inserted)
+            it->second = styles.FindStyle(std::string(String(name)));
+        return it->second;
+    };
+
+    std::vector<Grid> out;
+    out.reserve(header().grids.count);
+    for(const auto& gIn : Array<snap::Grid>(header().grids)) {
+        Grid& g = out.emplace_back();
+        g.spacing = Load<ivec2>(gIn.spacing);
+        g.offset = Load<ivec2>(gIn.offset);
+        g.attached = gIn.attached;
+        g.centralWeight = gIn.centralWeight;
+        g.mouseClipMin = Load<ivec2>(gIn.mouseClipMin);
+        g.mouseClipMax = Load<ivec2>(gIn.mouseClipMax);
+        g.trackMouseWhileHeld = gIn.trackMouseWhileHeld;
+        g.square = gIn.square;
+        g.name = String(gIn.name);
+
+        g.items.reserve(gIn.itemCount);
+        for(const auto& iIn : items.subspan(gIn.firstItem, gIn.itemCount)) {
+            GridItem& i = g.items.emplace_back();
+            i.pos = Load<ivec2>(iIn.pos);
+            i.style = getStyle(iIn.style);
+            for(i32 id : buffIds.subspan(iIn.firstAdditionalBuff, iIn.additionalBuffCount))
+                if(const Buff* b = getBuff(id))
+                    i.additionalBuffs.push_back(b);
+
+            if(const Buff* b = getBuff(iIn.buffId))
+                i.buff = b;
+            else {
+                i.buff = &UnknownBuff;
+                LogWarn("Configuration has unknown buff: Grid '{}', location ({}, {}), buff ID '{}'.", g.name, i.pos.x, i.pos.y,
+                        iIn.buffId);
+            }
+        }
+    }
+
+    return out;
+}
+
+std::vector<Layout> ConfigSnapshot::ReadLayouts(size_t gridCount) const {
+    const auto layoutGrids = Array<i32>(header().layoutGrids);
+
+    std::vector<Layout> out;
+    out.reserve(header().layouts.count);
+    for(const auto& lIn : Array<snap::Layout>(header().layouts)) {
+        Layout& l = out.emplace_back();
+        l.name = String(lIn.name);
+        l.combatOnly = lIn.combatOnly;
+        for(i32 id : layoutGrids.subspan(lIn.firstGrid, lIn.gridCount))
+            if(id >= 0 && size_t(id) < gridCount)
+                l.grids.insert(id);
+    }
+
+    return out;
+}
+
+void ConfigSource::LoadStyles(StyleTable& styles) const {
+    if(snapshot_)
+        styles.LoadStyles(snapshot_->ReadStyles());
+    else
+        styles.LoadStyles(ConfigSection(config_, "styles"));
+}
+
+std::vector<Grid> ConfigSource::LoadGrids(const BuffCatalog& catalog, const StyleTable& styles) const {
+    if(snapshot_)
+        return snapshot_->ReadGrids(catalog, styles);
+    return GW2Clarity::LoadGrids(ConfigSection(config_, "buff_grids"), catalog, styles);
+}
+
+std::vector<Layout> ConfigSource::LoadLayouts(size_t gridCount) const {
+    if(snapshot_)
+        return snapshot_->ReadLayouts(gridCount);
+    return GW2Clarity::LoadLayouts(ConfigSection(config_, "buff_layouts"), gridCount);
+}
+
+const nlohmann::json& ConfigSource::section(const char* key) const { return ConfigSection(config_, key); }
+
+} // namespace GW2Clarity
@@ -7,14 +7,17 @@
 #include <imgui_internal.h>
 #include <shellapi.h>
 
+#include "AllocationTracker.h"
 #include "ConfigurationFile.h"
 #include "Direct3D11Loader.h"
 #include "GFXSettings.h"
+#include "ImGuiExtensions.h"
 #include "ImGuiPopup.h"
 #include "Input.h"
 #include "Log.h"
 #include "MiscTab.h"
 #include "MumbleLink.h"
+#include "Profiler.h"
 #include "SettingsMenu.h"
 #include "ShaderManager.h"
 #include "UpdateCheck.h"
@@ -29,7 +32,13 @@ namespace GW2Clarity
 class ClarityMiscTab : public ::MiscTab
 {
 public:
-    void AdditionalGUI() override { }
+    void AdditionalGUI() override {
+        bool record = Core::i().recordBuffTrace();
+        if(ImGui::Checkbox("Record buff trace", &record))
+            Core::i().recordBuffTrace(record);
+        ImGuiHelpTooltip("Records every buff update to a trace file next to the addon, to reproduce performance issues outside of the "
+                         "game. Traces keep growing for as long as this is enabled.");
+    }
 };
 
 void Core::InnerInitPreImGui() { ClarityMiscTab::init<ClarityMiscTab>(); }
@@ -44,52 +53,104 @@ void Core::InnerInitPreFontImGui() {
 }
 
 void Core::InnerInitPostImGui() {
-    firstMessageShown_ = std::make_unique<ConfigurationOption<bool>>("", "first_message_shown_v1", "Core", false);
+    // Parsed once, each component then reads its own section. Styles, grids and layouts are read from the snapshot instead if it was
+    // made from this exact file.
+    auto& cfg = JSONConfigurationFile::i();
+    cfg.Reload();
+    const auto configPath = cfg.location();
+
+    std::optional<ConfigSnapshot> snapshot;
+    if(const auto hash = HashConfigFile(configPath))
+        snapshot = ConfigSnapshot::Open(ConfigSnapshotPath(configPath), *hash);
+    const ConfigSource config(cfg.json(), snapshot ? &*snapshot : nullptr);
+
+    // The sections components submit, everything else in the file is saved as it is in the document
+    static const std::array<std::string, 4> Sections { "buff_grids", "buff_layouts", "cursor_layers", "styles" };
+    configPersistence_ = std::make_unique<ConfigPersistence>(configPath, cfg.json(), Sections);
+    if(!snapshot)
+        configPersistence_->RefreshSnapshot();
+
+    firstMessageShown_ = std::make_unique<PersistedOption<bool>>(*configPersistence_, "", "first_message_shown_v1", "Core", false);
 
     buffs_ = std::make_unique<Buffs>(device_);
-    styles_ = std::make_unique<Styles>(device_, buffs_.get());
-    grids_ = std::make_unique<Grids>(device_, buffs_.get(), styles_.get());
-    layouts_ = std::make_unique<Layouts>(device_, grids_.get());
-    cursor_ = std::make_unique<Cursor>(device_);
+    styles_ = std::make_unique<Styles>(device_, buffs_.get(), config);
+    grids_ = std::make_unique<Grids>(device_, buffs_.get(), styles_.get(), config);
+    layouts_ = std::make_unique<Layouts>(device_, grids_.get(), config);
+    cursor_ = std::make_unique<Cursor>(device_, config);
+    buffStatsMenu_ = std::make_unique<BuffStatsMenu>(buffs_.get());
+#ifdef GW2CLARITY_PROFILING
+    profilerMenu_ = std::make_unique<ProfilerMenu>();
+#endif
 }
 
 void Core::InnerInternalInit() {
-    if(!buffLib_) {
+    if(!buffSource_) {
         wchar_t fn[MAX_PATH];
         GetModuleFileName(dllModule(), fn, MAX_PATH);
 
+        // Any library exporting GetCurrentPlayerStackedBuffs can stand in for getbuffs.dll, such as the scripted GetBuffsStandIn
         std::filesystem::path buffsPath = fn;
 #ifdef _DEBUG
         buffsPath = buffsPath.remove_filename() / "getbuffsd.dll";
-        buffLib_ = LoadLibrary(buffsPath.wstring().c_str());
-        if(!buffLib_)
+        if(std::filesystem::exists(buffsPath))
+            buffSource_ = LibraryBuffSource::Load(buffsPath);
+        if(!buffSource_)
 #endif
         {
             buffsPath = buffsPath.remove_filename() / "getbuffs.dll";
-            buffLib_ = LoadLibrary(buffsPath.wstring().c_str());
+            buffSource_ = LibraryBuffSource::Load(buffsPath);
         }
-        if(buffLib_)
-            getBuffs_ = (decltype(getBuffs_))GetProcAddress(buffLib_, "GetCurrentPlayerStackedBuffs");
-        else
-            getBuffs_ = nullptr;
-
-        if(!buffLib_)
-            LogError("Could not find getbuffs.dll!");
-        if(!getBuffs_)
-            LogError("Could not find get buffs callback!");
     }
 }
 
 void Core::InnerShutdown() {
-    FreeLibrary(buffLib_);
-    buffLib_ = nullptr;
+    buffSource_.reset();
 
     CoUninitialize();
 }
 
 void Core::InnerFrequentUpdate() {
-    if(getBuffs_)
-        buffs_->UpdateBuffsTable(getBuffs_());
+    GW2_PROFILE_SCOPE("Core::InnerFrequentUpdate");
+
+    if(!buffSource_)
+        return;
+
+    // Combat time is tracked on every update, backing off polling doesn't mean combat stopped
+    buffs_->UpdateStatsCombat(MumbleLink::i().isInCombat());
+    if(!buffPoller_.ShouldPoll())
+        return;
+
+    StackedBuff* buffs = buffSource_->GetBuffs();
+    UpdateBuffTrace(buffs);
+    // The table keeps its generation when nothing changed, so grids don't rebuild their instances either
+    if(buffPoller_.Changed(buffs))
+        buffs_->UpdateBuffsTable(buffs);
+}
+
+void Core::UpdateBuffTrace(const StackedBuff* buffs) {
+    using namespace std::chrono;
+
+    if(recordBuffTrace_ != buffTrace_.isOpen()) {
+        if(buffTrace_.isOpen()) {
+            LogInfo("Stopped recording buff trace after {} frames.", buffTrace_.frameCount());
+            buffTrace_.Close();
+        }
+        else {
+            wchar_t fn[MAX_PATH];
+            GetModuleFileName(dllModule(), fn, MAX_PATH);
+
+            std::filesystem::path tracePath = fn;
+            tracePath = tracePath.remove_filename() / std::format("buffs_{:%Y%m%d_%H%M%S}.trace", floor<seconds>(system_clock::now()));
+            if(buffTrace_.Open(tracePath))
+                LogInfo("Recording buff trace to {}.", tracePath.string());
+            else
+                recordBuffTrace_ = false;
+            buffTraceStart_ = steady_clock::now();
+        }
+    }
+
+    if(buffTrace_.isOpen())
+        buffTrace_.Record(u64(duration_cast<microseconds>(steady_clock::now() - buffTraceStart_).count()), buffs);
 }
 
 void Core::InnerUpdate() { }
@@ -100,6 +161,14 @@ void Core::DisplayDeletionMenu(DeletionInfo&& info) {
 }
 
 void Core::InnerDraw() {
+    GW2_PROFILE_SCOPE("Core::InnerDraw");
+
+#ifdef GW2CLARITY_ALLOCATION_TRACKING
+    const u64 allocations = ThreadAllocationCount();
+    lastFrameAllocations_ = allocations - frameAllocationsStart_;
+    frameAllocationsStart_ = allocations;
+#endif
+
     if(!confirmDeletionPopupID_)
         confirmDeletionPopupID_ = ImGui::GetID(ConfirmDeletionPopupName);
     if(ImGui::BeginPopupModal(ConfirmDeletionPopupName)) {
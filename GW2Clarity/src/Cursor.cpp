@@ -3,16 +3,19 @@
 #include <glm/gtc/type_ptr.hpp>
 #include <imgui.h>
 #include <misc/cpp/imgui_stdlib.h>
-#include <range/v3/all.hpp>
 
+#include "ConfigJson.h"
 #include "Core.h"
+#include "FixedLabel.h"
 #include "ImGuiExtensions.h"
+#include "Profiler.h"
 
 namespace GW2Clarity
 {
 
-Cursor::Cursor(ComPtr<ID3D11Device>& dev) : activateCursor_("activate_cursor", "Toggle Cursor", "General") {
-    Load();
+Cursor::Cursor(ComPtr<ID3D11Device>& dev, const ConfigSource& config)
+    : activateCursor_("activate_cursor", "Toggle Cursor", "General") {
+    Load(config.section("cursor_layers"));
 
     activateCursor_.callback([&](Activated a) {
         if(a == Activated::Yes)
@@ -45,6 +48,8 @@ Cursor::Cursor(ComPtr<ID3D11Device>& dev) : activateCursor_("activate_cursor", "
 Cursor::~Cursor() = default;
 
 void Cursor::Draw(ComPtr<ID3D11DeviceContext>& ctx) {
+    GW2_PROFILE_SCOPE("Cursor::Draw");
+
     if(!SettingsMenu::i().isVisible())
         selectedLayerId_ = UnselectedSubId;
 
@@ -86,24 +91,32 @@ void Cursor::Draw(ComPtr<ID3D11DeviceContext>& ctx) {
 void Cursor::DrawMenu(Keybind** currentEditedKeybind) {
     if(ImGui::BeginListBox("##LayersList", ImVec2(-FLT_MIN, 0.f))) {
         char newCurrentHovered = currentHoveredLayer_;
-        for(auto&& [lid, l] : layers_ | ranges::views::enumerate) {
-            if(ImGui::Selectable(std::format("{}##Layer", l.name).c_str(), selectedLayerId_ == lid || currentHoveredLayer_ == lid,
-                                 ImGuiSelectableFlags_AllowItemOverlap)) {
-                selectedLayerId_ = char(lid);
-            }
-
-            if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem) || ImGui::IsItemActive()) {
-                auto& style = ImGui::GetStyle();
-                auto orig = style.Colors[ImGuiCol_Button];
-                style.Colors[ImGuiCol_Button] *= ImVec4(0.5f, 0.5f, 0.5f, 1.f);
-                if(ImGuiClose(std::format("CloseLayer{}", lid).c_str(), 0.75f, false)) {
-                    selectedLayerId_ = char(lid);
-                    Core::i().DisplayDeletionMenu({ l.name, "cursor layer", "", selectedLayerId_ });
+        // Every row pushes its index, so that names are used as labels as they are rather than formatted each frame
+        ImGuiListClipper clipper;
+        clipper.Begin(i32(layers_.size()));
+        while(clipper.Step()) {
+            for(char lid = char(clipper.DisplayStart); lid < char(clipper.DisplayEnd); lid++) {
+                const auto& l = layers_[lid];
+                ImGui::PushID(lid);
+                if(ImGui::Selectable(l.name.c_str(), selectedLayerId_ == lid || currentHoveredLayer_ == lid,
+                                     ImGuiSelectableFlags_AllowItemOverlap)) {
+                    selectedLayerId_ = lid;
                 }
-                if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem))
-                    newCurrentHovered = char(lid);
 
-                style.Colors[ImGuiCol_Button] = orig;
+                if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem) || ImGui::IsItemActive()) {
+                    auto& style = ImGui::GetStyle();
+                    auto orig = style.Colors[ImGuiCol_Button];
+                    style.Colors[ImGuiCol_Button] *= ImVec4(0.5f, 0.5f, 0.5f, 1.f);
+                    if(ImGuiClose("CloseLayer", 0.75f, false)) {
+                        selectedLayerId_ = lid;
+                        Core::i().DisplayDeletionMenu({ l.name, "cursor layer", "", selectedLayerId_ });
+                    }
+                    if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem))
+                        newCurrentHovered = lid;
+
+                    style.Colors[ImGuiCol_Button] = orig;
+                }
+                ImGui::PopID();
             }
         }
         currentHoveredLayer_ = newCurrentHovered;
@@ -123,7 +136,7 @@ void Cursor::DrawMenu(Keybind** currentEditedKeybind) {
     if(selectedLayerId_ != UnselectedSubId) {
         auto& editLayer = layers_[selectedLayerId_];
         if(!editLayer.name.empty())
-            ImGuiTitle(std::format("Editing Cursor Layer '{}'", editLayer.name).c_str(), 0.75f);
+            ImGuiTitle(FixedLabel<>("Editing Cursor Layer '{}'", editLayer.name).c_str(), 0.75f);
         else
             ImGuiTitle("New Cursor Layer", 0.75f);
 
@@ -183,59 +196,44 @@ void Cursor::Delete(char id) {
     needsSaving_ = true;
 }
 
-void Cursor::Load() {
-    using namespace nlohmann;
+void Cursor::Load(const nlohmann::json& layers) {
+    GW2_PROFILE_SCOPE("Cursor::Load");
+
     layers_.clear();
     selectedLayerId_ = UnselectedSubId;
 
-    auto& cfg = JSONConfigurationFile::i();
-    cfg.Reload();
-
-    auto maybe_at = []<typename D>(const json& j, const char* n, const D& def,
-                                   const std::variant<std::monostate, std::function<D(const json&)>>& cvt = {}) {
-        auto it = j.find(n);
-        if(it == j.end())
-            return def;
-        if(cvt.index() == 0)
-            return static_cast<D>(*it);
-        else
-            return std::get<1>(cvt)(*it);
-    };
-
-    auto getvec4 = [](const json& j) {
-        return vec4(j[0].get<f32>(), j[1].get<f32>(), j[2].get<f32>(), j[3].get<f32>());
-    };
-    auto getvec2 = [](const json& j) {
-        return vec2(j[0].get<f32>(), j[1].get<f32>());
-    };
-
-    const auto& layers = cfg.json()["cursor_layers"];
     for(const auto& lIn : layers) {
         Layer l {};
         l.name = lIn["name"];
-        l.color1 = maybe_at(lIn, "color1", vec4(1.f), { getvec4 });
-        l.color2 = maybe_at(lIn, "color2", vec4(1.f), { getvec4 });
-        l.invert = maybe_at(lIn, "invert", false);
-        l.fullscreen = maybe_at(lIn, "fullscreen", false);
+        l.color1 = ReadOr(lIn, "color1", vec4(1.f));
+        l.color2 = ReadOr(lIn, "color2", vec4(1.f));
+        l.invert = ReadOr(lIn, "invert", false);
+        l.fullscreen = ReadOr(lIn, "fullscreen", false);
         if(!l.fullscreen)
-            l.dims = maybe_at(lIn, "dims", vec2(32.f), { getvec2 });
-        l.edgeThickness = maybe_at(lIn, "edge_thickness", 1.f);
-        l.secondaryThickness = maybe_at(lIn, "secondary_thickness", 4.f);
-        l.angle = maybe_at(lIn, "angle", 0.f);
-        l.type = CursorType(maybe_at(lIn, "type", 0));
+            l.dims = ReadOr(lIn, "dims", vec2(32.f));
+        l.edgeThickness = ReadOr(lIn, "edge_thickness", 1.f);
+        l.secondaryThickness = ReadOr(lIn, "secondary_thickness", 4.f);
+        l.angle = ReadOr(lIn, "angle", 0.f);
+        l.type = CursorType(ReadOr(lIn, "type", 0));
 
         layers_.push_back(l);
     }
 }
 
 void Cursor::Save() {
-    using namespace nlohmann;
+    GW2_PROFILE_SCOPE("Cursor::Save");
+
+    Core::i().configPersistence().Submit("cursor_layers", [layers = layers_] { return SaveLayers(layers); });
 
-    auto& cfg = JSONConfigurationFile::i();
+    needsSaving_ = false;
+    lastSaveTime_ = TimeInMilliseconds();
+}
 
-    auto& layers = cfg.json()["cursor_layers"];
-    layers = json::array();
-    for(const auto& l : layers_) {
+nlohmann::json Cursor::SaveLayers(std::span<const Layer> layers) {
+    using namespace nlohmann;
+
+    json out = json::array();
+    for(const auto& l : layers) {
         json layer;
         layer["name"] = l.name;
         layer["color1"] = { l.color1.x, l.color1.y, l.color1.z, l.color1.w };
@@ -249,13 +247,10 @@ void Cursor::Save() {
         layer["angle"] = l.angle;
         layer["type"] = i32(l.type);
 
-        layers.push_back(layer);
+        out.push_back(layer);
     }
 
-    cfg.Save();
-
-    needsSaving_ = false;
-    lastSaveTime_ = TimeInMilliseconds();
+    return out;
 }
 
 } // namespace GW2Clarity
@@ -0,0 +1,367 @@
+#include "GridConfig.h"
+
+#include "ConfigJson.h"
+
+namespace GW2Clarity
+{
+
+void CompileStackSources(std::span<Grid> grids, const BuffSlotMap& slots, std::vector<u32>& stackSources) {
+    auto addBuff = [&](const Buff* b) {
+        if(!b || b->slot == BuffSlotMap::InvalidSlot)
+            return;
+
+        stackSources.push_back(b->slot);
+        for(u32 id : b->extraIds)
+            if(u32 slot = slots[id]; slot != BuffSlotMap::InvalidSlot)
+                stackSources.push_back(slot);
+    };
+
+    stackSources.clear();
+    for(auto& g : grids) {
+        for(auto& i : g.items) {
+            i.firstStackSource = u32(stackSources.size());
+            addBuff(i.buff);
+            for(const Buff* b : i.additionalBuffs)
+                addBuff(b);
+            i.stackSourceCount = u32(stackSources.size()) - i.firstStackSource;
+        }
+    }
+}
+
+void GridDependencyIndex::Build(std::span<const Grid> grids, std::span<const u32> stackSources, size_t slotCount) {
+    // An item may list a slot more than once, e.g. when an additional buff repeats its primary one
+    auto forEachDependency = [&](auto&& f) {
+        for(size_t gid = 0; gid < grids.size(); gid++)
+            for(size_t iid = 0; iid < grids[gid].items.size(); iid++) {
+                const GridItem& i = grids[gid].items[iid];
+                const auto sources = stackSources.subspan(i.firstStackSource, i.stackSourceCount);
+                for(auto it = sources.begin(); it != sources.end(); ++it)
+                    if(std::find(sources.begin(), it, *it) == it)
+                        f(*it, Id(gid, iid));
+            }
+    };
+
+    // Counting sort by slot, which keeps items in order within every slot
+    offsets_.assign(slotCount + 1, 0);
+    forEachDependency([&](u32 slot, Id) { offsets_[slot + 1]++; });
+    for(size_t s = 0; s < slotCount; s++)
+        offsets_[s + 1] += offsets_[s];
+
+    items_.assign(offsets_.back(), Unselected());
+    std::vector<u32> next(offsets_.begin(), offsets_.end() - 1);
+    forEachDependency([&](u32 slot, Id id) { items_[next[slot]++] = id; });
+}
+
+PackedGridInstanceData BuildGridInstance(const Grid& g, i16 iid, const vec2& origin, const vec2& screen, const StyleTable& styles,
+                                         std::span<const i32> counts, std::span<const u32> stackSources, i16 editingItem,
+                                         i32 editingCount) {
+    const GridItem& i = g.items[iid];
+
+    const bool editing = iid == editingItem;
+    const i32 count = editing ? editingCount : CountStacks(counts, stackSources, i);
+
+    GridInstanceData inst;
+    inst.posDims = vec4(origin + vec2(i.pos * g.spacing), AdjustToArea(128.f, 128.f, f32(g.spacing.x))) / vec4(screen, screen);
+    inst.atlasSlot = i.buff->atlasSlot;
+    inst.number = i.buff->ShowNumber(count) ? count : 0;
+
+    styles.ApplyStyle(i.style, count, inst);
+
+    if(editing) {
+        inst.highlight = true;
+        inst.borderThickness = std::max(inst.borderThickness, 1.f);
+    }
+
+    return Pack(inst);
+}
+
+GridItemData BuildGridItemData(const Grid& g, i16 iid, u32 gridIndex, const StyleTable& styles, bool editing, i32 editingCount) {
+    const GridItem& i = g.items[iid];
+
+    GridItemData item;
+    item.offset = vec2(i.pos * g.spacing);
+    item.dims = AdjustToArea(128.f, 128.f, f32(g.spacing.x));
+    item.grid = gridIndex;
+    item.firstStackSource = i.firstStackSource;
+    item.stackSourceCount = i.stackSourceCount;
+    item.firstAppearance = styles.AppearanceTableRow(i.style);
+    item.appearanceCount = styles.AppearanceRowCount(i.style);
+    item.atlasSlot = i.buff->atlasSlot;
+    item.flags = (i.buff->maxStacks > 1 ? u32(GridItemData::ShowNumber) : 0) | (editing ? u32(GridItemData::Editing) : 0);
+    item.fixedCount = editing ? editingCount : 0;
+    return item;
+}
+
+void BuildGridInstances(const Grid& g, const vec2& origin, const vec2& screen, const StyleTable& styles, std::span<const i32> counts,
+                        std::span<const u32> stackSources, i16 editingItem, i32 editingCount, std::vector<PackedGridInstanceData>& out) {
+    for(i16 iid = 0; iid < i16(g.items.size()); iid++)
+        out.push_back(BuildGridInstance(g, iid, origin, screen, styles, counts, stackSources, editingItem, editingCount));
+}
+
+std::vector<Grid> LoadGrids(const nlohmann::json& grids, const BuffCatalog& catalog, const StyleTable& styles) {
+    using namespace nlohmann;
+
+    auto getBuff = [&](const json& j) -> const Buff* {
+        i32 id = j;
+        return catalog.find(u32(id));
+    };
+
+    std::vector<Grid> out;
+    for(const auto& gIn : grids) {
+        Grid g;
+        g.spacing = ReadOr(gIn, "spacing", ivec2(32, 32));
+        g.offset = ReadOr(gIn, "offset", ivec2());
+        g.attached = ReadOr(gIn, "attached", false);
+        g.centralWeight = ReadOr(gIn, "central_weight", 0.f);
+        g.mouseClipMin = ReadOr(gIn, "mouse_clip_min", ivec2 { std::numeric_limits<i32>::max() });
+        g.mouseClipMax = ReadOr(gIn, "mouse_clip_max", ivec2 { std::numeric_limits<i32>::min() });
+        g.trackMouseWhileHeld = ReadOr(gIn, "track_mouse_while_held", true);
+        g.square = ReadOr(gIn, "square", true);
+        g.name = gIn["name"];
+
+        for(const auto& iIn : gIn["items"]) {
+            GridItem i;
+            i.pos = FromJson<ivec2>(iIn["pos"]);
+            i.buff = getBuff(iIn["buff_id"]);
+            i.style = styles.FindStyle(ReadOr(iIn, "style", std::string {}));
+
+            if(iIn.contains("additional_buff_ids"))
+                for(auto& bIn : iIn["additional_buff_ids"])
+                    if(const Buff* b = getBuff(bIn); b)
+                        i.additionalBuffs.push_back(b);
+
+            if(!i.buff) {
+                i.buff = &UnknownBuff;
+                LogWarn("Configuration has unknown buff: Grid '{}', location ({}, {}), buff ID '{}'.", g.name, i.pos.x, i.pos.y,
+                        static_cast<i32>(iIn["buff_id"]));
+            }
+
+            if(!i.buff && !i.additionalBuffs.empty()) {
+                i.buff = i.additionalBuffs.back();
+                i.additionalBuffs.pop_back();
+            }
+
+            g.items.push_back(std::move(i));
+        }
+        out.push_back(std::move(g));
+    }
+
+    return out;
+}
+
+namespace
+{
+// json_sax handler building grids out of "buff_grids" as they are read, skipping the rest of the document. depth_ counts the containers
+// around the current value: the document, the grid array, a grid, a grid's array member, an item and an item's array member.
+class GridsReader
+{
+public:
+    GridsReader(const BuffCatalog& catalog, const StyleTable& styles) : catalog_(catalog), styles_(styles) { }
+
+    std::vector<Grid> grids;
+
+    bool null() { return true; }
+    bool boolean(bool v) {
+        if(Within(3))
+            if(bool* member = GridFlag())
+                *member = v;
+        return true;
+    }
+    bool number_integer(i64 v) { return Number(f64(v)); }
+    bool number_unsigned(u64 v) { return Number(f64(v)); }
+    bool number_float(f64 v, const std::string&) { return Number(v); }
+    bool string(std::string& v) {
+        if(Within(3) && gridKey_ == "name")
+            grids.back().name = std::move(v);
+        else if(Within(5) && itemKey_ == "style")
+            grids.back().items.back().style = styles_.FindStyle(v);
+        return true;
+    }
+    bool binary(nlohmann::json::binary_t&) { return true; }
+
+    bool key(std::string& k) {
+        if(depth_ == 1)
+            inGrids_ = k == "buff_grids";
+        else if(Within(3))
+            gridKey_ = std::move(k);
+        else if(Within(5))
+            itemKey_ = std::move(k);
+        return true;
+    }
+
+    bool start_object(size_t) {
+        Open(true);
+        if(Within(3)) {
+            // As in LoadGrids, which has its own spacing default
+            grids.emplace_back().spacing = ivec2(32, 32);
+            unknownItems_.clear();
+        }
+        else if(Within(5)) {
+            grids.back().items.emplace_back();
+            buffId_ = 0;
+        }
+        return true;
+    }
+    bool end_object() {
+        if(Within(5))
+            FinishItem();
+        else if(Within(3))
+            FinishGrid();
+        depth_--;
+        return true;
+    }
+    bool start_array(size_t) {
+        Open(false);
+        element_ = 0;
+        return true;
+    }
+    bool end_array() {
+        depth_--;
+        return true;
+    }
+
+    bool parse_error(size_t position, const std::string&, const nlohmann::detail::exception& e) {
+        LogError("Could not read grids from configuration at offset {}: {}", position, e.what());
+        return false;
+    }
+
+private:
+    void Open(bool object) {
+        depth_++;
+        if(depth_ < 64)
+            objects_ = object ? objects_ | u64(1) << depth_ : objects_ & ~(u64(1) << depth_);
+    }
+
+    // Whether the current value is directly within a container at the given depth of "buff_grids", every container around it having
+    // the expected type, objects at odd depths and arrays at even ones
+    [[nodiscard]] bool Within(u32 depth) const {
+        constexpr u64 ExpectedObjects = 0xAAAAAAAAAAAAAAAAull;
+        const u64 mask = (u64(2) << depth) - 2;
+        return inGrids_ && depth_ == depth && ((objects_ ^ ExpectedObjects) & mask) == 0;
+    }
+
+    [[nodiscard]] bool* GridFlag() {
+        auto& g = grids.back();
+        if(gridKey_ == "attached")
+            return &g.attached;
+        if(gridKey_ == "track_mouse_while_held")
+            return &g.trackMouseWhileHeld;
+        if(gridKey_ == "square")
+            return &g.square;
+        return nullptr;
+    }
+
+    [[nodiscard]] ivec2* GridVector() {
+        auto& g = grids.back();
+        if(gridKey_ == "spacing")
+            return &g.spacing;
+        if(gridKey_ == "offset")
+            return &g.offset;
+        if(gridKey_ == "mouse_clip_min")
+            return &g.mouseClipMin;
+        if(gridKey_ == "mouse_clip_max")
+            return &g.mouseClipMax;
+        return nullptr;
+    }
+
+    [[nodiscard]] const Buff* FindBuff(i32 id) const { return catalog_.find(u32(id)); }
+
+    bool Number(f64 v) {
+        if(Within(3) && gridKey_ == "central_weight")
+            grids.back().centralWeight = f32(v);
+        else if(Within(4)) {
+            if(ivec2* member = GridVector(); member && element_ < 2)
+                (*member)[element_++] = i32(v);
+        }
+        else if(Within(5) && itemKey_ == "buff_id")
+            buffId_ = i32(v);
+        else if(Within(6)) {
+            auto& i = grids.back().items.back();
+            if(itemKey_ == "pos" && element_ < 2)
+                i.pos[element_++] = i32(v);
+            else if(itemKey_ == "additional_buff_ids")
+                if(const Buff* b = FindBuff(i32(v)))
+                    i.additionalBuffs.push_back(b);
+        }
+        return true;
+    }
+
+    void FinishItem() {
+        auto& items = grids.back().items;
+        if(const Buff* b = FindBuff(buffId_))
+            items.back().buff = b;
+        else
+            unknownItems_.emplace_back(items.size() - 1, buffId_);
+    }
+
+    // Warnings wait for the grid's name, which is usually written after its items
+    void FinishGrid() {
+        const auto& g = grids.back();
+        for(auto [index, id] : unknownItems_)
+            LogWarn("Configuration has unknown buff: Grid '{}', location ({}, {}), buff ID '{}'.", g.name, g.items[index].pos.x,
+                    g.items[index].pos.y, id);
+    }
+
+    const BuffCatalog& catalog_;
+    const StyleTable& styles_;
+
+    u32 depth_ = 0;
+    // Bit d is set if the container at depth d is an object
+    u64 objects_ = 0;
+    bool inGrids_ = false;
+    std::string gridKey_, itemKey_;
+    u32 element_ = 0;
+    i32 buffId_ = 0;
+    std::vector<std::pair<size_t, i32>> unknownItems_;
+};
+} // namespace
+
+std::optional<std::vector<Grid>> StreamGrids(std::istream& config, const BuffCatalog& catalog, const StyleTable& styles) {
+    GridsReader reader(catalog, styles);
+    if(!nlohmann::json::sax_parse(config, &reader))
+        return std::nullopt;
+
+    return std::move(reader.grids);
+}
+
+nlohmann::json SaveGrids(std::span<const Grid> grids, std::span<const std::string> styleNames) {
+    using namespace nlohmann;
+
+    json out = json::array();
+    for(const auto& g : grids) {
+        json grid;
+        grid["spacing"] = { g.spacing.x, g.spacing.y };
+        grid["offset"] = { g.offset.x, g.offset.y };
+        grid["attached"] = g.attached;
+        grid["central_weight"] = g.centralWeight;
+        grid["mouse_clip_min"] = { g.mouseClipMin.x, g.mouseClipMin.y };
+        grid["mouse_clip_max"] = { g.mouseClipMax.x, g.mouseClipMax.y };
+        grid["track_mouse_while_held"] = g.trackMouseWhileHeld;
+        grid["square"] = g.square;
+        grid["name"] = g.name;
+
+        json& gridItems = grid["items"];
+
+        for(const auto& i : g.items) {
+            json item;
+            item["pos"] = { i.pos.x, i.pos.y };
+            item["buff_id"] = i.buff->id;
+            item["style"] = i.style < styleNames.size() ? styleNames[i.style] : styleNames.front();
+
+            if(!i.additionalBuffs.empty()) {
+                json buffs = json::array();
+                for(const auto* b : i.additionalBuffs)
+                    buffs.push_back(b->id);
+                item["additional_buff_ids"] = buffs;
+            }
+
+            gridItems.push_back(item);
+        }
+
+        out.push_back(grid);
+    }
+
+    return out;
+}
+
+} // namespace GW2Clarity
@@ -1,12 +1,13 @@
 #include "GridRenderer.h"
 
 #include "Core.h"
+#include "GridAnimation.h"
+#include "Profiler.h"
 
 namespace GW2Clarity
 {
 
-BaseGridRenderer::BaseGridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs, size_t sz)
-    : buffs_(buffs), bufferSize_(sz * sizeof(InstanceData)) {
+BaseGridRenderer::BaseGridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs, size_t sz) : buffs_(buffs), device_(dev) {
     auto& sm = ShaderManager::i();
 
     gridCB_ = ShaderManager::i().MakeConstantBuffer<GridConstants>();
@@ -15,25 +16,7 @@ BaseGridRenderer::BaseGridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs
     gridsPS_ = sm.GetShader(L"Grids.hlsl", D3D11_SHVER_PIXEL_SHADER, "Grids_PS");
     gridsFilteredPS_ = sm.GetShader(L"Grids.hlsl", D3D11_SHVER_PIXEL_SHADER, "FilteredGrids_PS");
 
-    D3D11_BUFFER_DESC instanceBufferDesc;
-
-    instanceBufferDesc.Usage = D3D11_USAGE_DYNAMIC;
-    instanceBufferDesc.ByteWidth = UINT(sizeof(InstanceData) * sz);
-    instanceBufferDesc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-    instanceBufferDesc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
-    instanceBufferDesc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
-    instanceBufferDesc.StructureByteStride = sizeof(InstanceData);
-
-    GW2_CHECKED_HRESULT(dev->CreateBuffer(&instanceBufferDesc, nullptr, instanceBuffer_.GetAddressOf()));
-
-    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
-
-    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
-    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
-    srvDesc.Buffer.FirstElement = 0;
-    srvDesc.Buffer.NumElements = UINT(sz);
-
-    GW2_CHECKED_HRESULT(dev->CreateShaderResourceView(instanceBuffer_.Get(), &srvDesc, instanceBufferView_.GetAddressOf()));
+    CreateInstanceBuffer(std::max<size_t>(sz, 1));
 
     CD3D11_BLEND_DESC blendDesc(D3D11_DEFAULT);
     blendDesc.RenderTarget[0].BlendEnable = true;
@@ -47,23 +30,51 @@ BaseGridRenderer::BaseGridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs
     GW2_CHECKED_HRESULT(dev->CreateSamplerState(&samplerDesc, defaultSampler_.GetAddressOf()));
 }
 
-void BaseGridRenderer::Draw(ComPtr<ID3D11DeviceContext>& ctx, std::span<InstanceData> data, bool betterFiltering, RenderTarget* rt,
-                            bool expandVS) {
-    D3D11_MAPPED_SUBRESOURCE map;
-    ctx->Map(instanceBuffer_.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
-    memcpy_s(map.pData, bufferSize_, data.data(), data.size_bytes());
-    ctx->Unmap(instanceBuffer_.Get(), 0);
+void BaseGridRenderer::CreateStructuredBuffer(StructuredBuffer& buffer, size_t stride, size_t capacity, const void* data) {
+    buffer = {};
+
+    D3D11_BUFFER_DESC desc;
+
+    desc.Usage = data ? D3D11_USAGE_IMMUTABLE : D3D11_USAGE_DYNAMIC;
+    desc.ByteWidth = UINT(stride * capacity);
+    desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+    desc.CPUAccessFlags = data ? 0 : D3D11_CPU_ACCESS_WRITE;
+    desc.MiscFlags = D3D11_RESOURCE_MISC_BUFFER_STRUCTURED;
+    desc.StructureByteStride = UINT(stride);
 
-    ID3D11ShaderResourceView* srvs[] = { instanceBufferView_.Get(), buffs_->buffsAtlas().srv.Get(), buffs_->numbersAtlas().srv.Get() };
-    ctx->VSSetShaderResources(0, 3, srvs);
-    ctx->PSSetShaderResources(0, 3, srvs);
+    D3D11_SUBRESOURCE_DATA initialData { data, 0, 0 };
+
+    GW2_CHECKED_HRESULT(device_->CreateBuffer(&desc, data ? &initialData : nullptr, buffer.buffer.GetAddressOf()));
+
+    D3D11_SHADER_RESOURCE_VIEW_DESC srvDesc;
+
+    srvDesc.Format = DXGI_FORMAT_UNKNOWN;
+    srvDesc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+    srvDesc.Buffer.FirstElement = 0;
+    srvDesc.Buffer.NumElements = UINT(capacity);
+
+    GW2_CHECKED_HRESULT(device_->CreateShaderResourceView(buffer.buffer.Get(), &srvDesc, buffer.srv.GetAddressOf()));
+
+    buffer.capacity = capacity;
+}
+
+void BaseGridRenderer::CreateInstanceBuffer(size_t capacity) {
+    CreateStructuredBuffer(instanceBuffer_, sizeof(InstanceData), capacity, nullptr);
+    stats_.capacity = capacity;
+}
+
+D3D11_VIEWPORT BaseGridRenderer::BeginDraw(ComPtr<ID3D11DeviceContext>& ctx, ShaderId vs, bool betterFiltering, RenderTarget* rt) {
+    ID3D11ShaderResourceView* srvs[] = { instanceBuffer_.srv.Get(), buffs_->buffsAtlas().srv.Get(), buffs_->numbersAtlas().srv.Get(),
+                                         buffs_->atlasUVs().Get(), buffs_->numberUVs().Get() };
+    ctx->VSSetShaderResources(0, UINT(std::size(srvs)), srvs);
+    ctx->PSSetShaderResources(0, UINT(std::size(srvs)), srvs);
     ctx->IASetVertexBuffers(0, 0, nullptr, nullptr, nullptr);
     ctx->IASetInputLayout(nullptr);
     ctx->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP);
 
     auto& cb = *gridCB_;
 
-    D3D11_VIEWPORT oldVP;
+    D3D11_VIEWPORT oldVP {};
     auto& sm = ShaderManager::i();
     if(rt) {
         UINT numVPs = 1;
@@ -87,10 +98,10 @@ void BaseGridRenderer::Draw(ComPtr<ID3D11DeviceContext>& ctx, std::span<Instance
         cb->screenSize = vec4(Core::i().screenDims(), 1.f / Core::i().screenDims());
     cb->atlasUVSize = buffs_->buffsAtlasUVSize();
     cb->numbersUVSize = buffs_->numbersAtlasUVSize();
-    cb->time = fmod(TimeInMilliseconds() / 1000.f, 60.f);
+    cb->time = WrapAnimationTime(TimeInMilliseconds());
     cb.Update(ctx.Get());
     sm.SetConstantBuffers(ctx.Get(), cb);
-    sm.SetShaders(ctx.Get(), expandVS ? screenSpaceVS_ : screenSpaceNoExpandVS_, betterFiltering ? gridsFilteredPS_ : gridsPS_);
+    sm.SetShaders(ctx.Get(), vs, betterFiltering ? gridsFilteredPS_ : gridsPS_);
 
     ID3D11SamplerState* samplers[] = { defaultSampler_.Get() };
     ctx->PSSetSamplers(0, 1, samplers);
@@ -102,8 +113,10 @@ void BaseGridRenderer::Draw(ComPtr<ID3D11DeviceContext>& ctx, std::span<Instance
         ctx->OMSetRenderTargets(1, rtvs, nullptr);
     }
 
-    ctx->DrawInstanced(4, UINT(data.size()), 0, 0);
+    return oldVP;
+}
 
+void BaseGridRenderer::EndDraw(ComPtr<ID3D11DeviceContext>& ctx, RenderTarget* rt, const D3D11_VIEWPORT& oldVP) {
     if(rt) {
         ID3D11RenderTargetView* rtvs[] = { Core::i().backBufferRTV().Get() };
         ctx->OMSetRenderTargets(1, rtvs, nullptr);
@@ -111,4 +124,93 @@ void BaseGridRenderer::Draw(ComPtr<ID3D11DeviceContext>& ctx, std::span<Instance
     }
 }
 
+void BaseGridRenderer::Draw(ComPtr<ID3D11DeviceContext>& ctx, std::span<const InstanceData> data, bool upload, bool betterFiltering,
+                            RenderTarget* rt, bool expandVS) {
+    GW2_PROFILE_SCOPE("BaseGridRenderer::Draw");
+
+    if(upload) {
+        uploadedCount_ = data.size();
+        stats_.highWaterMark = std::max(stats_.highWaterMark, uploadedCount_);
+
+        if(size_t capacity = GridBufferPolicy::GrowCapacity(instanceBuffer_.capacity, uploadedCount_); capacity != instanceBuffer_.capacity)
+            CreateInstanceBuffer(capacity);
+    }
+
+    stats_.batches = 0;
+    if(uploadedCount_ == 0)
+        return;
+
+    const size_t capacity = instanceBuffer_.capacity;
+    const u32 batches = GridBufferPolicy::BatchCount(uploadedCount_, capacity);
+    GW2_ASSERT(upload || batches == 1);
+
+    const auto oldVP = BeginDraw(ctx, expandVS ? screenSpaceVS_ : screenSpaceNoExpandVS_, betterFiltering, rt);
+
+    for(u32 b = 0; b < batches; b++) {
+        const auto [first, count] = GridBufferPolicy::BatchRange(b, uploadedCount_, capacity);
+
+        if(upload) {
+            GW2_PROFILE_SCOPE("BaseGridRenderer::Draw upload");
+            const auto batch = data.subspan(first, count);
+            D3D11_MAPPED_SUBRESOURCE map;
+            ctx->Map(instanceBuffer_.buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &map);
+            memcpy_s(map.pData, capacity * sizeof(InstanceData), batch.data(), batch.size_bytes());
+            ctx->Unmap(instanceBuffer_.buffer.Get(), 0);
+        }
+
+        ctx->DrawInstanced(4, UINT(count), 0, 0);
+    }
+    stats_.batches = batches;
+
+    EndDraw(ctx, rt, oldVP);
+}
+
+EvaluatedGridRenderer::EvaluatedGridRenderer(ComPtr<ID3D11Device>& dev, const Buffs* buffs) : BaseGridRenderer(dev, buffs, 1) {
+    gridsEvaluatedVS_ = ShaderManager::i().GetShader(L"Grids.hlsl", D3D11_SHVER_VERTEX_SHADER, "GridsEvaluated_VS");
+    CreateStructuredBuffer(counts_, sizeof(i32), std::max<size_t>(buffs->buffSlots().size(), 1), nullptr);
+}
+
+void EvaluatedGridRenderer::SetItems(std::span<const GridItemData> items, std::span<const u32> stackSources) {
+    itemCount_ = items.size();
+    items_ = {};
+    stackSources_ = {};
+
+    if(!items.empty())
+        CreateStructuredBuffer(items_, sizeof(GridItemData), items.size(), items.data());
+    if(!stackSources.empty())
+        CreateStructuredBuffer(stackSources_, sizeof(u32), stackSources.size(), stackSources.data());
+}
+
+void EvaluatedGridRenderer::SetAppearances(std::span<const PackedGridAppearanceInterval> appearances) {
+    GW2_ASSERT(!appearances.empty());
+    CreateStructuredBuffer(appearances_, sizeof(PackedGridAppearanceInterval), appearances.size(), appearances.data());
+}
+
+void EvaluatedGridRenderer::Draw(ComPtr<ID3D11DeviceContext>& ctx, const ActiveBuffsTable& activeBuffs, std::span<const vec2> gridOrigins,
+                                 bool betterFiltering) {
+    GW2_PROFILE_SCOPE("EvaluatedGridRenderer::Draw");
+
+    stats_.batches = 0;
+    if(itemCount_ == 0 || gridOrigins.empty())
+        return;
+
+    if(uploadedCountsGeneration_ != activeBuffs.generation() && !activeBuffs.counts().empty()) {
+        Upload(ctx, counts_, activeBuffs.counts());
+        uploadedCountsGeneration_ = activeBuffs.generation();
+    }
+    Upload(ctx, gridOrigins_, gridOrigins);
+
+    const auto oldVP = BeginDraw(ctx, gridsEvaluatedVS_, betterFiltering, nullptr);
+
+    ID3D11ShaderResourceView* srvs[] = { items_.srv.Get(), stackSources_.srv.Get(), appearances_.srv.Get(), counts_.srv.Get(),
+                                         gridOrigins_.srv.Get() };
+    ctx->VSSetShaderResources(5, UINT(std::size(srvs)), srvs);
+
+    ctx->DrawInstanced(4, UINT(itemCount_), 0, 0);
+    stats_.highWaterMark = std::max(stats_.highWaterMark, itemCount_);
+    stats_.batches = 1;
+
+    EndDraw(ctx, nullptr, oldVP);
+}
+
 } // namespace GW2Clarity
@@ -8,31 +8,19 @@
 #include <range/v3/all.hpp>
 
 #include "Core.h"
+#include "FixedLabel.h"
 #include "ImGuiExtensions.h"
+#include "Profiler.h"
 
 namespace GW2Clarity
 {
-template<VectorLike<f32, 2> T>
-T AdjustToArea(f32 w, f32 h, f32 availW) {
-    T dims(w, h);
-    if(dims.x < dims.y)
-        dims.x = dims.y * w / h;
-    else if(dims.x > dims.y)
-        dims.y = dims.x * h / w;
-
-    if(availW < dims.x) {
-        dims.y *= availW / dims.x;
-        dims.x = availW;
-    }
-
-    return dims;
-}
-
-Grids::Grids(ComPtr<ID3D11Device>& dev, const Buffs* buffs, const Styles* styles)
-    : enableBetterFiltering_("Enable better texture filtering", "better_tex_filtering", "Grids", true)
+Grids::Grids(ComPtr<ID3D11Device>& dev, const Buffs* buffs, const Styles* styles, const ConfigSource& config)
+    : enableBetterFiltering_(Core::i().configPersistence(), "Enable better texture filtering", "better_tex_filtering", "Grids", true)
+    , enableGpuEvaluation_(Core::i().configPersistence(), "Evaluate grids on the GPU", "gpu_evaluation", "Grids", false)
     , buffs_(buffs)
     , styles_(styles)
     , gridRenderer_(dev, buffs)
+    , evaluatedRenderer_(dev, buffs)
     , selector_(buffs, "") {
     Input::i().mouseButtonEvent().AddCallback([&](EventKey ek, bool&) {
         bool wasHolding = holdingMouseButton_ != ScanCode::None;
@@ -43,7 +31,7 @@ Grids::Grids(ComPtr<ID3D11Device>& dev, const Buffs* buffs, const Styles* styles
             heldMousePos_ = ImGui::GetIO().MousePos;
     });
 
-    Load();
+    Load(config);
 
     SettingsMenu::i().AddImplementer(this);
 }
@@ -58,7 +46,7 @@ void Grids::DrawEditingGrid() {
         const vec2 mouse { ImGui::GetIO().MousePos.x, ImGui::GetIO().MousePos.y };
 
         const auto& sp = grid().spacing;
-        auto c = grid().ComputeOrigin(*this, !testMouseMode_, screen, mouse);
+        auto c = grid().ComputeOrigin(!testMouseMode_, screen, mouseState(mouse));
         auto* cmdList = ImGui::GetBackgroundDrawList();
         cmdList->PushClipRectFullScreen();
 
@@ -108,29 +96,38 @@ void Grids::DrawGridList() {
         ImGui::TableNextRow();
         ImGui::TableNextColumn();
         if(ImGui::BeginListBox("##GridsList", ImVec2(-FLT_MIN, 0.f))) {
-            for(auto it : grids_ | ranges::views::enumerate) {
-                // Need explicit types to shut up IntelliSense, still present as of 17.5.1
-                i16 gid = i16(it.first);
-                Grid& g = it.second;
-
-                auto u = Unselected(gid);
-                if(ImGui::Selectable(std::format("{} ({}x{})##{}", g.name, g.spacing.x, g.spacing.y, gid).c_str(),
-                                     selectedId_ == u || currentHovered_ == u, ImGuiSelectableFlags_AllowItemOverlap)) {
-                    selectedId_ = u;
-                }
-
-                if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem) || ImGui::IsItemActive()) {
-                    auto& style = ImGui::GetStyle();
-                    auto orig = style.Colors[ImGuiCol_Button];
-                    style.Colors[ImGuiCol_Button] *= ImVec4(0.5f, 0.5f, 0.5f, 1.f);
-                    if(ImGuiClose(std::format("CloseGrid{}", gid).c_str(), 0.75f, false)) {
+            gridLabels_.Update(grids_.size(), [&](size_t gid, std::string& out) {
+                const Grid& g = grids_[gid];
+                std::format_to(std::back_inserter(out), "{} ({}x{})##{}", g.name, g.spacing.x, g.spacing.y, gid);
+            });
+
+            ImGuiListClipper clipper;
+            clipper.Begin(i32(grids_.size()));
+            while(clipper.Step()) {
+                for(i16 gid = i16(clipper.DisplayStart); gid < i16(clipper.DisplayEnd); gid++) {
+                    Grid& g = grids_[gid];
+
+                    auto u = Unselected(gid);
+                    if(ImGui::Selectable(gridLabels_[gid], selectedId_ == u || currentHovered_ == u,
+                                         ImGuiSelectableFlags_AllowItemOverlap)) {
                         selectedId_ = u;
-                        Core::i().DisplayDeletionMenu({ g.name, "grid", "", selectedId_ });
                     }
-                    if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem))
-                        newCurrentHovered = u;
 
-                    style.Colors[ImGuiCol_Button] = orig;
+                    if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem) || ImGui::IsItemActive()) {
+                        auto& style = ImGui::GetStyle();
+                        auto orig = style.Colors[ImGuiCol_Button];
+                        style.Colors[ImGuiCol_Button] *= ImVec4(0.5f, 0.5f, 0.5f, 1.f);
+                        ImGui::PushID(gid);
+                        if(ImGuiClose("CloseGrid", 0.75f, false)) {
+                            selectedId_ = u;
+                            Core::i().DisplayDeletionMenu({ g.name, "grid", "", selectedId_ });
+                        }
+                        ImGui::PopID();
+                        if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem))
+                            newCurrentHovered = u;
+
+                        style.Colors[ImGuiCol_Button] = orig;
+                    }
                 }
             }
 
@@ -149,29 +146,43 @@ void Grids::DrawGridList() {
             if(selectedId_.grid != UnselectedSubId) {
                 auto& g = grid();
                 auto gid = selectedId_.grid;
-                for(auto it : g.items | ranges::views::enumerate) {
-                    // Need explicit types to shut up IntelliSense, still present as of 17.5.1
-                    i16 iid = it.first;
-                    Item& i = it.second;
-
-                    Id id { gid, iid };
-                    std::string name = std::format("{} ({}, {})##{}", i.buff->name.c_str(), i.pos.x, i.pos.y, iid);
-                    if(ImGui::Selectable(name.c_str(), selectedId_ == id || currentHovered_ == id, ImGuiSelectableFlags_AllowItemOverlap)) {
-                        selectedId_ = id;
-                    }
-
-                    if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem) || ImGui::IsItemActive()) {
-                        auto& style = ImGui::GetStyle();
-                        auto orig = style.Colors[ImGuiCol_Button];
-                        style.Colors[ImGuiCol_Button] *= ImVec4(0.5f, 0.5f, 0.5f, 1.f);
-                        if(ImGuiClose(std::format("CloseItem{}", id.id).c_str(), 0.75f, false)) {
+                if(itemLabelsGrid_ != gid) {
+                    itemLabels_.Invalidate();
+                    itemLabelsGrid_ = gid;
+                }
+                itemLabels_.Update(g.items.size(), [&](size_t iid, std::string& out) {
+                    const Item& i = g.items[iid];
+                    std::format_to(std::back_inserter(out), "{} ({}, {})##{}", i.buff->name, i.pos.x, i.pos.y, iid);
+                });
+
+                ImGuiListClipper clipper;
+                clipper.Begin(i32(g.items.size()));
+                while(clipper.Step()) {
+                    for(i16 iid = i16(clipper.DisplayStart); iid < i16(clipper.DisplayEnd); iid++) {
+                        Item& i = g.items[iid];
+
+                        Id id { gid, iid };
+                        if(ImGui::Selectable(itemLabels_[iid], selectedId_ == id || currentHovered_ == id,
+                                             ImGuiSelectableFlags_AllowItemOverlap)) {
                             selectedId_ = id;
-                            Core::i().DisplayDeletionMenu({ name, "item", std::format(" from grid '{}'", g.name), selectedId_ });
                         }
-                        if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem))
-                            newCurrentHovered = id;
 
-                        style.Colors[ImGuiCol_Button] = orig;
+                        if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem) || ImGui::IsItemActive()) {
+                            auto& style = ImGui::GetStyle();
+                            auto orig = style.Colors[ImGuiCol_Button];
+                            style.Colors[ImGuiCol_Button] *= ImVec4(0.5f, 0.5f, 0.5f, 1.f);
+                            ImGui::PushID(iid);
+                            if(ImGuiClose("CloseItem", 0.75f, false)) {
+                                selectedId_ = id;
+                                deletionTail_ = std::format(" from grid '{}'", g.name);
+                                Core::i().DisplayDeletionMenu({ i.buff->name, "item", deletionTail_, selectedId_ });
+                            }
+                            ImGui::PopID();
+                            if(ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem))
+                                newCurrentHovered = id;
+
+                            style.Colors[ImGuiCol_Button] = orig;
+                        }
                     }
                 }
 
@@ -191,6 +202,7 @@ void Grids::DrawGridList() {
             grids_.emplace_back();
             selectedId_ = Unselected(grids_.size() - 1);
             needsSaving_ = true;
+            InvalidateLabels();
         }
         ImGui::TableNextColumn();
         ImGui::BeginDisabled(disableItemsList);
@@ -198,6 +210,8 @@ void Grids::DrawGridList() {
             grid().items.emplace_back();
             selectedId_ = { selectedId_.grid, grid().items.size() - 1 };
             needsSaving_ = true;
+            InvalidateLabels();
+            stackSourcesDirty_ = true;
         }
         ImGui::EndDisabled();
 
@@ -208,6 +222,8 @@ void Grids::DrawGridList() {
 }
 
 void Grids::DrawItems(ComPtr<ID3D11DeviceContext>& ctx, const Layouts::Layout* layout, bool shouldIgnoreLayout) {
+    GW2_PROFILE_SCOPE("Grids::DrawItems");
+
     bool editMode = selectedId_.grid != UnselectedSubId;
 #ifdef _DEBUG
     bool showDebugGrid = debugGridFilter_.length() >= 3;
@@ -215,67 +231,116 @@ void Grids::DrawItems(ComPtr<ID3D11DeviceContext>& ctx, const Layouts::Layout* l
     bool showDebugGrid = false;
 #endif
 
-    if(layout || shouldIgnoreLayout || editMode || showDebugGrid) {
-        auto currentTime = TimeInMilliseconds();
-        f32 editingBorderCycle = sin(f32(currentTime) * 2.f * std::numbers::pi_v<f32> / 1000.f) * 0.5f + 0.5f;
+    if(stackSourcesDirty_)
+        CompileStackSources();
 
+    const auto& activeBuffs = buffs_->AcquireActiveBuffs();
+
+    if(layout || shouldIgnoreLayout || editMode || showDebugGrid) {
         if(!MumbleLink::i().isInCompetitiveMode() &&
            (editMode || shouldIgnoreLayout || showDebugGrid || !layout->combatOnly || MumbleLink::i().isInCombat())) {
             const vec2 screen { ImGui::GetIO().DisplaySize.x, ImGui::GetIO().DisplaySize.y };
             const vec2 mouse { ImGui::GetIO().MousePos.x, ImGui::GetIO().MousePos.y };
 
-            auto drawItem = [&](const ivec2& spacing, const Item& i, const vec2& gridOrigin, i32 count, bool editing) {
-                vec2 pos = gridOrigin + vec2(i.pos * spacing);
+            auto drawGrid = [&](const Grid& g, i16 gid, GridInstanceCache& cache, const vec2& gridOrigin) {
+                cache.instances.clear();
+                cache.origin = gridOrigin;
 
-                auto adj = AdjustToArea<vec2>(128.f, 128.f, f32(spacing.x));
+                const i16 editingItem = editMode && selectedId_.grid == gid ? selectedId_.item : UnselectedSubId;
+                BuildGridInstances(g, gridOrigin, screen, *styles_, activeBuffs.counts(), stackSources_, editingItem, editingItemFakeCount_,
+                                   cache.instances);
 
-                GridInstanceData inst;
-                inst.posDims = vec4(pos, adj) / vec4(screen, screen);
-                inst.uv = i.buff->uv;
-                if((inst.showNumber = i.buff->ShowNumber(count)))
-                    inst.numberUV = buffs_->GetNumber(count);
+                cache.dirty = false;
+            };
 
-                styles_->ApplyStyle(i.style, count, inst);
+            drawnGrids_.clear();
+            if(editMode)
+                drawnGrids_.push_back(selectedId_.grid);
+            else if(shouldIgnoreLayout)
+                for(i16 gid = 0; gid < i16(grids_.size()); gid++)
+                    drawnGrids_.push_back(gid);
+            else if(layout)
+                for(i32 gid : layout->grids)
+                    drawnGrids_.push_back(i16(gid));
 
-                if(editing) {
-                    inst.borderColor = glm::mix(inst.borderColor, vec4(1, 0, 0, 1), editingBorderCycle);
-                    inst.borderThickness = std::max(inst.borderThickness, 1.f);
+            if(enableGpuEvaluation_.value()) {
+                if(evaluatedStylesGeneration_ != styles_->generation()) {
+                    styles_->BuildAppearanceTable(evaluatedAppearances_);
+                    evaluatedRenderer_.SetAppearances(evaluatedAppearances_);
+                    evaluatedStylesGeneration_ = styles_->generation();
                 }
 
-                gridRenderer_.Add(std::move(inst));
-            };
+                EvaluationKey evaluationKey { styles_->generation(), gridsGeneration_, selectedId_, editingItemFakeCount_, drawnGrids_ };
+                if(evaluationKey_ != evaluationKey) {
+                    BuildEvaluatedItems(editMode);
+                    evaluatedRenderer_.SetItems(evaluatedItems_, stackSources_);
+                    evaluationKey_ = std::move(evaluationKey);
+                }
 
-            auto drawGrid = [&](const Grid& g, i16 gid) {
-                auto gridOrigin = g.ComputeOrigin(*this, editMode, screen, mouse);
+                evaluatedOrigins_.clear();
+                for(i16 gid : drawnGrids_)
+                    evaluatedOrigins_.push_back(grids_[gid].ComputeOrigin(editMode, screen, mouseState(mouse)));
 
-                for(auto it : g.items | ranges::views::enumerate) {
-                    // Need explicit types to shut up IntelliSense, still present as of 17.5.1
-                    i16 iid = it.first;
-                    const Item& i = it.second;
+                evaluatedRenderer_.Draw(ctx, activeBuffs, evaluatedOrigins_, enableBetterFiltering_.value());
+                // The instance buffer must be refilled if evaluation gets disabled
+                uploadedGrids_.clear();
+                return;
+            }
 
-                    bool editing = editMode && selectedId_ == Id { gid, iid };
-                    i32 count = 0;
-                    if(editing)
-                        count = editingItemFakeCount_;
-                    else if(i.buff)
-                        count =
-                            std::accumulate(i.additionalBuffs.begin(), i.additionalBuffs.end(), i.buff->GetStacks(buffs_->activeBuffs()),
-                                            [&](i32 a, const Buff* b) { return a + b->GetStacks(buffs_->activeBuffs()); });
+            bool upload = drawnGrids_ != uploadedGrids_;
+
+            // A table only records its changes since the previous generation, any skipped generation requires a full rebuild
+            const InstanceCacheKey key { styles_->generation(), gridsGeneration_, screen, selectedId_ };
+            const bool buffsChanged = activeBuffs.generation() != instanceBuffsGeneration_;
+            if(key != instanceCacheKey_ || instanceCaches_.size() != grids_.size() ||
+               (buffsChanged && activeBuffs.generation() != instanceBuffsGeneration_ + 1)) {
+                instanceCacheKey_ = key;
+                instanceCaches_.resize(grids_.size());
+                for(auto& c : instanceCaches_)
+                    c.dirty = true;
+            }
+            else if(buffsChanged) {
+                for(const auto& change : activeBuffs.changes())
+                    for(Id id : dependencies_[change.slot]) {
+                        auto& cache = instanceCaches_[id.grid];
+                        if(cache.dirty || size_t(id.item) >= cache.instances.size())
+                            continue;
 
-                    drawItem(g.spacing, i, gridOrigin, count, editing);
+                        const auto& g = grids_[id.grid];
+                        const i16 editingItem = editMode && selectedId_.grid == id.grid ? selectedId_.item : UnselectedSubId;
+                        cache.instances[id.item] = BuildGridInstance(g, id.item, cache.origin, screen, *styles_, activeBuffs.counts(),
+                                                                     stackSources_, editingItem, editingItemFakeCount_);
+                        upload = true;
+                    }
+            }
+            instanceBuffsGeneration_ = activeBuffs.generation();
+
+            for(i16 gid : drawnGrids_) {
+                const auto& g = grids_[gid];
+                auto& cache = instanceCaches_[gid];
+                // Attached grids follow the mouse, which the key doesn't track
+                const vec2 gridOrigin = g.ComputeOrigin(editMode, screen, mouseState(mouse));
+                if(cache.dirty || gridOrigin != cache.origin) {
+                    drawGrid(g, editMode ? gid : UnselectedSubId, cache, gridOrigin);
+                    upload = true;
                 }
-            };
+            }
 
-            if(editMode)
-                drawGrid(grid(), selectedId_.grid);
-            else if(shouldIgnoreLayout)
-                for(const auto& g : grids_)
-                    drawGrid(g, UnselectedSubId);
-            else if(layout)
-                for(i32 gid : layout->grids)
-                    drawGrid(grids_[gid], UnselectedSubId);
+            if(upload) {
+                for(i16 gid : drawnGrids_)
+                    gridRenderer_.Add(instanceCaches_[gid].instances);
+                gridRenderer_.Draw(ctx, enableBetterFiltering_.value());
+                uploadedGrids_ = drawnGrids_;
+            }
+            else
+                gridRenderer_.Redraw(ctx, enableBetterFiltering_.value());
 
-            gridRenderer_.Draw(ctx, enableBetterFiltering_.value());
+#ifdef _DEBUG
+            if(verifyEvaluation_) {
+                VerifyEvaluation(activeBuffs, screen, editMode);
+                verifyEvaluation_ = false;
+            }
+#endif
 #if 0
 #ifdef _DEBUG
                 const Buff* hoveredBuff = nullptr;
@@ -291,7 +356,7 @@ void Grids::DrawItems(ComPtr<ID3D11DeviceContext>& ctx, const Layouts::Layout* l
 
                     for (const auto& b : buffs_)
                     {
-                        if (b.id == 0xFFFFFFFF || !ToLower(b.name).contains(lowerCaseDebugGridFilter) && !ToLower(b.category).contains(lowerCaseDebugGridFilter))
+                        if (b.id == 0xFFFFFFFF || !ToLower(std::string(b.name)).contains(lowerCaseDebugGridFilter) && !ToLower(std::string(b.category)).contains(lowerCaseDebugGridFilter))
                             continue;
 
                         fakeItem.buff = &b;
@@ -333,6 +398,53 @@ void Grids::DrawItems(ComPtr<ID3D11DeviceContext>& ctx, const Layouts::Layout* l
     }
 }
 
+void Grids::BuildEvaluatedItems(bool editMode) {
+    evaluatedItems_.clear();
+
+    for(auto&& [index, gid] : drawnGrids_ | ranges::views::enumerate) {
+        const auto& g = grids_[gid];
+        for(i16 iid = 0; iid < i16(g.items.size()); iid++) {
+            const bool editing = editMode && selectedId_ == Id { gid, iid };
+            evaluatedItems_.push_back(BuildGridItemData(g, iid, u32(index), *styles_, editing, editingItemFakeCount_));
+        }
+    }
+}
+
+#ifdef _DEBUG
+void Grids::VerifyEvaluation(const ActiveBuffsTable& activeBuffs, const vec2& screen, bool editMode) {
+    styles_->BuildAppearanceTable(evaluatedAppearances_);
+    BuildEvaluatedItems(editMode);
+    // Both were rebuilt from the current state, but the GPU copies may be older
+    evaluationKey_.reset();
+    evaluatedStylesGeneration_.reset();
+
+    size_t itemIndex = 0, mismatches = 0;
+    for(i16 gid : drawnGrids_) {
+        const auto& cache = instanceCaches_[gid];
+        for(const auto& expected : cache.instances) {
+            const auto evaluated = EvaluateGridItem(evaluatedItems_[itemIndex++], cache.origin, screen, activeBuffs.counts(), stackSources_,
+                                                    evaluatedAppearances_);
+            if(evaluated != expected)
+                mismatches++;
+        }
+    }
+
+    if(mismatches > 0)
+        LogWarn("GPU evaluation differs from the CPU path for {} of {} items.", mismatches, itemIndex);
+    else
+        LogInfo("GPU evaluation matches the CPU path for all {} items.", itemIndex);
+}
+#endif
+
+void Grids::CompileStackSources() {
+    gridsGeneration_++;
+
+    GW2Clarity::CompileStackSources(grids_, buffs_->buffSlots(), stackSources_);
+    dependencies_.Build(grids_, stackSources_, buffs_->buffSlots().size());
+
+    stackSourcesDirty_ = false;
+}
+
 void Grids::Delete(Id id) {
     if(id.item >= 0) {
         auto& g = grid(id);
@@ -350,9 +462,14 @@ void Grids::Delete(Id id) {
             selectedId_ = Unselected();
         needsSaving_ = true;
     }
+
+    stackSourcesDirty_ = true;
+    InvalidateLabels();
 }
 
 void Grids::StyleDeleted(u32 id) {
+    gridsGeneration_++;
+
     for(auto& g : grids_) {
         for(auto& i : g.items) {
             if(i.style == id)
@@ -378,7 +495,7 @@ void Grids::DrawMenu(Keybind** currentEditedKeybind) {
             auto it = ranges::find_if(grid().items, [&](const auto& i) { return i.pos.x == pos.x && i.pos.y == pos.y; });
 
             if(it != grid().items.end()) {
-                ImGui::TextUnformatted(it->buff->name.c_str());
+                ImGui::TextUnformatted(it->buff->name.data(), it->buff->name.data() + it->buff->name.size());
                 ImGui::Text("(%d, %d)", it->pos.x, it->pos.y);
             }
             else {
@@ -391,11 +508,30 @@ void Grids::DrawMenu(Keybind** currentEditedKeybind) {
 
     DrawEditingGrid();
 
-    ImGuiConfigurationWrapper(ImGui::Checkbox, enableBetterFiltering_);
+    if(bool v = enableBetterFiltering_.value(); ImGui::Checkbox(enableBetterFiltering_.displayName().c_str(), &v))
+        enableBetterFiltering_.value(v);
     ImGuiHelpTooltip("Enables higher quality texture filtering, improving the icons' appearance at a cost to performance.");
 
+    if(bool v = enableGpuEvaluation_.value(); ImGui::Checkbox(enableGpuEvaluation_.displayName().c_str(), &v))
+        enableGpuEvaluation_.value(v);
+    ImGuiHelpTooltip("Resolves buff counts and styles on the GPU, reducing the CPU cost of large grids.");
+
+#ifdef _DEBUG
+    const auto& rendererStats = gridRenderer_.stats();
+    ImGui::Text("Instances: %zu peak, %zu capacity, %u batch(es) last frame", rendererStats.highWaterMark, rendererStats.capacity,
+                rendererStats.batches);
+    ImGui::BeginDisabled(enableGpuEvaluation_.value());
+    if(ImGui::Button("Verify GPU evaluation"))
+        verifyEvaluation_ = true;
+    ImGui::EndDisabled();
+#endif
+
     auto saveCheck = [this](bool changed) {
         needsSaving_ = needsSaving_ || changed;
+        if(changed) {
+            gridsGeneration_++;
+            InvalidateLabels();
+        }
         return changed;
     };
 
@@ -408,7 +544,7 @@ void Grids::DrawMenu(Keybind** currentEditedKeybind) {
             testMouseMode_ = false;
         if(editingGrid) {
             auto& editGrid = grid();
-            ImGuiTitle(std::format("Editing Grid '{}'", editGrid.name).c_str(), 0.75f);
+            ImGuiTitle(FixedLabel<>("Editing Grid '{}'", editGrid.name).c_str(), 0.75f);
 
             saveCheck(ImGui::InputText("Grid Name", &editGrid.name));
             ImGui::NewLine();
@@ -482,11 +618,13 @@ void Grids::DrawMenu(Keybind** currentEditedKeybind) {
         }
         else if(editingItem) {
             auto& editItem = item();
-            ImGuiTitle(std::format("Editing Item '{}' of '{}'", editItem.buff->name, grid().name).c_str(), 0.75f);
+            ImGuiTitle(FixedLabel<>("Editing Item '{}' of '{}'", editItem.buff->name, grid().name).c_str(), 0.75f);
 
             auto buffCombo = [&](auto& buff, i32 id, const char* name) {
-                if(saveCheck(selector_.Draw(std::format("{}##{}", name, id).c_str())))
+                if(saveCheck(selector_.Draw(FixedLabel<>("{}##{}", name, id).c_str()))) {
                     buff = selector_.selectedBuff();
+                    stackSourcesDirty_ = true;
+                }
             };
 
             buffCombo(editItem.buff, -1, "Main buff");
@@ -498,14 +636,20 @@ void Grids::DrawMenu(Keybind** currentEditedKeybind) {
 
                 buffCombo(extraBuff, i32(n), "Secondary buff");
                 ImGui::SameLine();
-                if(ImGuiClose(std::format("RemoveExtraBuff{}", n).c_str()))
+                ImGui::PushID(n);
+                if(ImGuiClose("RemoveExtraBuff"))
                     removeId = i32(n);
+                ImGui::PopID();
             }
-            if(removeId != -1)
+            if(removeId != -1) {
                 editItem.additionalBuffs.erase(editItem.additionalBuffs.begin() + removeId);
+                stackSourcesDirty_ = true;
+            }
 
-            if(ImGui::Button("Add secondary buff"))
-                editItem.additionalBuffs.push_back(&Buffs::UnknownBuff);
+            if(ImGui::Button("Add secondary buff")) {
+                editItem.additionalBuffs.push_back(&UnknownBuff);
+                stackSourcesDirty_ = true;
+            }
             ImGuiHelpTooltip(
                 "Secondary buffs will activate the buff on screen, but without changing the icon. Useful to combine multiple related "
                 "effects (e.g. Fixated) in one icon.");
@@ -543,127 +687,28 @@ void Grids::Draw(ComPtr<ID3D11DeviceContext>& ctx, const Layouts::Layout* layout
     firstDraw_ = false;
 }
 
-void Grids::Load() {
-    using namespace nlohmann;
-    grids_.clear();
-    selectedId_ = Unselected();
-
-    auto& cfg = JSONConfigurationFile::i();
-    cfg.Reload();
-
-    auto maybeAt = []<typename D>(const json& j, const char* n, const D& def,
-                                  const std::variant<std::monostate, std::function<D(const json&)>>& cvt = {}) {
-        auto it = j.find(n);
-        if(it == j.end())
-            return def;
-        if(cvt.index() == 0)
-            return static_cast<D>(*it);
-        else
-            return std::get<1>(cvt)(*it);
-    };
-
-    auto getivec2 = [](const json& j) {
-        return ivec2(j[0].get<i32>(), j[1].get<i32>());
-    };
-    auto getivec4 = [](const json& j) {
-        return ivec4(j[0].get<i32>(), j[1].get<i32>(), j[2].get<i32>(), j[3].get<i32>());
-    };
-    auto getImVec4 = [](const json& j) {
-        return ImVec4(j[0].get<f32>(), j[1].get<f32>(), j[2].get<f32>(), j[3].get<f32>());
-    };
-    auto getvec4 = [](const json& j) {
-        return vec4(j[0].get<f32>(), j[1].get<f32>(), j[2].get<f32>(), j[3].get<f32>());
-    };
-    auto getBuff = [this](const json& j) -> const Buff* {
-        i32 id = j;
-        auto it = buffs_->buffsMap().find(id);
-        if(it != buffs_->buffsMap().end())
-            return it->second;
-        else
-            return nullptr;
-    };
+void Grids::Load(const ConfigSource& config) {
+    GW2_PROFILE_SCOPE("Grids::Load");
 
-    const auto& grids = cfg.json()["buff_grids"];
-    for(const auto& gIn : grids) {
-        Grid g;
-        g.spacing = maybeAt(gIn, "spacing", ivec2(32, 32), { getivec2 });
-        g.offset = maybeAt(gIn, "offset", ivec2(), { getivec2 });
-        g.attached = maybeAt(gIn, "attached", false);
-        g.centralWeight = maybeAt(gIn, "central_weight", 0.f);
-        g.mouseClipMin = maybeAt(gIn, "mouse_clip_min", ivec2 { std::numeric_limits<i32>::max() }, { getivec2 });
-        g.mouseClipMax = maybeAt(gIn, "mouse_clip_max", ivec2 { std::numeric_limits<i32>::min() }, { getivec2 });
-        g.trackMouseWhileHeld = maybeAt(gIn, "track_mouse_while_held", true);
-        g.square = maybeAt(gIn, "square", true);
-        g.name = gIn["name"];
-
-        for(const auto& iIn : gIn["items"]) {
-            Item i;
-            i.pos = getivec2(iIn["pos"]);
-            i.buff = getBuff(iIn["buff_id"]);
-            i.style = styles_->FindStyle(maybeAt(iIn, "style", std::string {}));
-
-            if(iIn.contains("additional_buff_ids"))
-                for(auto& bIn : iIn["additional_buff_ids"])
-                    if(const Buff* b = getBuff(bIn); b)
-                        i.additionalBuffs.push_back(b);
-
-            if(!i.buff) {
-                i.buff = &Buffs::UnknownBuff;
-                LogWarn("Configuration has unknown buff: Grid '{}', location ({}, {}), buff ID '{}'.", g.name, i.pos.x, i.pos.y,
-                        static_cast<i32>(iIn["buff_id"]));
-            }
+    selectedId_ = Unselected();
 
-            if(!i.buff && !i.additionalBuffs.empty()) {
-                i.buff = i.additionalBuffs.back();
-                i.additionalBuffs.pop_back();
-            }
+    grids_ = config.LoadGrids(buffs_->catalog(), *styles_);
+    InvalidateLabels();
 
-            g.items.push_back(i);
-        }
-        grids_.push_back(g);
-    }
+    CompileStackSources();
 }
 
 void Grids::Save() {
-    using namespace nlohmann;
-
-    auto& cfg = JSONConfigurationFile::i();
-    auto& grids = cfg.json()["buff_grids"];
-    grids = json::array();
-    for(const auto& g : grids_) {
-        json grid;
-        grid["spacing"] = { g.spacing.x, g.spacing.y };
-        grid["offset"] = { g.offset.x, g.offset.y };
-        grid["attached"] = g.attached;
-        grid["central_weight"] = g.centralWeight;
-        grid["mouse_clip_min"] = { g.mouseClipMin.x, g.mouseClipMin.y };
-        grid["mouse_clip_max"] = { g.mouseClipMax.x, g.mouseClipMax.y };
-        grid["track_mouse_while_held"] = g.trackMouseWhileHeld;
-        grid["square"] = g.square;
-        grid["name"] = g.name;
-
-        json& gridItems = grid["items"];
-
-        for(const auto& i : g.items) {
-            json item;
-            item["pos"] = { i.pos.x, i.pos.y };
-            item["buff_id"] = i.buff->id;
-            item["style"] = styles_->style(i.style).name;
-
-            if(!i.additionalBuffs.empty()) {
-                json buffs = json::array();
-                for(const auto* b : i.additionalBuffs)
-                    buffs.push_back(b->id);
-                item["additional_buff_ids"] = buffs;
-            }
-
-            gridItems.push_back(item);
-        }
+    GW2_PROFILE_SCOPE("Grids::Save");
 
-        grids.push_back(grid);
-    }
+    std::vector<std::string> styleNames;
+    styleNames.reserve(styles_->styles().size());
+    for(const auto& s : styles_->styles())
+        styleNames.push_back(s.name);
 
-    cfg.Save();
+    Core::i().configPersistence().Submit("buff_grids", [grids = grids_, styleNames = std::move(styleNames)] {
+        return SaveGrids(grids, styleNames);
+    });
 
     needsSaving_ = false;
     lastSaveTime_ = TimeInMilliseconds();
@@ -0,0 +1,47 @@
+#include "LayoutConfig.h"
+
+#include "ConfigJson.h"
+
+namespace GW2Clarity
+{
+
+std::vector<Layout> LoadLayouts(const nlohmann::json& layouts, size_t gridCount) {
+    std::vector<Layout> out;
+    for(const auto& sIn : layouts) {
+        Layout s {};
+        s.name = sIn["name"];
+        s.combatOnly = ReadOr(sIn, "combat_only", false);
+
+        for(const auto& gIn : sIn["grids"]) {
+            i32 id = gIn;
+            if(id >= 0 && size_t(id) < gridCount)
+                s.grids.insert(id);
+        }
+
+        out.push_back(s);
+    }
+
+    return out;
+}
+
+nlohmann::json SaveLayouts(std::span<const Layout> layouts) {
+    using namespace nlohmann;
+
+    json out = json::array();
+    for(const auto& s : layouts) {
+        json layout;
+        layout["name"] = s.name;
+        layout["combat_only"] = s.combatOnly;
+
+        json& layoutGrids = layout["grids"];
+
+        for(i32 i : s.grids)
+            layoutGrids.push_back(i);
+
+        out.push_back(layout);
+    }
+
+    return out;
+}
+
+} // namespace GW2Clarity
@@ -7,16 +7,17 @@
 
 #include "Core.h"
 #include "ImGuiExtensions.h"
+#include "Profiler.h"
 
 namespace GW2Clarity
 {
 
-Layouts::Layouts(ComPtr<ID3D11Device>& dev, Grids* grids)
+Layouts::Layouts(ComPtr<ID3D11Device>& dev, Grids* grids, const ConfigSource& config)
     : changeGridLayoutKey_("change_layout", "Change Layout", "General")
-    , rememberLayout_("Remember Layout on launch", "remember_layout", "General", false)
-    , rememberedLayoutId_("Remembered Layout", "remembered_layout", "General", UnselectedSubId)
+    , rememberLayout_(Core::i().configPersistence(), "Remember Layout on launch", "remember_layout", "General", false)
+    , rememberedLayoutId_(Core::i().configPersistence(), "Remembered Layout", "remembered_layout", "General", UnselectedSubId)
     , gridsInstance_(grids) {
-    Load(gridsInstance_->grids().size());
+    Load(config, gridsInstance_->grids().size());
 
     if(rememberLayout_.value())
         currentLayoutId_ = rememberedLayoutId_.value();
@@ -135,7 +136,8 @@ void Layouts::DrawMenu(Keybind** currentEditedKeybind) {
 
     ImGuiKeybindInput(changeGridLayoutKey_, currentEditedKeybind, "Displays the Quick Layout menu to change what buffs are displayed.");
 
-    ImGuiConfigurationWrapper(&ImGui::Checkbox, rememberLayout_);
+    if(bool v = rememberLayout_.value(); ImGui::Checkbox(rememberLayout_.displayName().c_str(), &v))
+        rememberLayout_.value(v);
     ImGuiHelpTooltip("If checked, the currently selected Layout will be saved on exit and restored on launch.");
 
     mstime currentTime = TimeInMilliseconds();
@@ -181,69 +183,18 @@ void Layouts::Draw(ComPtr<ID3D11DeviceContext>& ctx) {
     firstDraw_ = false;
 }
 
-void Layouts::Load(size_t gridCount) {
-    using namespace nlohmann;
-    layouts_.clear();
-    selectedLayoutId_ = UnselectedSubId;
-
-    auto& cfg = JSONConfigurationFile::i();
-    cfg.Reload();
-
-    auto maybe_at = []<typename D>(const json& j, const char* n, const D& def,
-                                   const std::variant<std::monostate, std::function<D(const json&)>>& cvt = {}) {
-        auto it = j.find(n);
-        if(it == j.end())
-            return def;
-        if(cvt.index() == 0)
-            return static_cast<D>(*it);
-        else
-            return std::get<1>(cvt)(*it);
-    };
-
-    auto getivec2 = [](const json& j) {
-        return ivec2(j[0].get<i32>(), j[1].get<i32>());
-    };
-    auto getImVec4 = [](const json& j) {
-        return ImVec4(j[0].get<f32>(), j[1].get<f32>(), j[2].get<f32>(), j[3].get<f32>());
-    };
+void Layouts::Load(const ConfigSource& config, size_t gridCount) {
+    GW2_PROFILE_SCOPE("Layouts::Load");
 
-    const auto& layouts = cfg.json()["buff_layouts"];
-    for(const auto& sIn : layouts) {
-        Layout s {};
-        s.name = sIn["name"];
-        s.combatOnly = maybe_at(sIn, "combat_only", false);
-
-        for(const auto& gIn : sIn["grids"]) {
-            i32 id = gIn;
-            if(id < gridCount)
-                s.grids.insert(id);
-        }
+    selectedLayoutId_ = UnselectedSubId;
 
-        layouts_.push_back(s);
-    }
+    layouts_ = config.LoadLayouts(gridCount);
 }
 
 void Layouts::Save() {
-    using namespace nlohmann;
-
-    auto& cfg = JSONConfigurationFile::i();
-
-    auto& layouts = cfg.json()["buff_layouts"];
-    layouts = json::array();
-    for(const auto& s : layouts_) {
-        json layout;
-        layout["name"] = s.name;
-        layout["combat_only"] = s.combatOnly;
-
-        json& layoutGrids = layout["grids"];
-
-        for(i32 i : s.grids)
-            layoutGrids.push_back(i);
-
-        layouts.push_back(layout);
-    }
+    GW2_PROFILE_SCOPE("Layouts::Save");
 
-    cfg.Save();
+    Core::i().configPersistence().Submit("buff_layouts", [layouts = layouts_] { return SaveLayouts(layouts); });
 
     needsSaving_ = false;
     lastSaveTime_ = TimeInMilliseconds();
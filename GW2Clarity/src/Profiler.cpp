@@ -0,0 +1,95 @@
+#include "Profiler.h"
+
+#ifdef GW2CLARITY_PROFILING
+
+#include <ostream>
+
+#include <nlohmann/json.hpp>
+#include <range/v3/all.hpp>
+
+namespace GW2Clarity
+{
+
+u16 Profiler::RegisterScope(const char* name) {
+    std::lock_guard lock(mutex_);
+    GW2_ASSERT(scopes_.size() < std::numeric_limits<u16>::max());
+    scopes_.emplace_back(name);
+    return u16(scopes_.size() - 1);
+}
+
+Profiler::ThreadRing& Profiler::RegisterThread() {
+    std::lock_guard lock(mutex_);
+    auto& ring = rings_.emplace_back(std::make_unique<ThreadRing>());
+    ring->index = u32(rings_.size() - 1);
+    return *ring;
+}
+
+template<typename F>
+void Profiler::ForEachEvent(F&& f) {
+    std::vector<ProfileEvent> events;
+
+    std::lock_guard lock(mutex_);
+    for(const auto& ring : rings_) {
+        const u64 end = ring->written.load(std::memory_order_acquire);
+        const u64 begin = end > RingCapacity ? end - RingCapacity : 0;
+        events.resize(end - begin);
+        for(u64 i = begin; i < end; i++)
+            events[i - begin] = ring->events[i & (RingCapacity - 1)];
+
+        // Events written meanwhile replaced the oldest ones, and the next one may be halfway through replacing another. The fence keeps
+        // the copy above from being reordered after this load, which would let it see events written after the count it checks against.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const u64 after = ring->written.load(std::memory_order_relaxed);
+        const u64 firstValid = after >= RingCapacity ? std::max(begin, after - RingCapacity + 1) : begin;
+        for(u64 i = firstValid; i < end; i++)
+            f(ring->index, events[i - begin]);
+    }
+}
+
+void Profiler::ComputeStats(std::vector<ProfileScopeStats>& stats) {
+    std::vector<std::vector<u32>> durations;
+    ForEachEvent([&](u32, const ProfileEvent& e) {
+        if(e.scope >= durations.size())
+            durations.resize(e.scope + 1);
+        durations[e.scope].push_back(e.duration);
+    });
+
+    std::lock_guard lock(mutex_);
+    durations.resize(scopes_.size());
+    stats.clear();
+    for(auto&& [i, d] : durations | ranges::views::enumerate) {
+        ProfileScopeStats s { scopes_[i], d.size(), 0, 0, 0, 0 };
+        if(!d.empty()) {
+            std::ranges::sort(d);
+            s.p50 = d[d.size() / 2];
+            s.p99 = d[std::min(d.size() - 1, d.size() * 99 / 100)];
+            s.max = d.back();
+            s.total = std::accumulate(d.begin(), d.end(), u64(0));
+        }
+        stats.push_back(s);
+    }
+}
+
+void Profiler::ExportChromeTrace(std::ostream& out) {
+    std::vector<std::string> names;
+    {
+        std::lock_guard lock(mutex_);
+        for(const auto& s : scopes_)
+            names.push_back(nlohmann::json(s).dump());
+    }
+
+    out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    ForEachEvent([&](u32 thread, const ProfileEvent& e) {
+        if(e.scope >= names.size())
+            return;
+        out << (first ? "\n" : ",\n") << "{\"name\":" << names[e.scope] << ",\"cat\":\"GW2Clarity\",\"ph\":\"X\",\"pid\":0"
+            << ",\"tid\":" << thread << ",\"ts\":" << f64(e.start) / 1000.0 << ",\"dur\":" << f64(e.duration) / 1000.0 << "}";
+        first = false;
+    });
+    out << "\n]}\n";
+}
+
+} // namespace GW2Clarity
+
+#endif
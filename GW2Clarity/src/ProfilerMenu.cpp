@@ -0,0 +1,106 @@
+#include "ProfilerMenu.h"
+
+#ifdef GW2CLARITY_PROFILING
+
+#include <imgui.h>
+
+#include "Core.h"
+
+namespace GW2Clarity
+{
+
+ProfilerMenu::ProfilerMenu() { SettingsMenu::i().AddImplementer(this); }
+
+ProfilerMenu::~ProfilerMenu() {
+    SettingsMenu::f([&](auto& i) { i.RemoveImplementer(this); });
+}
+
+void ProfilerMenu::DrawMenu(Keybind** currentEditedKeybind) {
+    // Sorting every scope's durations is cheap but pointless to do every frame
+    if(TimeInMilliseconds() - lastRefreshTime_ > RefreshDelay) {
+        Profiler::ComputeStats(stats_);
+        lastRefreshTime_ = TimeInMilliseconds();
+    }
+
+    ImGui::TextWrapped("Time spent in the addon's main operations, over the last %zu calls made by each thread. Times are in microseconds.",
+                       Profiler::RingCapacity);
+
+    if(ImGui::BeginTable("Profiler Scopes", 6, ImGuiTableFlags_RowBg)) {
+        ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_WidthStretch, 5.f);
+        ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed, 60.f);
+        ImGui::TableSetupColumn("Mean", ImGuiTableColumnFlags_WidthFixed, 70.f);
+        ImGui::TableSetupColumn("p50", ImGuiTableColumnFlags_WidthFixed, 70.f);
+        ImGui::TableSetupColumn("p99", ImGuiTableColumnFlags_WidthFixed, 70.f);
+        ImGui::TableSetupColumn("Max", ImGuiTableColumnFlags_WidthFixed, 70.f);
+        ImGui::TableHeadersRow();
+
+        auto time = [](f64 ns) {
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", ns / 1000.0);
+        };
+
+        for(const auto& s : stats_) {
+            if(s.calls == 0)
+                continue;
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(s.name.data(), s.name.data() + s.name.size());
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", s.calls);
+            time(f64(s.total) / f64(s.calls));
+            time(f64(s.p50));
+            time(f64(s.p99));
+            time(f64(s.max));
+        }
+
+        ImGui::EndTable();
+    }
+
+    const auto& polls = Core::i().buffPollStats();
+    const u64 updates = polls.updates.load(std::memory_order_relaxed);
+    if(updates > 0) {
+        const u64 backedOff = polls.backedOff.load(std::memory_order_relaxed);
+        const u64 unchanged = polls.unchanged.load(std::memory_order_relaxed);
+        ImGui::Text("Buff updates: %llu, %.1f%% skipped (%.1f%% backing off from errors, %.1f%% unchanged)", updates,
+                    100.0 * f64(backedOff + unchanged) / f64(updates), 100.0 * f64(backedOff) / f64(updates),
+                    100.0 * f64(unchanged) / f64(updates));
+    }
+
+#ifdef GW2CLARITY_ALLOCATION_TRACKING
+    // Should read zero in steady state, settings menus included
+    ImGui::Text("Heap allocations on the render thread last frame: %llu", Core::i().lastFrameAllocations());
+#endif
+
+    if(ImGui::Button("Export Chrome trace"))
+        Export();
+    if(!lastExportPath_.empty()) {
+        ImGui::SameLine();
+        ImGui::TextUnformatted(lastExportPath_.c_str());
+    }
+}
+
+void ProfilerMenu::Export() {
+    using namespace std::chrono;
+
+    wchar_t fn[MAX_PATH];
+    GetModuleFileName(GetBaseCore().dllModule(), fn, MAX_PATH);
+
+    std::filesystem::path tracePath = fn;
+    tracePath = tracePath.remove_filename() / std::format("profile_{:%Y%m%d_%H%M%S}.json", floor<seconds>(system_clock::now()));
+
+    std::ofstream file(tracePath);
+    if(!file.good()) {
+        LogError("Could not write profile to {}.", tracePath.string());
+        lastExportPath_.clear();
+        return;
+    }
+
+    Profiler::ExportChromeTrace(file);
+    lastExportPath_ = tracePath.string();
+    LogInfo("Profile written to {}.", lastExportPath_);
+}
+
+} // namespace GW2Clarity
+
+#endif
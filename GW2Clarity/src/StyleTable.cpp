@@ -0,0 +1,187 @@
+#include "StyleTable.h"
+
+#include "ConfigJson.h"
+
+namespace GW2Clarity
+{
+
+void StyleTable::LoadStyles(const nlohmann::json& styles) {
+    std::vector<Style> userStyles;
+    for(const auto& sIn : styles) {
+        Style s {};
+        s.name = sIn["name"];
+
+        for(const auto& tIn : sIn["thresholds"]) {
+            Threshold t;
+            t.thresholdMin = ReadOr(tIn, "threshold_min", 0);
+            t.thresholdMax = ReadOr(tIn, "threshold_max", 1);
+            auto& app = t.appearance;
+            app.tint = ReadOr(tIn, "tint", vec4(1));
+            app.border = ReadOr(tIn, "border", vec4(0));
+            app.glow = ReadOr(tIn, "glow", vec4(0));
+            app.borderThickness = ReadOr(tIn, "border_thickness", 0.f);
+            app.glowSize = ReadOr(tIn, "glow_size", 0.f);
+            app.glowPulse = ReadOr(tIn, "glow_pulse", vec2(0));
+            s.thresholds.push_back(t);
+        }
+
+        userStyles.push_back(std::move(s));
+    }
+
+    LoadStyles(std::move(userStyles));
+}
+
+void StyleTable::LoadStyles(std::vector<Style> userStyles) {
+    using namespace std::literals;
+    styles_.clear();
+
+    styles_.emplace_back("Simple On/Off (hidden)"sv, ThresholdBuilder().tint(0.f, 0.f), ThresholdBuilder().min(1).max(99));
+    styles_.emplace_back("Simple On/Off (faded)"sv, ThresholdBuilder().tint(0.75f, 0.25f), ThresholdBuilder().min(1).max(99));
+    styles_.emplace_back("Simple On/Off (red faded)"sv, ThresholdBuilder().tint(1.f, 0.f, 0.f, 0.25f), ThresholdBuilder().min(1).max(99));
+    styles_.emplace_back("0/5/20 Stacks (green)"sv, ThresholdBuilder().min(0).max(4).tint(0.75f, 0.25f),
+                         ThresholdBuilder().min(5).max(19).tint(0.75f, 0.65f),
+                         ThresholdBuilder().min(20).max(MaxThresholdCount).tint(0.25f, 1.f, 0.25f, 1.f));
+
+    for(auto& s : userStyles)
+        styles_.push_back(std::move(s));
+
+    BuildCache();
+}
+
+nlohmann::json StyleTable::SaveStyles(std::span<const Style> styles) {
+    using namespace nlohmann;
+
+    json out = json::array();
+    for(const auto& s : styles) {
+        if(s.builtIn)
+            continue;
+
+        json style;
+        style["name"] = s.name;
+
+        json& styleThresholds = style["thresholds"];
+        for(const auto& t : s.thresholds) {
+            json threshold;
+            threshold["threshold_min"] = t.thresholdMin;
+            threshold["threshold_max"] = t.thresholdMax;
+            auto& app = t.appearance;
+            threshold["tint"] = { app.tint.x, app.tint.y, app.tint.z, app.tint.w };
+            threshold["border"] = { app.border.x, app.border.y, app.border.z, app.border.w };
+            threshold["glow"] = { app.glow.x, app.glow.y, app.glow.z, app.glow.w };
+            threshold["border_thickness"] = app.borderThickness;
+            threshold["glow_size"] = app.glowSize;
+            threshold["glow_pulse"] = { app.glowPulse.x, app.glowPulse.y };
+
+            styleThresholds.push_back(threshold);
+        }
+
+        out.push_back(style);
+    }
+
+    return out;
+}
+
+void StyleTable::BuildCache() {
+    // Unreferenced palette entries accumulate while editing, so a full rebuild starts over
+    palette_.assign(1, Appearance {});
+
+    for(auto& s : styles_)
+        CompileStyle(s);
+
+    UpdateTableRows();
+    generation_++;
+}
+
+void StyleTable::BuildCache(u32 id) {
+    if(id >= styles_.size())
+        return;
+
+    CompileStyle(styles_[id]);
+
+    // Edits leave unreferenced entries behind, compact once they make up most of the palette
+    size_t referenced = 1;
+    for(const auto& s : styles_)
+        referenced += s.appearances.size();
+    if(palette_.size() > PaletteCompactionThreshold && palette_.size() > referenced * 2)
+        BuildCache();
+    else {
+        UpdateTableRows();
+        generation_++;
+    }
+}
+
+void StyleTable::CompileStyle(Style& s) {
+    auto findPalette = [&](const Appearance& app) {
+        auto it = ranges::find(palette_, app);
+        if(it != palette_.end())
+            return u16(std::distance(palette_.begin(), it));
+
+        GW2_ASSERT(palette_.size() <= std::numeric_limits<u16>::max());
+        palette_.push_back(app);
+        return u16(palette_.size() - 1);
+    };
+
+    // Every count at which the highest priority threshold may change
+    std::vector<u32> edges { 0 };
+    for(const auto& th : s.thresholds) {
+        if(th.thresholdMin > th.thresholdMax)
+            continue;
+        edges.push_back(th.thresholdMin);
+        if(th.thresholdMax < std::numeric_limits<u32>::max())
+            edges.push_back(th.thresholdMax + 1);
+    }
+    ranges::sort(edges);
+    edges.erase(ranges::unique(edges), edges.end());
+
+    s.breakpoints.clear();
+    s.appearances.clear();
+    for(u32 edge : edges) {
+        // First threshold in the list has the highest priority
+        auto th = ranges::find_if(s.thresholds, [edge](const auto& t) { return t.thresholdMin <= edge && edge <= t.thresholdMax; });
+        u16 app = th == s.thresholds.end() ? 0 : findPalette(th->appearance);
+
+        if(s.appearances.empty() || s.appearances.back() != app) {
+            s.breakpoints.push_back(edge);
+            s.appearances.push_back(app);
+        }
+    }
+}
+
+void StyleTable::UpdateTableRows() {
+    u32 row = 1;
+    for(auto& s : styles_) {
+        s.tableRow = row;
+        row += u32(s.breakpoints.size());
+    }
+}
+
+void StyleTable::BuildAppearanceTable(std::vector<PackedGridAppearanceInterval>& table) const {
+    table.clear();
+    table.reserve(styles_.empty() ? 1 : 1 + styles_.back().tableRow + styles_.back().breakpoints.size());
+    table.push_back({ 0, PackAppearance(GridInstanceData {}) });
+
+    for(u32 id = 0; id < styles_.size(); id++)
+        for(u32 minCount : styles_[id].breakpoints) {
+            GridInstanceData inst;
+            ApplyStyle(id, i32(minCount), inst);
+            table.push_back({ minCount, PackAppearance(inst) });
+        }
+}
+
+void StyleTable::ApplyStyle(u32 id, i32 count, GridInstanceData& out) const {
+    if(id >= styles_.size() || count < 0)
+        return;
+
+    const auto& app = appearance(id, count);
+    out.glowSize = app.glowSize;
+    if(app.glowPulse.x > 0.f) {
+        out.glowPulse.x = app.glowPulse.x;
+        out.glowPulse.y = app.glowPulse.y;
+    }
+    out.borderColor = app.border;
+    out.borderThickness = app.borderThickness;
+    out.glowColor = app.glowSize > 0.f ? app.glow : vec4(0.f);
+    out.tint = app.tint;
+}
+
+} // namespace GW2Clarity
@@ -8,12 +8,15 @@
 
 #include "Core.h"
 #include "Grids.h"
+#include "FixedLabel.h"
 #include "ImGuiExtensions.h"
+#include "Profiler.h"
 
 namespace GW2Clarity
 {
-Styles::Styles(ComPtr<ID3D11Device>& dev, const Buffs* buffs) : buffs_(buffs), previewRenderer_(dev, buffs) {
-    Load();
+Styles::Styles(ComPtr<ID3D11Device>& dev, const Buffs* buffs, const ConfigSource& config)
+    : buffs_(buffs), previewRenderer_(dev, buffs) {
+    Load(config);
 
     preview_ = MakeRenderTarget(dev, PreviewSize, PreviewSize, DXGI_FORMAT_R8G8B8A8_UNORM);
 
@@ -26,38 +29,47 @@ Styles::~Styles() {
 
 void Styles::Delete(u32 id) {
     styles_.erase(styles_.begin() + id);
+    UpdateTableRows();
+    generation_++;
     selectedId_ = UnselectedId;
     needsSaving_ = true;
 }
 
 void Styles::DrawMenu(Keybind** currentEditedKeybind) {
     drewMenu_ = true;
-    auto saveCheck = [this](bool changed) {
+    bool thresholdsChanged = false;
+    auto saveCheck = [&](bool changed) {
         needsSaving_ = needsSaving_ || changed;
+        thresholdsChanged = thresholdsChanged || changed;
         return changed;
     };
 
     ImGuiTitle("Styles");
 
     if(ImGui::BeginListBox("##StylesList", ImVec2(-FLT_MIN, 0.f))) {
-        for(auto it : styles_ | ranges::views::enumerate) {
-            // Need explicit types to shut up IntelliSense, still present as of 17.5.1
-            u32 sid = static_cast<u32>(it.first);
-            Style& s = it.second;
-
-            if(ImGui::Selectable(s.name.c_str(), selectedId_ == sid, ImGuiSelectableFlags_AllowItemOverlap))
-                selectedId_ = sid;
-
-            if(sid != 0 && !s.builtIn && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem) || ImGui::IsItemActive()) {
-                auto& style = ImGui::GetStyle();
-                auto orig = style.Colors[ImGuiCol_Button];
-                style.Colors[ImGuiCol_Button] *= ImVec4(0.5f, 0.5f, 0.5f, 1.f);
-                if(ImGuiClose(std::format("CloseItem{}", sid).c_str(), 0.75f, false)) {
+        ImGuiListClipper clipper;
+        clipper.Begin(i32(styles_.size()));
+        while(clipper.Step()) {
+            for(u32 sid = u32(clipper.DisplayStart); sid < u32(clipper.DisplayEnd); sid++) {
+                Style& s = styles_[sid];
+
+                ImGui::PushID(i32(sid));
+                if(ImGui::Selectable(s.name.c_str(), selectedId_ == sid, ImGuiSelectableFlags_AllowItemOverlap))
                     selectedId_ = sid;
-                    Core::i().DisplayDeletionMenu({ s.name, "style", "", selectedId_ });
-                }
 
-                style.Colors[ImGuiCol_Button] = orig;
+                if(sid != 0 && !s.builtIn && ImGui::IsItemHovered(ImGuiHoveredFlags_AllowWhenBlockedByActiveItem) ||
+                   ImGui::IsItemActive()) {
+                    auto& style = ImGui::GetStyle();
+                    auto orig = style.Colors[ImGuiCol_Button];
+                    style.Colors[ImGuiCol_Button] *= ImVec4(0.5f, 0.5f, 0.5f, 1.f);
+                    if(ImGuiClose("CloseItem", 0.75f, false)) {
+                        selectedId_ = sid;
+                        Core::i().DisplayDeletionMenu({ s.name, "style", "", selectedId_ });
+                    }
+
+                    style.Colors[ImGuiCol_Button] = orig;
+                }
+                ImGui::PopID();
             }
         }
         ImGui::EndListBox();
@@ -70,12 +82,16 @@ void Styles::DrawMenu(Keybind** currentEditedKeybind) {
 
             styles_.emplace_back(name);
             selectedId_ = u32(styles_.size()) - 1;
+            UpdateTableRows();
+            generation_++;
         }
 
         {
             ImGuiDisabler d(selectedId_ == UnselectedId);
             ImGui::SameLine();
-            if(ImGui::Button(std::format("Duplicate{}", d.disabled() ? "" : std::format(" '{}'", styles_[selectedId_].name)).c_str())) {
+            const auto duplicateLabel = d.disabled() ? FixedLabel<>("Duplicate###Duplicate")
+                                                     : FixedLabel<>("Duplicate '{}'###Duplicate", styles_[selectedId_].name);
+            if(ImGui::Button(duplicateLabel.c_str())) {
                 styles_.push_back(styles_[selectedId_]);
                 auto& s = styles_.back();
                 auto baseName = s.name;
@@ -86,6 +102,8 @@ void Styles::DrawMenu(Keybind** currentEditedKeybind) {
                 }
                 selectedId_ = u32(styles_.size()) - 1;
                 needsSaving_ = true;
+                UpdateTableRows();
+                generation_++;
             }
         }
     }
@@ -119,6 +137,7 @@ void Styles::DrawMenu(Keybind** currentEditedKeybind) {
                         th.thresholdMin = r[0];
                         th.thresholdMax = r[1];
                         needsSaving_ = true;
+                        thresholdsChanged = true;
                     }
 
                     if(selected)
@@ -162,9 +181,9 @@ void Styles::DrawMenu(Keybind** currentEditedKeybind) {
                 else {
                     auto& th = s.thresholds[selectedThresholdId_];
                     if(th.thresholdMin == th.thresholdMax)
-                        ImGui::TextUnformatted(std::format("At {} stacks:", th.thresholdMin).c_str());
+                        ImGui::TextUnformatted(FixedLabel<>("At {} stacks:", th.thresholdMin).c_str());
                     else
-                        ImGui::TextUnformatted(std::format("Between {} and {} stacks:", th.thresholdMin, th.thresholdMax).c_str());
+                        ImGui::TextUnformatted(FixedLabel<>("Between {} and {} stacks:", th.thresholdMin, th.thresholdMax).c_str());
                     auto& app = th.appearance;
 
                     ImGui::TextUnformatted("Priority control:");
@@ -173,6 +192,7 @@ void Styles::DrawMenu(Keybind** currentEditedKeybind) {
                         if(ImGui::Button("Move up")) {
                             std::swap(s.thresholds[selectedThresholdId_], s.thresholds[selectedThresholdId_ - 1]);
                             selectedThresholdId_--;
+                            saveCheck(true);
                         }
 
                         ImGui::SameLine();
@@ -182,6 +202,7 @@ void Styles::DrawMenu(Keybind** currentEditedKeybind) {
                         if(ImGui::Button("Move down")) {
                             std::swap(s.thresholds[selectedThresholdId_], s.thresholds[selectedThresholdId_ + 1]);
                             selectedThresholdId_++;
+                            saveCheck(true);
                         }
                     }
 
@@ -205,18 +226,25 @@ void Styles::DrawMenu(Keybind** currentEditedKeybind) {
                     if(ImGui::Button("Delete selected")) {
                         s.thresholds.erase(s.thresholds.begin() + selectedThresholdId_);
                         selectedThresholdId_ = UnselectedId;
+                        saveCheck(true);
                     }
                 }
             }
         }
     }
 
+    // Only the edited style is recompiled, right away so the preview and grids follow the edit
+    if(thresholdsChanged)
+        BuildCache(selectedId_);
+
     mstime currentTime = TimeInMilliseconds();
     if(needsSaving_ && lastSaveTime_ + SaveDelay <= currentTime)
         Save();
 }
 
 void Styles::Draw(ComPtr<ID3D11DeviceContext>& ctx) {
+    GW2_PROFILE_SCOPE("Styles::Draw");
+
     if(selectedId_ == UnselectedId || !drewMenu_)
         return;
 
@@ -243,149 +271,32 @@ void Styles::Draw(ComPtr<ID3D11DeviceContext>& ctx) {
         return;
 
     GridInstanceData data { .posDims = { 0.5f, 0.5f, 1.f, 1.f },
-                            .uv = previewBuff_->uv,
-                            .numberUV = buffs_->GetNumber(previewCount_),
-                            .showNumber = previewBuff_->ShowNumber(previewCount_) };
+                            .atlasSlot = previewBuff_->atlasSlot,
+                            .number = previewBuff_->ShowNumber(previewCount_) ? previewCount_ : 0 };
     ApplyStyle(selectedId_, previewCount_, data);
 
-    previewRenderer_.Add(std::move(data));
+    previewRenderer_.Add(data);
     previewRenderer_.Draw(ctx, true, &preview_, false);
 }
 
-void Styles::Load() {
-    using namespace std::literals;
-    using namespace nlohmann;
-    styles_.clear();
-
-    styles_.emplace_back("Simple On/Off (hidden)"sv, ThresholdBuilder().tint(0.f, 0.f), ThresholdBuilder().min(1).max(99));
-    styles_.emplace_back("Simple On/Off (faded)"sv, ThresholdBuilder().tint(0.75f, 0.25f), ThresholdBuilder().min(1).max(99));
-    styles_.emplace_back("Simple On/Off (red faded)"sv, ThresholdBuilder().tint(1.f, 0.f, 0.f, 0.25f), ThresholdBuilder().min(1).max(99));
-    styles_.emplace_back("0/5/20 Stacks (green)"sv, ThresholdBuilder().min(0).max(4).tint(0.75f, 0.25f),
-                         ThresholdBuilder().min(5).max(19).tint(0.75f, 0.65f),
-                         ThresholdBuilder().min(20).max(100).tint(0.25f, 1.f, 0.25f, 1.f));
-
-    auto& cfg = JSONConfigurationFile::i();
-    cfg.Reload();
-
-    auto getvec4 = [](const json& j) {
-        return vec4(j[0].get<f32>(), j[1].get<f32>(), j[2].get<f32>(), j[3].get<f32>());
-    };
-    auto getvec2 = [](const json& j) {
-        return vec2(j[0].get<f32>(), j[1].get<f32>());
-    };
-    auto maybe_at = []<typename D>(const json& j, const char* n, const D& def,
-                                   const std::variant<std::monostate, std::function<D(const json&)>>& cvt = {}) {
-        auto it = j.find(n);
-        if(it == j.end())
-            return def;
-        if(cvt.index() == 0)
-            return static_cast<D>(*it);
-        return std::get<1>(cvt)(*it);
-    };
-
-    const auto& sets = cfg.json()["styles"];
-    for(const auto& sIn : sets) {
-        Style s {};
-        s.name = sIn["name"];
-
-        for(const auto& tIn : sIn["thresholds"]) {
-            Threshold t;
-            t.thresholdMin = maybe_at(tIn, "threshold_min", 0);
-            t.thresholdMax = maybe_at(tIn, "threshold_max", 1);
-            auto& app = t.appearance;
-            app.tint = maybe_at(tIn, "tint", vec4(1), { getvec4 });
-            app.border = maybe_at(tIn, "border", vec4(0), { getvec4 });
-            app.glow = maybe_at(tIn, "glow", vec4(0), { getvec4 });
-            app.borderThickness = maybe_at(tIn, "border_thickness", 0.f);
-            app.glowSize = maybe_at(tIn, "glow_size", 0.f);
-            app.glowPulse = maybe_at(tIn, "glow_pulse", vec2(0), { getvec2 });
-            s.thresholds.push_back(t);
-        }
-
-        styles_.push_back(s);
-    }
+void Styles::Load(const ConfigSource& config) {
+    GW2_PROFILE_SCOPE("Styles::Load");
 
-    BuildCache();
+    config.LoadStyles(*this);
 }
 
 void Styles::Save() {
-    using namespace nlohmann;
-
-    auto& cfg = JSONConfigurationFile::i();
-
-    auto& styles = cfg.json()["styles"];
-    styles = json::array();
-    for(const auto& s : styles_) {
-        if(s.builtIn)
-            continue;
-
-        json style;
-        style["name"] = s.name;
-
-        json& styleThresholds = style["thresholds"];
-        for(const auto& t : s.thresholds) {
-            json threshold;
-            threshold["threshold_min"] = t.thresholdMin;
-            threshold["threshold_max"] = t.thresholdMax;
-            auto& app = t.appearance;
-            threshold["tint"] = { app.tint.x, app.tint.y, app.tint.z, app.tint.w };
-            threshold["border"] = { app.border.x, app.border.y, app.border.z, app.border.w };
-            threshold["glow"] = { app.glow.x, app.glow.y, app.glow.z, app.glow.w };
-            threshold["border_thickness"] = app.borderThickness;
-            threshold["glow_size"] = app.glowSize;
-            threshold["glow_pulse"] = { app.glowPulse.x, app.glowPulse.y };
-
-            styleThresholds.push_back(threshold);
-        }
+    GW2_PROFILE_SCOPE("Styles::Save");
 
-        styles.push_back(style);
-    }
+    // Copying a style drops its built-in flag, but built-in styles aren't saved anyway
+    std::vector<Style> userStyles;
+    for(const auto& s : styles_)
+        if(!s.builtIn)
+            userStyles.push_back(s);
 
-    cfg.Save();
+    Core::i().configPersistence().Submit("styles", [styles = std::move(userStyles)] { return SaveStyles(styles); });
 
     needsSaving_ = false;
     lastSaveTime_ = TimeInMilliseconds();
-
-    BuildCache();
-}
-
-void Styles::BuildCache() {
-    for(auto& s : styles_) {
-        ranges::fill(s.appearanceCache, Appearance {});
-
-        // Reverse iteration order so low priority appearance is set first and overwritten by high priority ones
-        for(const auto& th : s.thresholds | ranges::views::reverse)
-            ranges::fill(s.appearanceCache.begin() + th.thresholdMin,
-                         s.appearanceCache.begin() + std::min(th.thresholdMax + 1, u32(s.appearanceCache.size())), th.appearance);
-
-        // Normal iteration order to find first threshold at 100, if any
-        for(const auto& th : s.thresholds)
-            if(th.thresholdMax >= 100) {
-                s.appearanceAbove = th.appearance;
-                break;
-            }
-    }
-}
-
-void Styles::ApplyStyle(u32 id, i32 count, GridInstanceData& out) const {
-    if(id >= styles_.size() || count < 0)
-        return;
-
-    const auto& style = styles_.at(id);
-    if(auto appPair = style[count]; appPair.first) {
-        const auto& app = appPair.second;
-        if(app.glowPulse.x > 0.f) {
-            auto currentTime = TimeInMilliseconds();
-            f32 x = sinf(static_cast<f32>(currentTime) / 1000.f * 2.f * std::numbers::pi_v<f32> * app.glowPulse.y) * 0.5f + 0.5f;
-            out.glowSize.x = glm::mix(1.f - app.glowPulse.x, 1.f, x) * app.glowSize;
-            out.glowSize.y = app.glowSize;
-        }
-        else
-            out.glowSize = vec2(app.glowSize);
-        out.borderColor = app.border;
-        out.borderThickness = app.borderThickness;
-        out.glowColor = app.glowSize > 0.f ? app.glow : vec4(0.f);
-        out.tint = app.tint;
-    }
 }
 } // namespace GW2Clarity
@@ -0,0 +1,52 @@
+// Stand-in for getbuffs.dll, generating buffs from a scripted scenario so the addon, benchmarks and load tests can run without the
+// game. The scenario is read from the file named by the GW2CLARITY_BUFF_SCENARIO environment variable, see ScriptedBuffSource for
+// its format and scenarios/ for examples. Without one, a steady moderate churn is simulated.
+
+#include <cstdlib>
+#include <fstream>
+
+#include "BuffCatalog.h"
+#include "BuffSource.h"
+
+#ifdef _WIN32
+#define GETBUFFS_EXPORT extern "C" __declspec(dllexport)
+#define GETBUFFS_CALL __cdecl
+#else
+#define GETBUFFS_EXPORT extern "C" __attribute__((visibility("default")))
+#define GETBUFFS_CALL
+#endif
+
+using namespace GW2Clarity;
+
+namespace
+{
+nlohmann::json LoadScenario() {
+    if(const char* path = std::getenv("GW2CLARITY_BUFF_SCENARIO")) {
+        std::ifstream file(path);
+        auto scenario = nlohmann::json::parse(file, nullptr, false);
+        if(!scenario.is_discarded())
+            return scenario;
+        LogError("Could not parse buff scenario {}, using the default one.", path);
+    }
+
+    return nlohmann::json::parse(R"({
+        "seed": 1,
+        "loop": true,
+        "phases": [
+            { "frames": 6000, "active": 40, "churn": 0.01, "stack_change": 0.05, "unknown": 0.02 },
+            { "frames": 100, "error": -3 }
+        ]
+    })");
+}
+
+ScriptedBuffSource& Source() {
+    static ScriptedBuffSource source = [] {
+        // Every primary and extra ID of the catalog
+        const auto ids = CompiledBuffCatalog().slots().ids();
+        return ScriptedBuffSource(LoadScenario(), std::vector<u32>(ids.begin(), ids.end()));
+    }();
+    return source;
+}
+} // namespace
+
+GETBUFFS_EXPORT StackedBuff* GETBUFFS_CALL GetCurrentPlayerStackedBuffs() { return Source().GetBuffs(); }
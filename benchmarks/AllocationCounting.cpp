@@ -0,0 +1,71 @@
+#include "BenchmarkSupport.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+std::atomic<u64> g_AllocationCount { 0 };
+
+void* Allocate(size_t size) noexcept {
+    g_AllocationCount.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+} // namespace
+
+// Counting every allocation lets the benchmarks catch hot paths that regress from allocation-free to allocating, which raw timings hide.
+// Every replaceable form except the aligned ones is replaced together, so that memory always returns to the allocator it came from. They
+// live alone in this file so that GCC cannot inline them into callers and mistake the free below for a mismatched deallocation.
+void* operator new(size_t size) {
+    if(void* p = Allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size) {
+    if(void* p = Allocate(size))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return Allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+namespace GW2Clarity::Bench
+{
+
+u64 AllocationCount() {
+    return g_AllocationCount.load(std::memory_order_relaxed);
+}
+
+} // namespace GW2Clarity::Bench
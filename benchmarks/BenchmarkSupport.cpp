@@ -0,0 +1,157 @@
+#include "BenchmarkSupport.h"
+
+#include <random>
+#include <ranges>
+
+namespace GW2Clarity::Bench
+{
+
+const Catalog& Catalog::Get() {
+    static const Catalog catalog = [] {
+        Catalog c;
+        for(const auto& b : c.buffs.buffs())
+            if(!b.isCategory())
+                c.real.push_back(&b);
+        return c;
+    }();
+    return catalog;
+}
+
+std::vector<StackedBuff> MakeBuffFeed(size_t active, u32 seed) {
+    const auto& catalog = Catalog::Get();
+    std::mt19937 rng(seed);
+
+    std::vector<const Buff*> shuffled = catalog.real;
+    std::ranges::shuffle(shuffled, rng);
+
+    std::vector<StackedBuff> feed;
+    feed.reserve(active + 1);
+    for(size_t i = 0; i < active; i++) {
+        const i32 count = i32(rng() % 25) + 1;
+        // High IDs are well clear of anything in the catalog
+        if(i % 20 == 19)
+            feed.push_back({ 0x7FFF0000u + u32(i), count });
+        else
+            feed.push_back({ shuffled[i % shuffled.size()]->id, count });
+    }
+    feed.push_back({ 0, 0 });
+
+    return feed;
+}
+
+LegacyStyleCache::LegacyStyleCache(const StyleTable::Style& s) {
+    std::ranges::fill(appearanceCache, StyleTable::Appearance {});
+    appearanceAbove = {};
+
+    // Reverse iteration order so low priority appearance is set first and overwritten by high priority ones
+    for(const auto& th : s.thresholds | std::views::reverse)
+        if(th.thresholdMin < appearanceCache.size())
+            std::fill(appearanceCache.begin() + th.thresholdMin,
+                      appearanceCache.begin() + std::min(th.thresholdMax + 1, u32(appearanceCache.size())), th.appearance);
+
+    // Normal iteration order to find first threshold at 100, if any
+    for(const auto& th : s.thresholds)
+        if(th.thresholdMax >= 100) {
+            appearanceAbove = th.appearance;
+            break;
+        }
+}
+
+void LegacyStyleCache::ApplyStyle(i32 count, GridInstanceData& out) const {
+    if(count < 0)
+        return;
+
+    const auto& app = count < i32(appearanceCache.size()) ? appearanceCache[count] : appearanceAbove;
+    out.glowSize = app.glowSize;
+    if(app.glowPulse.x > 0.f) {
+        out.glowPulse.x = app.glowPulse.x;
+        out.glowPulse.y = app.glowPulse.y;
+    }
+    out.borderColor = app.border;
+    out.borderThickness = app.borderThickness;
+    out.glowColor = app.glowSize > 0.f ? app.glow : vec4(0.f);
+    out.tint = app.tint;
+}
+
+nlohmann::json MakeStylesConfig(size_t styleCount, size_t thresholdCount, u32 seed) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<f32> unit(0.f, 1.f);
+
+    nlohmann::json styles = nlohmann::json::array();
+    for(size_t s = 0; s < styleCount; s++) {
+        nlohmann::json style;
+        style["name"] = "Style " + std::to_string(s);
+
+        nlohmann::json& thresholds = style["thresholds"];
+        thresholds = nlohmann::json::array();
+        i32 min = 0;
+        for(size_t t = 0; t < thresholdCount; t++) {
+            const i32 max = t + 1 == thresholdCount ? 1500 : min + i32(rng() % 10);
+            nlohmann::json threshold;
+            threshold["threshold_min"] = min;
+            threshold["threshold_max"] = max;
+            // Few distinct tints so the palette deduplicates as it would with hand-made styles
+            threshold["tint"] = { 1.f, 1.f, 1.f, f32(rng() % 4) * 0.25f };
+            threshold["border"] = { unit(rng), unit(rng), unit(rng), 1.f };
+            threshold["border_thickness"] = f32(rng() % 3);
+            thresholds.push_back(threshold);
+            min = max + 1;
+        }
+
+        styles.push_back(style);
+    }
+
+    return styles;
+}
+
+std::vector<Grid> MakeGrids(size_t itemCount, size_t itemsPerGrid, const StyleTable& styles, u32 seed) {
+    const auto& catalog = Catalog::Get();
+    std::mt19937 rng(seed);
+
+    std::vector<Grid> grids;
+    for(size_t i = 0; i < itemCount; i++) {
+        if(i % itemsPerGrid == 0) {
+            grids.emplace_back();
+            grids.back().name = "Grid " + std::to_string(grids.size());
+        }
+
+        auto& items = grids.back().items;
+        const i32 local = i32(items.size());
+
+        GridItem item;
+        item.pos = { local % 10, local / 10 };
+        item.buff = catalog.real[rng() % catalog.real.size()];
+        item.style = u32(rng() % styles.styles().size());
+        if(rng() % 8 == 0)
+            item.additionalBuffs.push_back(catalog.real[rng() % catalog.real.size()]);
+        items.push_back(std::move(item));
+    }
+
+    return grids;
+}
+
+std::string MakeConfigDocument(size_t itemCount, u32 seed) {
+    nlohmann::json config;
+    config["styles"] = MakeStylesConfig(16, 4, seed);
+
+    StyleTable styles;
+    styles.LoadStyles(config["styles"]);
+    std::vector<std::string> styleNames;
+    for(const auto& s : styles.styles())
+        styleNames.push_back(s.name);
+
+    const auto grids = MakeGrids(itemCount, 50, styles, seed + 1);
+    config["buff_grids"] = SaveGrids(grids, styleNames);
+
+    std::vector<Layout> layouts(4);
+    for(size_t l = 0; l < layouts.size(); l++) {
+        layouts[l].name = "Layout " + std::to_string(l);
+        for(size_t g = l; g < grids.size(); g += layouts.size())
+            layouts[l].grids.insert(i32(g));
+    }
+    config["buff_layouts"] = SaveLayouts(layouts);
+
+    return config.dump(4);
+}
+
+} // namespace GW2Clarity::Bench
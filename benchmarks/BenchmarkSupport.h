@@ -0,0 +1,80 @@
+#pragma once
+
+#include <benchmark/benchmark.h>
+
+#include "BuffCatalog.h"
+#include "GridConfig.h"
+#include "LayoutConfig.h"
+#include "StyleTable.h"
+
+namespace GW2Clarity::Bench
+{
+
+// Number of calls to the global operator new made so far by any thread
+[[nodiscard]] u64 AllocationCount();
+
+// Reports the allocations made between construction and destruction as the "allocs/op" counter, averaged over iterations
+class AllocationCounter
+{
+public:
+    explicit AllocationCounter(benchmark::State& state) : state_(state), start_(AllocationCount()) { }
+    ~AllocationCounter() {
+        state_.counters["allocs/op"] = benchmark::Counter(f64(AllocationCount() - start_), benchmark::Counter::kAvgIterations);
+    }
+
+private:
+    benchmark::State& state_;
+    u64 start_;
+};
+
+// The compiled buff catalog Buffs uses
+struct Catalog
+{
+    const BuffCatalog& buffs = CompiledBuffCatalog();
+    // Every real buff, category headers excluded
+    std::vector<const Buff*> real;
+
+    [[nodiscard]] static const Catalog& Get();
+};
+
+// StyleTable whose cache can be rebuilt from outside
+class BenchStyleTable : public StyleTable
+{
+public:
+    using StyleTable::BuildCache;
+
+    // Heap bytes of the compiled lookup, shared palette included, excluding the thresholds it is compiled from
+    [[nodiscard]] size_t LookupBytes() const {
+        size_t bytes = palette_.capacity() * sizeof(Appearance);
+        for(const auto& s : styles_)
+            bytes += s.breakpoints.capacity() * sizeof(u32) + s.appearances.capacity() * sizeof(u16);
+        return bytes;
+    }
+};
+
+// Copy of the lookup styles used before thresholds were compiled into breakpoints: one appearance for each count below 100, and one
+// for every higher count
+struct LegacyStyleCache
+{
+    std::array<StyleTable::Appearance, 100> appearanceCache;
+    StyleTable::Appearance appearanceAbove;
+
+    explicit LegacyStyleCache(const StyleTable::Style& s);
+
+    void ApplyStyle(i32 count, GridInstanceData& out) const;
+};
+
+// A null-terminated getbuffs result with the given number of distinct active buffs. One in twenty IDs is unknown to the catalog,
+// to exercise the overflow table.
+[[nodiscard]] std::vector<StackedBuff> MakeBuffFeed(size_t active, u32 seed);
+
+// Styles in the configuration file format, each with thresholdCount adjacent intervals of varying appearance
+[[nodiscard]] nlohmann::json MakeStylesConfig(size_t styleCount, size_t thresholdCount, u32 seed);
+
+// Grids of up to itemsPerGrid items each, totalling itemCount items tracking random catalog buffs and styles
+[[nodiscard]] std::vector<Grid> MakeGrids(size_t itemCount, size_t itemsPerGrid, const StyleTable& styles, u32 seed);
+
+// A whole configuration file as the addon writes it, with 16 styles, itemCount items in grids of 50 and four layouts
+[[nodiscard]] std::string MakeConfigDocument(size_t itemCount, u32 seed);
+
+} // namespace GW2Clarity::Bench
@@ -0,0 +1,173 @@
+// Replays a buff trace recorded by the addon through the buff table and grid instance building as fast as possible, reporting
+// throughput and the slowest frames along with where they occurred in the trace.
+//
+// Usage: GW2ClarityTraceReplay <trace> [GW2Clarity.json] [--repeat N] [--json] [--all]
+// Without a configuration file, generated styles and grids stand in for the player's. Frames the addon would skip, being identical to the
+// previous one or during an error back-off, are skipped unless --all is given.
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "BenchmarkSupport.h"
+#include "BuffPoller.h"
+#include "BuffTrace.h"
+
+using namespace GW2Clarity;
+using namespace GW2Clarity::Bench;
+
+namespace
+{
+struct FrameSample
+{
+    u64 ns;
+    u64 traceTimeUs;
+    u32 buffCount;
+};
+
+std::string FormatTraceTime(u64 us) {
+    const u64 ms = us / 1000;
+    std::array<char, 32> buf;
+    std::snprintf(buf.data(), buf.size(), "%02llu:%02llu:%02llu.%03llu", (unsigned long long)(ms / 3600000),
+                  (unsigned long long)(ms / 60000 % 60), (unsigned long long)(ms / 1000 % 60), (unsigned long long)(ms % 1000));
+    return buf.data();
+}
+} // namespace
+
+int main(int argc, char** argv) {
+    std::filesystem::path tracePath, configPath;
+    u32 repeat = 1;
+    bool json = false;
+    bool all = false;
+    for(int i = 1; i < argc; i++) {
+        std::string_view arg = argv[i];
+        if(arg == "--repeat" && i + 1 < argc)
+            repeat = std::max(1u, u32(std::strtoul(argv[++i], nullptr, 10)));
+        else if(arg == "--json")
+            json = true;
+        else if(arg == "--all")
+            all = true;
+        else if(tracePath.empty())
+            tracePath = arg;
+        else if(configPath.empty())
+            configPath = arg;
+        else {
+            std::cerr << "Unexpected argument " << arg << "\n";
+            return 1;
+        }
+    }
+    if(tracePath.empty()) {
+        std::cerr << "Usage: " << argv[0] << " <trace> [GW2Clarity.json] [--repeat N] [--json] [--all]\n";
+        return 1;
+    }
+
+    const auto& catalog = Catalog::Get();
+    BenchStyleTable styles;
+    std::vector<Grid> grids;
+    if(!configPath.empty()) {
+        std::ifstream configFile(configPath);
+        const auto config = nlohmann::json::parse(configFile, nullptr, false);
+        if(config.is_discarded()) {
+            std::cerr << "Could not parse " << configPath.string() << "\n";
+            return 1;
+        }
+
+        styles.LoadStyles(config.contains("styles") ? config["styles"] : nlohmann::json::array());
+        grids = LoadGrids(config.contains("buff_grids") ? config["buff_grids"] : nlohmann::json::array(), catalog.buffs, styles);
+    }
+    else {
+        styles.LoadStyles(MakeStylesConfig(16, 4, 1));
+        grids = MakeGrids(500, 50, styles, 1);
+    }
+
+    std::vector<u32> stackSources;
+    CompileStackSources(grids, catalog.buffs.slots(), stackSources);
+    const size_t itemCount =
+        std::accumulate(grids.begin(), grids.end(), size_t(0), [](size_t n, const Grid& g) { return n + g.items.size(); });
+
+    ActiveBuffsTable table(&catalog.buffs.slots());
+    const vec2 screen { 1920.f, 1080.f };
+    GridMouseState mouse;
+    mouse.position = screen * 0.25f;
+    std::vector<PackedGridInstanceData> instances;
+    instances.reserve(itemCount);
+
+    std::vector<FrameSample> samples;
+    BuffTraceFrame frame;
+    size_t skipped = 0;
+    for(u32 r = 0; r < repeat; r++) {
+        BuffPoller poller;
+        BuffTraceReader reader;
+        if(!reader.Open(tracePath))
+            return 1;
+
+        // Decoding is left out of the measurements, only what the addon does with each getbuffs result is timed
+        while(reader.Next(frame)) {
+            const auto start = std::chrono::steady_clock::now();
+
+            if(all || (poller.ShouldPoll() && poller.Changed(frame.buffs.data()))) {
+                table.Assign(frame.buffs.data());
+                instances.clear();
+                for(const auto& g : grids) {
+                    BuildGridInstances(g, g.ComputeOrigin(false, screen, mouse), screen, styles, table.counts(), stackSources, -1, 0,
+                                       instances);
+                }
+            }
+            else
+                skipped++;
+
+            const auto end = std::chrono::steady_clock::now();
+            samples.push_back({ u64(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()), frame.timeUs,
+                                u32(frame.buffs.size() - 1) });
+        }
+        // Traces cut short by a crash are still worth replaying up to the damage
+        if(reader.failed())
+            std::cerr << "Only the frames before the damaged part of the trace were replayed\n";
+    }
+
+    if(samples.empty()) {
+        std::cerr << "Trace is empty\n";
+        return 1;
+    }
+
+    const u64 totalNs = std::accumulate(samples.begin(), samples.end(), u64(0), [](u64 n, const FrameSample& s) { return n + s.ns; });
+    std::vector<u64> sorted(samples.size());
+    std::ranges::transform(samples, sorted.begin(), &FrameSample::ns);
+    std::ranges::sort(sorted);
+    auto percentile = [&](f64 p) { return sorted[std::min(sorted.size() - 1, size_t(p * f64(sorted.size())))]; };
+
+    std::vector<FrameSample> slowest = samples;
+    const size_t slowestCount = std::min<size_t>(10, slowest.size());
+    std::ranges::partial_sort(slowest, slowest.begin() + slowestCount, std::ranges::greater {}, &FrameSample::ns);
+    slowest.resize(slowestCount);
+
+    const f64 framesPerSecond = f64(samples.size()) * 1e9 / f64(std::max<u64>(totalNs, 1));
+    if(json) {
+        nlohmann::json out;
+        out["frames"] = samples.size();
+        out["skipped"] = skipped;
+        out["grids"] = grids.size();
+        out["items"] = itemCount;
+        out["frames_per_second"] = framesPerSecond;
+        out["mean_ns"] = totalNs / samples.size();
+        out["p50_ns"] = percentile(0.5);
+        out["p99_ns"] = percentile(0.99);
+        out["p999_ns"] = percentile(0.999);
+        out["max_ns"] = sorted.back();
+        out["slowest"] = nlohmann::json::array();
+        for(const auto& s : slowest)
+            out["slowest"].push_back({ { "ns", s.ns }, { "trace_time_us", s.traceTimeUs }, { "buffs", s.buffCount } });
+        std::cout << out.dump(2) << "\n";
+    }
+    else {
+        std::cout << samples.size() << " frames over " << grids.size() << " grids with " << itemCount << " items, "
+                  << 100.0 * f64(skipped) / f64(samples.size()) << "% skipped\n";
+        std::cout << u64(framesPerSecond) << " frames/s, mean " << totalNs / samples.size() << " ns, p50 " << percentile(0.5) << " ns, p99 "
+                  << percentile(0.99) << " ns, p99.9 " << percentile(0.999) << " ns, max " << sorted.back() << " ns\n";
+        std::cout << "Slowest frames:\n";
+        for(const auto& s : slowest)
+            std::cout << "  " << s.ns << " ns at " << FormatTraceTime(s.traceTimeUs) << " with " << s.buffCount << " buffs\n";
+    }
+
+    return 0;
+}
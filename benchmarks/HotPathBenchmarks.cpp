@@ -0,0 +1,479 @@
+// Per-frame hot path of the addon, run against the real catalog with synthetic buff feeds and configurations.
+// Use --benchmark_format=json or --benchmark_out=<file> for machine-readable results; every benchmark reports "allocs/op".
+
+#include <charconv>
+#include <random>
+
+#include "BenchmarkSupport.h"
+#include "BuffPoller.h"
+#include "BuffSearch.h"
+#include "BuffSource.h"
+#include "BuffStats.h"
+#include "LabelCache.h"
+#include "Profiler.h"
+
+using namespace GW2Clarity;
+using namespace GW2Clarity::Bench;
+
+// Buffs::UpdateBuffsTable minus the triple buffer handoff
+static void BM_UpdateBuffsTable(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    const auto feed = MakeBuffFeed(size_t(state.range(0)), 1);
+    ActiveBuffsTable table(&catalog.buffs.slots());
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        u32 dropped = table.Assign(feed.data());
+        benchmark::DoNotOptimize(dropped);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_UpdateBuffsTable)->Arg(10)->Arg(30)->Arg(100)->Arg(300);
+
+// Change detection run on every getbuffs result, the whole cost of a poll whose result is unchanged
+static void BM_BuffPollerUnchanged(benchmark::State& state) {
+    const auto feed = MakeBuffFeed(size_t(state.range(0)), 1);
+    BuffPoller poller;
+    poller.Changed(feed.data());
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        bool changed = poller.ShouldPoll() && poller.Changed(feed.data());
+        benchmark::DoNotOptimize(changed);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BuffPollerUnchanged)->Arg(10)->Arg(30)->Arg(100)->Arg(300);
+
+// Core::InnerFrequentUpdate's polling, through the same library loading as the addon, against the getbuffs stand-in's default
+// scenario
+static void BM_PollStandIn(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    auto source = LibraryBuffSource::Load(GW2CLARITY_STANDIN_PATH);
+    if(!source) {
+        state.SkipWithError("Could not load the getbuffs stand-in");
+        return;
+    }
+    ActiveBuffsTable table(&catalog.buffs.slots());
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        u32 dropped = table.Assign(source->GetBuffs());
+        benchmark::DoNotOptimize(dropped);
+    }
+}
+BENCHMARK(BM_PollStandIn);
+
+static void BM_GetStacksCatalog(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    const auto feed = MakeBuffFeed(100, 2);
+    ActiveBuffsTable table(&catalog.buffs.slots());
+    table.Assign(feed.data());
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        i32 total = 0;
+        for(const Buff* b : catalog.real)
+            total += b->GetStacks(table);
+        benchmark::DoNotOptimize(total);
+    }
+    state.SetItemsProcessed(state.iterations() * i64(catalog.real.size()));
+}
+BENCHMARK(BM_GetStacksCatalog);
+
+// Instance building as done by Grids::DrawItems for every grid, with a 1080p screen and no item being edited
+static void BM_BuildGridInstances(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    BenchStyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(16, 4, 3));
+
+    auto grids = MakeGrids(size_t(state.range(0)), 50, styles, 4);
+    std::vector<u32> stackSources;
+    CompileStackSources(grids, catalog.buffs.slots(), stackSources);
+
+    const auto feed = MakeBuffFeed(100, 5);
+    ActiveBuffsTable table(&catalog.buffs.slots());
+    table.Assign(feed.data());
+
+    const vec2 screen { 1920.f, 1080.f };
+    GridMouseState mouse;
+    mouse.position = screen * 0.25f;
+    std::vector<PackedGridInstanceData> instances;
+    instances.reserve(size_t(state.range(0)));
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        instances.clear();
+        for(const auto& g : grids)
+            BuildGridInstances(g, g.ComputeOrigin(false, screen, mouse), screen, styles, table.counts(), stackSources, -1, 0, instances);
+        benchmark::DoNotOptimize(instances.data());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BuildGridInstances)->Arg(1)->Arg(10)->Arg(100)->Arg(1000)->Arg(5000);
+
+// Buffs::UpdateBuffsTable's diff against the previously published counts, arguments are the number of active buffs
+static void BM_DiffBuffsTable(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    ActiveBuffsTable previous(&catalog.buffs.slots());
+    previous.Assign(MakeBuffFeed(size_t(state.range(0)), 1).data());
+    ActiveBuffsTable table(&catalog.buffs.slots());
+    table.Assign(MakeBuffFeed(size_t(state.range(0)), 2).data());
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        table.Diff(previous.counts());
+        benchmark::DoNotOptimize(table.changes().data());
+        benchmark::ClobberMemory();
+    }
+    state.counters["changes"] = f64(table.changes().size());
+}
+BENCHMARK(BM_DiffBuffsTable)->Arg(10)->Arg(100)->Arg(300);
+
+// Statistics fed one table's changes every 100ms of simulated time, including the folding of every slot whenever a bucket ends. Arguments
+// are the number of active buffs, which the changes alternate between two random sets of.
+static void BM_BuffStatsUpdate(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    std::array<ActiveBuffsTable, 2> tables { ActiveBuffsTable(&catalog.buffs.slots()), ActiveBuffsTable(&catalog.buffs.slots()) };
+    tables[0].Assign(MakeBuffFeed(size_t(state.range(0)), 1).data());
+    tables[1].Assign(MakeBuffFeed(size_t(state.range(0)), 2).data());
+    tables[0].Diff(tables[1].counts());
+    tables[1].Diff(tables[0].counts());
+
+    mstime now = 0;
+    BuffStats stats(catalog.buffs.slots().size(), now);
+    size_t i = 0, changes = 0;
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        const auto& table = tables[i++ & 1];
+        now += 100;
+        stats.Update(now, table.changes());
+        stats.UpdateCombat(now, (now / 60'000) % 2 == 0);
+        changes += table.changes().size();
+    }
+    state.SetItemsProcessed(i64(changes));
+}
+BENCHMARK(BM_BuffStatsUpdate)->Arg(10)->Arg(100);
+
+// Grids::DrawItems' update of cached instances when only buff counts changed, against 5000 items: only the items depending on a changed
+// slot are rebuilt. Arguments are the number of buffs whose count changes between the two alternating tables, compare with
+// BM_BuildGridInstances/5000 for the full rebuild this replaces.
+static void BM_UpdateChangedItems(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    BenchStyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(16, 4, 3));
+
+    auto grids = MakeGrids(5000, 50, styles, 4);
+    std::vector<u32> stackSources;
+    CompileStackSources(grids, catalog.buffs.slots(), stackSources);
+    GridDependencyIndex dependencies;
+    dependencies.Build(grids, stackSources, catalog.buffs.slots().size());
+
+    // The configured buffs, so that every change has dependents
+    std::vector<StackedBuff> feed;
+    for(const auto& g : grids)
+        for(const auto& i : g.items)
+            if(feed.size() < 100 && std::ranges::find(feed, i.buff->id, &StackedBuff::id) == feed.end())
+                feed.push_back({ i.buff->id, 1 });
+    auto changedFeed = feed;
+    for(size_t i = 0; i < size_t(state.range(0)); i++)
+        changedFeed[i].count++;
+    feed.push_back({ 0, 0 });
+    changedFeed.push_back({ 0, 0 });
+
+    std::array<ActiveBuffsTable, 2> tables { ActiveBuffsTable(&catalog.buffs.slots()), ActiveBuffsTable(&catalog.buffs.slots()) };
+    tables[0].Assign(feed.data());
+    tables[1].Assign(changedFeed.data());
+    tables[0].Diff(tables[1].counts());
+    tables[1].Diff(tables[0].counts());
+
+    const vec2 screen { 1920.f, 1080.f };
+    GridMouseState mouse;
+    mouse.position = screen * 0.25f;
+    std::vector<std::vector<PackedGridInstanceData>> instances(grids.size());
+    for(size_t gid = 0; gid < grids.size(); gid++)
+        BuildGridInstances(grids[gid], grids[gid].ComputeOrigin(false, screen, mouse), screen, styles, tables[0].counts(), stackSources, -1,
+                           0, instances[gid]);
+
+    auto update = [&](const ActiveBuffsTable& table) {
+        size_t rebuilt = 0;
+        for(const auto& change : table.changes())
+            for(Id id : dependencies[change.slot]) {
+                const auto& g = grids[id.grid];
+                const vec2 origin = g.ComputeOrigin(false, screen, mouse);
+                instances[id.grid][id.item] = BuildGridInstance(g, id.item, origin, screen, styles, table.counts(), stackSources, -1, 0);
+                rebuilt++;
+            }
+        return rebuilt;
+    };
+
+    // The updated instances must match a full rebuild
+    update(tables[1]);
+    for(size_t gid = 0; gid < grids.size(); gid++) {
+        std::vector<PackedGridInstanceData> expected;
+        BuildGridInstances(grids[gid], grids[gid].ComputeOrigin(false, screen, mouse), screen, styles, tables[1].counts(), stackSources, -1,
+                           0, expected);
+        if(std::memcmp(expected.data(), instances[gid].data(), expected.size() * sizeof(PackedGridInstanceData)) != 0) {
+            state.SkipWithError("Updated instances differ from a full rebuild");
+            return;
+        }
+    }
+
+    size_t rebuilt = 0, i = 0;
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        rebuilt += update(tables[i++ & 1]);
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(i64(rebuilt));
+}
+BENCHMARK(BM_UpdateChangedItems)->Arg(1)->Arg(10)->Arg(100);
+
+static std::vector<std::pair<u32, i32>> MakeStyleQueries(size_t styleCount) {
+    std::mt19937 rng(7);
+    std::vector<std::pair<u32, i32>> queries(1024);
+    for(auto& [id, count] : queries) {
+        id = u32(rng() % styleCount);
+        count = i32(rng() % 50);
+    }
+    return queries;
+}
+
+// Arguments are the number of thresholds per style
+static void BM_ApplyStyle(benchmark::State& state) {
+    BenchStyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(16, size_t(state.range(0)), 6));
+    const auto queries = MakeStyleQueries(styles.styles().size());
+
+    GridInstanceData inst;
+    size_t i = 0;
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        const auto& [id, count] = queries[i++ & (queries.size() - 1)];
+        styles.ApplyStyle(id, count, inst);
+        benchmark::DoNotOptimize(inst);
+    }
+    state.counters["bytes/style"] = f64(styles.LookupBytes()) / f64(styles.styles().size());
+}
+BENCHMARK(BM_ApplyStyle)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// Baseline for BM_ApplyStyle: the same styles and queries through the former 100-entry appearance array of every style
+static void BM_ApplyStyleLegacy(benchmark::State& state) {
+    BenchStyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(16, size_t(state.range(0)), 6));
+    const auto queries = MakeStyleQueries(styles.styles().size());
+
+    std::vector<LegacyStyleCache> legacy;
+    for(const auto& s : styles.styles())
+        legacy.emplace_back(s);
+
+    for(const auto& [id, count] : queries) {
+        GridInstanceData expected, actual;
+        styles.ApplyStyle(id, count, expected);
+        legacy[id].ApplyStyle(count, actual);
+        if(expected.tint != actual.tint || expected.borderColor != actual.borderColor || expected.glowColor != actual.glowColor ||
+           expected.glowSize != actual.glowSize || expected.borderThickness != actual.borderThickness) {
+            state.SkipWithError("Legacy lookup disagrees with StyleTable");
+            return;
+        }
+    }
+
+    GridInstanceData inst;
+    size_t i = 0;
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        const auto& [id, count] = queries[i++ & (queries.size() - 1)];
+        legacy[id].ApplyStyle(count, inst);
+        benchmark::DoNotOptimize(inst);
+    }
+    state.counters["bytes/style"] = f64(sizeof(LegacyStyleCache));
+}
+BENCHMARK(BM_ApplyStyleLegacy)->Arg(1)->Arg(4)->Arg(16)->Arg(64);
+
+// Arguments are the number of user styles, each with four thresholds
+static void BM_BuildCache(benchmark::State& state) {
+    BenchStyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(size_t(state.range(0)), 4, 8));
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        styles.BuildCache();
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_BuildCache)->Arg(4)->Arg(32)->Arg(256);
+
+// Recompiling the style being edited in the settings menu
+static void BM_BuildCacheSingle(benchmark::State& state) {
+    BenchStyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(size_t(state.range(0)), 4, 9));
+    const u32 edited = u32(styles.styles().size() - 1);
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        styles.BuildCache(edited);
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_BuildCacheSingle)->Arg(4)->Arg(32)->Arg(256);
+
+static const BuffSearchIndex& CatalogSearchIndex() {
+    static const BuffSearchIndex index = [] {
+        BuffSearchIndex i;
+        for(const auto& b : Catalog::Get().buffs.buffs())
+            i.Add(b.name, b.category);
+        i.Build();
+        return i;
+    }();
+    return index;
+}
+
+// The DrawBuffCombo filter for a query typed from scratch
+static void BM_BuffSearchQuery(benchmark::State& state) {
+    static const std::array<std::string_view, 6> Queries { "a", "might", "MIGHT", "boon", "of the", "zzzz" };
+    const auto& index = CatalogSearchIndex();
+    const auto query = Queries[size_t(state.range(0))];
+    BuffSearchResults results;
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        results.valid = false;
+        index.Search(query, results);
+        benchmark::DoNotOptimize(results.indices.data());
+    }
+    state.SetLabel(std::string(query));
+}
+BENCHMARK(BM_BuffSearchQuery)->DenseRange(0, 5);
+
+// The DrawBuffCombo filter as the query is typed one character per frame, narrowing the previous results each time
+static void BM_BuffSearchTyping(benchmark::State& state) {
+    static constexpr std::string_view Typed = "signet of might";
+    const auto& index = CatalogSearchIndex();
+    BuffSearchResults results;
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        results.valid = false;
+        for(size_t n = 0; n <= Typed.size(); n++)
+            index.Search(Typed.substr(0, n), results);
+        benchmark::DoNotOptimize(results.indices.data());
+    }
+    state.SetItemsProcessed(state.iterations() * i64(Typed.size() + 1));
+}
+BENCHMARK(BM_BuffSearchTyping);
+
+// A settings list drawn every frame while it is unchanged, which must neither rebuild its labels nor allocate. Arguments are the number of
+// labels, which are the catalog's buff names with their ImGui IDs as in the Grids item list.
+static void BM_LabelCacheUnchanged(benchmark::State& state) {
+    const auto& real = Catalog::Get().real;
+    const size_t count = std::min(size_t(state.range(0)), real.size());
+    auto build = [&](size_t i, std::string& out) {
+        out += real[i]->name;
+        out += "##";
+        out += std::to_string(i);
+    };
+
+    LabelCache labels;
+    labels.Update(count, build);
+
+    size_t rebuilt = 0;
+    AllocationCounter allocs(state);
+    const u64 allocationsBefore = AllocationCount();
+    for(auto _ : state) {
+        labels.Update(count, [&](size_t i, std::string& out) {
+            rebuilt++;
+            build(i, out);
+        });
+        benchmark::DoNotOptimize(labels[count - 1]);
+    }
+    if(rebuilt != 0)
+        state.SkipWithError("Unchanged labels were rebuilt");
+    else if(AllocationCount() != allocationsBefore)
+        state.SkipWithError("Unchanged labels allocated");
+}
+BENCHMARK(BM_LabelCacheUnchanged)->Arg(10)->Arg(100)->Arg(500);
+
+// Appends v as std::format's "{}" would, without allocating
+static void AppendNumber(std::string& out, i32 v) {
+    std::array<char, 16> buffer;
+    out.append(buffer.data(), std::to_chars(buffer.data(), buffer.data() + buffer.size(), v).ptr);
+}
+
+// Grids::Draw's two list boxes, drawn every frame with every label read rather than only the clipped ones. Arguments are the number of
+// items, in grids of 50, and whether a different grid is selected every frame, which rebuilds the item labels each time. Either way a
+// frame must not allocate once every grid has been shown.
+static void BM_GridsListLabels(benchmark::State& state) {
+    BenchStyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(16, 4, 3));
+    const auto grids = MakeGrids(size_t(state.range(0)), 50, styles, 4);
+    const bool switchGrids = state.range(1) != 0;
+
+    LabelCache gridLabels;
+    LabelCache itemLabels;
+    size_t itemLabelsGrid = grids.size();
+    size_t selected = 0;
+    auto frame = [&] {
+        gridLabels.Update(grids.size(), [&](size_t gid, std::string& out) {
+            const Grid& g = grids[gid];
+            out += g.name;
+            out += " (";
+            AppendNumber(out, g.spacing.x);
+            out += 'x';
+            AppendNumber(out, g.spacing.y);
+            out += ")##";
+            AppendNumber(out, i32(gid));
+        });
+        for(size_t gid = 0; gid < gridLabels.size(); gid++)
+            benchmark::DoNotOptimize(gridLabels[gid]);
+
+        const Grid& g = grids[selected];
+        if(itemLabelsGrid != selected) {
+            itemLabels.Invalidate();
+            itemLabelsGrid = selected;
+        }
+        itemLabels.Update(g.items.size(), [&](size_t iid, std::string& out) {
+            const GridItem& i = g.items[iid];
+            out += i.buff->name;
+            out += " (";
+            AppendNumber(out, i.pos.x);
+            out += ", ";
+            AppendNumber(out, i.pos.y);
+            out += ")##";
+            AppendNumber(out, i32(iid));
+        });
+        for(size_t iid = 0; iid < itemLabels.size(); iid++)
+            benchmark::DoNotOptimize(itemLabels[iid]);
+    };
+
+    // Shows every grid once so that the label buffers reach the capacity the longest list needs
+    for(selected = 0; selected < grids.size(); selected++)
+        frame();
+    selected = 0;
+
+    AllocationCounter allocs(state);
+    const u64 allocationsBefore = AllocationCount();
+    for(auto _ : state) {
+        if(switchGrids)
+            selected = (selected + 1) % grids.size();
+        frame();
+    }
+    if(AllocationCount() != allocationsBefore)
+        state.SkipWithError("Drawing the lists allocated");
+}
+BENCHMARK(BM_GridsListLabels)->ArgsProduct({ { 50, 500, 5000 }, { 0, 1 } });
+
+#ifdef GW2CLARITY_PROFILING
+// Cost of a GW2_PROFILE_SCOPE, which is paid once per instrumented call
+static void BM_ProfileScope(benchmark::State& state) {
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        GW2_PROFILE_SCOPE("BM_ProfileScope");
+        benchmark::ClobberMemory();
+    }
+}
+BENCHMARK(BM_ProfileScope);
+#endif
+
+BENCHMARK_MAIN();
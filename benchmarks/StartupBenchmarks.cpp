@@ -0,0 +1,180 @@
+// Configuration loading as done once at startup by Core::InnerInitPostImGui, for configurations of 10 to 10,000 grid items.
+
+#include <fstream>
+#include <sstream>
+
+#include "BenchmarkSupport.h"
+#include "BuffCatalogFile.h"
+#include "ConfigJson.h"
+#include "ConfigSnapshot.h"
+
+using namespace GW2Clarity;
+using namespace GW2Clarity::Bench;
+
+static void ConfigItemCounts(benchmark::internal::Benchmark* b) {
+    for(i64 items : { 10, 100, 1000, 10000 })
+        b->Arg(items);
+}
+
+// Parsing the whole document once and loading every section out of it
+static void BM_LoadConfig(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    const std::string text = MakeConfigDocument(size_t(state.range(0)), 10);
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        const auto config = nlohmann::json::parse(text);
+        StyleTable styles;
+        styles.LoadStyles(ConfigSection(config, "styles"));
+        auto grids = LoadGrids(ConfigSection(config, "buff_grids"), catalog.buffs, styles);
+        auto layouts = LoadLayouts(ConfigSection(config, "buff_layouts"), grids.size());
+        benchmark::DoNotOptimize(layouts.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * i64(text.size()));
+}
+BENCHMARK(BM_LoadConfig)->Apply(ConfigItemCounts)->Unit(benchmark::kMicrosecond);
+
+// The grids alone, through the document
+static void BM_LoadGridsDocument(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    const std::string text = MakeConfigDocument(size_t(state.range(0)), 11);
+    StyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(16, 4, 11));
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        const auto config = nlohmann::json::parse(text);
+        auto grids = LoadGrids(ConfigSection(config, "buff_grids"), catalog.buffs, styles);
+        benchmark::DoNotOptimize(grids.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * i64(text.size()));
+}
+BENCHMARK(BM_LoadGridsDocument)->Apply(ConfigItemCounts)->Unit(benchmark::kMicrosecond);
+
+// The grids alone, streamed out of the same document
+static void BM_StreamGrids(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    const std::string text = MakeConfigDocument(size_t(state.range(0)), 11);
+    StyleTable styles;
+    styles.LoadStyles(MakeStylesConfig(16, 4, 11));
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        std::istringstream in(text);
+        auto grids = StreamGrids(in, catalog.buffs, styles);
+        benchmark::DoNotOptimize(grids);
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    state.SetBytesProcessed(state.iterations() * i64(text.size()));
+}
+BENCHMARK(BM_StreamGrids)->Apply(ConfigItemCounts)->Unit(benchmark::kMicrosecond);
+
+// A configuration file and its snapshot, written to the temporary directory
+struct ConfigFiles
+{
+    explicit ConfigFiles(size_t itemCount) {
+        path = std::filesystem::temp_directory_path() / ("gw2clarity_bench_" + std::to_string(itemCount) + ".json");
+        const std::string text = MakeConfigDocument(itemCount, 12);
+        std::ofstream(path, std::ios::binary) << text;
+        WriteConfigSnapshot(ConfigSnapshotPath(path), HashConfigText(text), nlohmann::json::parse(text));
+    }
+    ~ConfigFiles() {
+        std::filesystem::remove(path);
+        std::filesystem::remove(ConfigSnapshotPath(path));
+    }
+
+    std::filesystem::path path;
+};
+
+// Startup without a usable snapshot: reading and parsing the file, then loading every section out of it. Files are in the OS cache
+// after the first iteration, as they mostly are when the game starts.
+static void BM_StartupJson(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    const ConfigFiles files(size_t(state.range(0)));
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        std::ifstream in(files.path, std::ios::binary);
+        const auto config = nlohmann::json::parse(in);
+        const ConfigSource source(config, nullptr);
+        StyleTable styles;
+        source.LoadStyles(styles);
+        auto grids = source.LoadGrids(catalog.buffs, styles);
+        auto layouts = source.LoadLayouts(grids.size());
+        benchmark::DoNotOptimize(layouts.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StartupJson)->Apply(ConfigItemCounts)->Unit(benchmark::kMicrosecond);
+
+// Startup with an up to date snapshot: hashing the file, then mapping the snapshot and loading every section out of it
+static void BM_StartupSnapshot(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    const ConfigFiles files(size_t(state.range(0)));
+    const nlohmann::json empty;
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        const auto snapshot = ConfigSnapshot::Open(ConfigSnapshotPath(files.path), HashConfigFile(files.path).value_or(0));
+        if(!snapshot) {
+            state.SkipWithError("Snapshot is missing or stale");
+            return;
+        }
+        const ConfigSource source(empty, &*snapshot);
+        StyleTable styles;
+        source.LoadStyles(styles);
+        auto grids = source.LoadGrids(catalog.buffs, styles);
+        auto layouts = source.LoadLayouts(grids.size());
+        benchmark::DoNotOptimize(layouts.data());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_StartupSnapshot)->Apply(ConfigItemCounts)->Unit(benchmark::kMicrosecond);
+
+// The compiled catalog written to a temporary catalog file
+struct CatalogFile
+{
+    CatalogFile() : path(std::filesystem::temp_directory_path() / "gw2clarity_bench.catalog") {
+        WriteBuffCatalogFile(path, Catalog::Get().buffs);
+    }
+    ~CatalogFile() { std::filesystem::remove(path); }
+
+    std::filesystem::path path;
+};
+
+// Mapping, validating and materializing a catalog file, as Buffs does at startup when one is shipped
+static void BM_OpenCatalogFile(benchmark::State& state) {
+    const CatalogFile file;
+
+    AllocationCounter allocs(state);
+    for(auto _ : state) {
+        auto opened = BuffCatalogFile::Open(file.path);
+        if(!opened) {
+            state.SkipWithError("Catalog file is missing or damaged");
+            return;
+        }
+        benchmark::DoNotOptimize(opened->catalog().buffs().data());
+    }
+}
+BENCHMARK(BM_OpenCatalogFile)->Unit(benchmark::kMicrosecond);
+
+// Resolving the buff of every item, as loading grids does, through the ID table of the compiled catalog (0) or of a catalog file (1)
+static void BM_CatalogFind(benchmark::State& state) {
+    const auto& catalog = Catalog::Get();
+    const CatalogFile file;
+    const auto opened = BuffCatalogFile::Open(file.path);
+    if(!opened) {
+        state.SkipWithError("Catalog file is missing or damaged");
+        return;
+    }
+    const BuffCatalog& source = state.range(0) == 0 ? catalog.buffs : opened->catalog();
+
+    AllocationCounter allocs(state);
+    for(auto _ : state)
+        for(const Buff* b : catalog.real)
+            benchmark::DoNotOptimize(source.find(b->id));
+    state.SetItemsProcessed(state.iterations() * i64(catalog.real.size()));
+}
+BENCHMARK(BM_CatalogFind)->Arg(0)->Arg(1);
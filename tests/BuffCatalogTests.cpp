@@ -0,0 +1,144 @@
+#include <gtest/gtest.h>
+
+#include <cstring>
+#include <fstream>
+
+#include "BuffCatalogFile.h"
+
+using namespace GW2Clarity;
+namespace cat = BuffCatalogFormat;
+
+namespace
+{
+std::filesystem::path TemporaryCatalogPath(const char* name) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    return path;
+}
+
+std::vector<char> ReadBytes(const std::filesystem::path& path) {
+    std::ifstream in(path, std::ios::binary);
+    return { std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>() };
+}
+
+void WriteBytes(const std::filesystem::path& path, std::span<const char> bytes) {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(bytes.data(), std::streamsize(bytes.size()));
+}
+
+// A valid catalog file written from the compiled catalog, which each test damages in its own way
+class BuffCatalogFileTest : public testing::Test
+{
+protected:
+    void SetUp() override {
+        ASSERT_TRUE(WriteBuffCatalogFile(path_, CompiledBuffCatalog()));
+        bytes_ = ReadBytes(path_);
+        ASSERT_GE(bytes_.size(), sizeof(cat::Header));
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path_);
+        std::filesystem::remove(damagedPath_);
+    }
+
+    [[nodiscard]] cat::Header header() const {
+        cat::Header h;
+        std::memcpy(&h, bytes_.data(), sizeof(h));
+        return h;
+    }
+
+    void SetHeader(const cat::Header& h) { std::memcpy(bytes_.data(), &h, sizeof(h)); }
+
+    template<typename T>
+    void Patch(size_t offset, const T& value) {
+        ASSERT_LE(offset + sizeof(T), bytes_.size());
+        std::memcpy(bytes_.data() + offset, &value, sizeof(T));
+    }
+
+    [[nodiscard]] bool OpensDamaged() const {
+        WriteBytes(damagedPath_, bytes_);
+        return BuffCatalogFile::Open(damagedPath_).has_value();
+    }
+
+    const std::filesystem::path path_ = TemporaryCatalogPath("gw2clarity_tests.catalog");
+    const std::filesystem::path damagedPath_ = TemporaryCatalogPath("gw2clarity_tests_damaged.catalog");
+    std::vector<char> bytes_;
+};
+} // namespace
+
+TEST_F(BuffCatalogFileTest, RoundTripsCompiledCatalog) {
+    const auto file = BuffCatalogFile::Open(path_);
+    ASSERT_TRUE(file.has_value());
+    EXPECT_TRUE(SameBuffCatalog(CompiledBuffCatalog(), file->catalog()));
+    // The copy written back is accepted as is
+    EXPECT_TRUE(OpensDamaged());
+}
+
+TEST_F(BuffCatalogFileTest, RejectsMissingAndEmptyFiles) {
+    EXPECT_FALSE(BuffCatalogFile::Open(TemporaryCatalogPath("gw2clarity_tests_missing.catalog")).has_value());
+
+    bytes_.clear();
+    EXPECT_FALSE(OpensDamaged());
+}
+
+TEST_F(BuffCatalogFileTest, RejectsTruncatedFiles) {
+    const size_t size = bytes_.size();
+    for(size_t truncated : { size - 1, size / 2, sizeof(cat::Header), sizeof(cat::Header) - 1 }) {
+        bytes_.resize(truncated);
+        EXPECT_FALSE(OpensDamaged()) << "truncated to " << truncated << " of " << size << " bytes";
+    }
+}
+
+TEST_F(BuffCatalogFileTest, RejectsOtherFormatsAndVersions) {
+    auto h = header();
+    h.magic[0] = 'X';
+    SetHeader(h);
+    EXPECT_FALSE(OpensDamaged());
+
+    h = header();
+    h.magic = cat::Magic;
+    h.version = cat::Version + 1;
+    SetHeader(h);
+    EXPECT_FALSE(OpensDamaged());
+}
+
+TEST_F(BuffCatalogFileTest, RejectsRangesOutsideFile) {
+    auto h = header();
+    h.buffs.count += 1 + u32(bytes_.size() / sizeof(cat::Buff));
+    SetHeader(h);
+    EXPECT_FALSE(OpensDamaged());
+
+    h = header();
+    h.strings.offset = u32(bytes_.size());
+    SetHeader(h);
+    EXPECT_FALSE(OpensDamaged());
+}
+
+TEST_F(BuffCatalogFileTest, RejectsCorruptedRecords) {
+    const auto h = header();
+    ASSERT_GT(h.buffs.count, 0u);
+    ASSERT_GT(h.byId.count, 0u);
+    const auto original = bytes_;
+
+    // A name running past the string pool
+    Patch(h.buffs.offset + offsetof(cat::Buff, name) + offsetof(cat::String, offset), h.strings.count);
+    EXPECT_FALSE(OpensDamaged());
+
+    // More extra IDs than a buff can hold
+    bytes_ = original;
+    Patch(h.buffs.offset + offsetof(cat::Buff, extraIdCount), u32(BuffExtraIds::Capacity + 1));
+    EXPECT_FALSE(OpensDamaged());
+
+    // An ID lookup pointing past the buffs
+    bytes_ = original;
+    Patch(h.byId.offset + offsetof(BuffIdIndex, index), h.buffs.count);
+    EXPECT_FALSE(OpensDamaged());
+
+    // Slot tables whose size isn't a power of two
+    bytes_ = original;
+    ASSERT_GE(h.slotDisplacements.count, 4u);
+    auto damaged = h;
+    damaged.slotDisplacements.count = h.slotDisplacements.count / 4 * 3;
+    SetHeader(damaged);
+    EXPECT_FALSE(OpensDamaged());
+}
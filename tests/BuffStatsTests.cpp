@@ -0,0 +1,143 @@
+#include <gtest/gtest.h>
+
+#include "BuffStats.h"
+
+using namespace GW2Clarity;
+
+namespace
+{
+constexpr mstime Seconds(u64 s) { return s * 1000; }
+
+void SetStacks(BuffStats& stats, mstime now, u32 slot, i32 previous, i32 current) {
+    const BuffCountChange change { 0, slot, previous, current };
+    stats.Update(now, std::span(&change, 1));
+}
+
+// Stats of the slot in the snapshot, or nothing if it wasn't active during the window
+std::optional<BuffSlotStats> SlotStats(BuffStats& stats, mstime now, BuffStatsWindow window, u32 slot) {
+    BuffStatsSnapshot snapshot;
+    stats.Snapshot(now, window, snapshot);
+    for(const auto& s : snapshot.slots)
+        if(s.slot == slot)
+            return s;
+    return std::nullopt;
+}
+} // namespace
+
+TEST(BuffStats, UptimeAndAverageStacks) {
+    BuffStats stats(4, 0);
+    SetStacks(stats, 0, 1, 0, 2);
+    SetStacks(stats, Seconds(30), 1, 2, 4);
+    SetStacks(stats, Seconds(40), 1, 4, 0);
+
+    BuffStatsSnapshot snapshot;
+    stats.Snapshot(Seconds(60), BuffStatsWindow::Session, snapshot);
+    EXPECT_EQ(snapshot.duration, Seconds(60));
+    // Slots which were never active are left out
+    ASSERT_EQ(snapshot.slots.size(), 1u);
+
+    const auto& s = snapshot.slots[0];
+    EXPECT_EQ(s.slot, 1u);
+    EXPECT_FLOAT_EQ(s.uptime, 40.f / 60.f);
+    EXPECT_FLOAT_EQ(s.averageStacks, (2.f * 30.f + 4.f * 10.f) / 40.f);
+    EXPECT_DOUBLE_EQ(s.stackSeconds, 100.0);
+    // The buff has been missing since 40 s
+    EXPECT_FLOAT_EQ(s.longestGapSeconds, 20.f);
+}
+
+TEST(BuffStats, GapOpenWhenFightEnds) {
+    BuffStats stats(2, 0);
+    stats.UpdateCombat(0, true);
+    SetStacks(stats, 0, 0, 0, 1);
+    SetStacks(stats, Seconds(60), 0, 1, 0);
+    stats.UpdateCombat(Seconds(600), false);
+    EXPECT_FALSE(stats.inFight());
+
+    // Read well after the fight, time since it ended doesn't count
+    const auto s = SlotStats(stats, Seconds(700), BuffStatsWindow::Fight, 0);
+    ASSERT_TRUE(s);
+    EXPECT_FLOAT_EQ(s->uptime, 0.1f);
+    EXPECT_FLOAT_EQ(s->longestGapSeconds, 540.f);
+}
+
+TEST(BuffStats, GapOpenBeforeFightStarts) {
+    BuffStats stats(2, 0);
+    SetStacks(stats, 0, 0, 0, 1);
+    SetStacks(stats, Seconds(10), 0, 1, 0);
+    stats.UpdateCombat(Seconds(100), true);
+    SetStacks(stats, Seconds(130), 0, 0, 1);
+    stats.UpdateCombat(Seconds(200), false);
+
+    // Only the part of the gap within the fight counts
+    const auto s = SlotStats(stats, Seconds(200), BuffStatsWindow::Fight, 0);
+    ASSERT_TRUE(s);
+    EXPECT_FLOAT_EQ(s->longestGapSeconds, 30.f);
+}
+
+TEST(BuffStats, RecentWindowRollsOver) {
+    BuffStats stats(2, 0);
+    // Slot 1 is only active long before the window
+    SetStacks(stats, 0, 1, 0, 1);
+    SetStacks(stats, Seconds(5), 1, 1, 0);
+    SetStacks(stats, Seconds(500), 0, 0, 1);
+
+    BuffStatsSnapshot snapshot;
+    stats.Snapshot(Seconds(600), BuffStatsWindow::Recent, snapshot);
+    // The window ends with the bucket being filled, which starts at 600 s
+    EXPECT_EQ(snapshot.duration, BuffStats::RecentDuration - BuffStats::BucketDuration);
+    ASSERT_EQ(snapshot.slots.size(), 1u);
+    EXPECT_EQ(snapshot.slots[0].slot, 0u);
+    EXPECT_FLOAT_EQ(snapshot.slots[0].uptime, 100.f / 290.f);
+}
+
+TEST(BuffStats, RecentWindowClipsGapsToItsStart) {
+    BuffStats stats(2, 0);
+    SetStacks(stats, 0, 0, 0, 1);
+    SetStacks(stats, Seconds(1), 0, 1, 0);
+    SetStacks(stats, Seconds(540), 0, 0, 1);
+
+    // The window starts at 310 s, the gap lasted 539 s of which 230 s fall within it
+    const auto s = SlotStats(stats, Seconds(600), BuffStatsWindow::Recent, 0);
+    ASSERT_TRUE(s);
+    EXPECT_FLOAT_EQ(s->longestGapSeconds, 230.f);
+    EXPECT_FLOAT_EQ(s->uptime, 60.f / 290.f);
+}
+
+TEST(BuffStats, RecentWindowClipsGapsInFirstBucket) {
+    BuffStats stats(2, 0);
+    // Both gaps end in the first bucket of the window, from 310 s to 320 s. The longer one mostly falls before the window.
+    SetStacks(stats, 0, 0, 0, 1);
+    SetStacks(stats, Seconds(1), 0, 1, 0);
+    SetStacks(stats, Seconds(311), 0, 0, 1);
+    SetStacks(stats, Seconds(312), 0, 1, 0);
+    SetStacks(stats, Seconds(319), 0, 0, 1);
+
+    const auto s = SlotStats(stats, Seconds(600), BuffStatsWindow::Recent, 0);
+    ASSERT_TRUE(s);
+    EXPECT_FLOAT_EQ(s->longestGapSeconds, 7.f);
+}
+
+TEST(BuffStats, ResetKeepsOnlyCurrentStacks) {
+    BuffStats stats(2, 0);
+    stats.UpdateCombat(0, true);
+    SetStacks(stats, 0, 0, 0, 3);
+    SetStacks(stats, Seconds(10), 0, 3, 0);
+    SetStacks(stats, Seconds(50), 0, 0, 3);
+    stats.UpdateCombat(Seconds(60), false);
+
+    stats.Reset(Seconds(100));
+
+    BuffStatsSnapshot snapshot;
+    stats.Snapshot(Seconds(110), BuffStatsWindow::Fight, snapshot);
+    EXPECT_EQ(snapshot.duration, 0u);
+    EXPECT_TRUE(snapshot.slots.empty());
+
+    for(auto window : { BuffStatsWindow::Recent, BuffStatsWindow::Session }) {
+        stats.Snapshot(Seconds(110), window, snapshot);
+        EXPECT_EQ(snapshot.duration, Seconds(10));
+        ASSERT_EQ(snapshot.slots.size(), 1u);
+        EXPECT_FLOAT_EQ(snapshot.slots[0].uptime, 1.f);
+        EXPECT_FLOAT_EQ(snapshot.slots[0].averageStacks, 3.f);
+        EXPECT_FLOAT_EQ(snapshot.slots[0].longestGapSeconds, 0.f);
+    }
+}
@@ -0,0 +1,92 @@
+#include <gtest/gtest.h>
+
+#include <fstream>
+
+#include "ConfigPersistence.h"
+#include "ConfigSnapshot.h"
+
+using namespace GW2Clarity;
+
+namespace
+{
+const std::array<std::string, 2> Sections { "buff_grids", "styles" };
+
+// A configuration file with both sections and an option, loaded into document
+class ConfigPersistenceTest : public testing::Test
+{
+protected:
+    void SetUp() override {
+        std::filesystem::remove(path_);
+        WriteFile(R"({ "Core": { "first_message_shown_v1": false }, "buff_grids": [ 1 ], "styles": [ "a" ] })");
+        document_ = ReadFile();
+        ASSERT_TRUE(document_.is_object());
+    }
+
+    void TearDown() override {
+        std::filesystem::remove(path_);
+        std::filesystem::remove(ConfigSnapshotPath(path_));
+    }
+
+    void WriteFile(const char* text) const {
+        std::ofstream out(path_);
+        out << text;
+    }
+
+    [[nodiscard]] nlohmann::json ReadFile() const {
+        std::ifstream in(path_);
+        return nlohmann::json::parse(in, nullptr, false);
+    }
+
+    const std::filesystem::path path_ = std::filesystem::temp_directory_path() / "gw2clarity_persistence.json";
+    nlohmann::json document_;
+};
+} // namespace
+
+TEST_F(ConfigPersistenceTest, SerializesSubmissionsInBackground) {
+    std::thread::id serializerThread;
+    {
+        ConfigPersistence persistence(path_, document_, Sections, std::chrono::milliseconds(0));
+        persistence.Submit("buff_grids", [&] {
+            serializerThread = std::this_thread::get_id();
+            return nlohmann::json::array({ 1, 2, 3 });
+        });
+        persistence.Flush();
+        EXPECT_EQ(persistence.writeCount(), 1u);
+    }
+    EXPECT_NE(serializerThread, std::thread::id());
+    EXPECT_NE(serializerThread, std::this_thread::get_id());
+
+    const auto written = ReadFile();
+    EXPECT_EQ(written["buff_grids"], nlohmann::json::array({ 1, 2, 3 }));
+    // Sections which weren't submitted are written as loaded
+    EXPECT_EQ(written["styles"], nlohmann::json::array({ "a" }));
+    EXPECT_FALSE(written["Core"]["first_message_shown_v1"].get<bool>());
+}
+
+TEST_F(ConfigPersistenceTest, SetKeepsSubmittedSections) {
+    {
+        ConfigPersistence persistence(path_, document_, Sections, std::chrono::milliseconds(0));
+        persistence.Submit("styles", [] { return nlohmann::json::array({ "b" }); });
+        persistence.Set("Core", "first_message_shown_v1", true);
+        persistence.Flush();
+    }
+    EXPECT_TRUE(document_["Core"]["first_message_shown_v1"].get<bool>());
+
+    // The document still holds the styles it was loaded with, which must not be written over the submitted ones
+    const auto written = ReadFile();
+    EXPECT_EQ(written["styles"], nlohmann::json::array({ "b" }));
+    EXPECT_TRUE(written["Core"]["first_message_shown_v1"].get<bool>());
+}
+
+TEST_F(ConfigPersistenceTest, WritesDocumentRatherThanFile) {
+    ConfigPersistence persistence(path_, document_, Sections, std::chrono::milliseconds(0));
+    // Nothing else writes the file, what is on disk is never merged back
+    WriteFile(R"({ "external": true })");
+    persistence.Set("Grids", "gpu_evaluation", true);
+    persistence.Flush();
+
+    const auto written = ReadFile();
+    EXPECT_FALSE(written.contains("external"));
+    EXPECT_TRUE(written["Grids"]["gpu_evaluation"].get<bool>());
+    EXPECT_EQ(written["buff_grids"], nlohmann::json::array({ 1 }));
+}
@@ -0,0 +1,63 @@
+#include <gtest/gtest.h>
+
+#include "GridAnimation.h"
+
+using namespace GW2Clarity;
+
+namespace
+{
+constexpr mstime PeriodMs = mstime(AnimationTimePeriod) * 1000;
+}
+
+TEST(GridAnimation, TimeWrapsEveryPeriod) {
+    EXPECT_EQ(AnimationTimePeriod, 3600u);
+    EXPECT_FLOAT_EQ(WrapAnimationTime(0), 0.f);
+    EXPECT_FLOAT_EQ(WrapAnimationTime(1'500), 1.5f);
+    EXPECT_FLOAT_EQ(WrapAnimationTime(PeriodMs - 1), 3599.999f);
+    EXPECT_FLOAT_EQ(WrapAnimationTime(PeriodMs), 0.f);
+    EXPECT_FLOAT_EQ(WrapAnimationTime(PeriodMs + 250), 0.25f);
+    // Days of uptime still land in the first period
+    EXPECT_FLOAT_EQ(WrapAnimationTime(PeriodMs * 48 + 7'000), 7.f);
+}
+
+TEST(GridAnimation, QuantizedFrequenciesCompleteWholeCyclesPerPeriod) {
+    for(f32 hz : { 0.f, 0.1f, 0.37f, 1.f, 1.234f, 2.5f, 4.999f, 5.f }) {
+        const f32 q = QuantizeAnimationFrequency(hz);
+        const f64 cycles = f64(q) * AnimationTimePeriod;
+        EXPECT_NEAR(cycles, std::round(cycles), 1e-3) << hz;
+        EXPECT_NEAR(q, hz, 0.5f / AnimationTimePeriod) << hz;
+    }
+}
+
+TEST(GridAnimation, PulseIsContinuousAcrossWrap) {
+    for(f32 hz : { 0.37f, 1.f, 2.5f, 5.f }) {
+        const f32 q = QuantizeAnimationFrequency(hz);
+        for(f32 phase : { 0.f, 1.f, 3.f }) {
+            // Just before the wrap and just after it, 20 ms apart, while a 5 Hz pulse moves by at most 5 pi per second
+            const f32 before = PulseWave(q, phase, WrapAnimationTime(PeriodMs - 10));
+            const f32 after = PulseWave(q, phase, WrapAnimationTime(PeriodMs + 10));
+            EXPECT_NEAR(before, after, 0.02 * 5.0 * std::numbers::pi) << hz;
+
+            // Past the wrap, the pulse is where it would be had time not wrapped
+            for(mstime ms : { PeriodMs, PeriodMs + 10, PeriodMs * 3 + 1'234 }) {
+                const f64 unwrapped = std::sin(2.0 * std::numbers::pi * f64(q) * f64(ms) / 1000.0 + phase) * 0.5 + 0.5;
+                EXPECT_NEAR(PulseWave(q, phase, WrapAnimationTime(ms)), unwrapped, 1e-3) << hz << " " << ms;
+            }
+        }
+    }
+}
+
+TEST(GridAnimation, PulseRanges) {
+    EXPECT_FLOAT_EQ(PulseWave(1.f, 0.f, 0.f), 0.5f);
+    EXPECT_FLOAT_EQ(BorderPulseWeight(0.f, 123.f), 0.f);
+
+    for(f32 t = 0.f; t < 2.f; t += 0.01f) {
+        const f32 w = PulseWave(1.f, 0.5f, t);
+        EXPECT_GE(w, 0.f);
+        EXPECT_LE(w, 1.f);
+
+        const f32 glow = GlowPulseScale(0.25f, 1.f, 0.f, t);
+        EXPECT_GE(glow, 0.75f - 1e-6f);
+        EXPECT_LE(glow, 1.f + 1e-6f);
+    }
+}
@@ -0,0 +1,69 @@
+#include <gtest/gtest.h>
+
+#include "GridBufferPolicy.h"
+
+using namespace GW2Clarity;
+
+namespace
+{
+constexpr size_t Max = GridBufferPolicy::MaxCapacity;
+}
+
+TEST(GridBufferPolicy, KeepsCapacityWhenLargeEnough) {
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(1024, 0), 1024u);
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(1024, 1000), 1024u);
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(1024, 1024), 1024u);
+}
+
+TEST(GridBufferPolicy, GrowsGeometricallyUpToMaxCapacity) {
+    // At least doubling, and at least the next power of two of what is required
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(1024, 1025), 2048u);
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(1024, 5000), 8192u);
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(1, 2), 2u);
+
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(Max / 2, Max / 2 + 1), Max);
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(Max / 2, Max * 4), Max);
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(1024, Max * 4), Max);
+    // Never beyond, however many instances are required
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(Max, Max + 1), Max);
+    EXPECT_EQ(GridBufferPolicy::GrowCapacity(Max, Max * 10), Max);
+
+    size_t capacity = 1;
+    for(size_t required = 1; required <= Max * 2; required += 777) {
+        const size_t grown = GridBufferPolicy::GrowCapacity(capacity, required);
+        EXPECT_GE(grown, capacity);
+        EXPECT_LE(grown, Max);
+        EXPECT_GE(grown, std::min(required, Max));
+        capacity = grown;
+    }
+}
+
+TEST(GridBufferPolicy, SingleBatchWithinCapacity) {
+    EXPECT_EQ(GridBufferPolicy::BatchCount(0, Max), 0u);
+    EXPECT_EQ(GridBufferPolicy::BatchCount(1, Max), 1u);
+    EXPECT_EQ(GridBufferPolicy::BatchCount(Max, Max), 1u);
+
+    const auto [first, count] = GridBufferPolicy::BatchRange(0, 1000, 1024);
+    EXPECT_EQ(first, 0u);
+    EXPECT_EQ(count, 1000u);
+}
+
+TEST(GridBufferPolicy, SplitsBatchesAboveMaxCapacity) {
+    for(size_t total : { Max + 1, Max * 2, Max * 2 + 17, Max * 5 - 1 }) {
+        const u32 batches = GridBufferPolicy::BatchCount(total, Max);
+        EXPECT_EQ(batches, (total + Max - 1) / Max);
+
+        // Batches are full but for the last one, and cover every instance once
+        size_t next = 0;
+        for(u32 b = 0; b < batches; b++) {
+            const auto [first, count] = GridBufferPolicy::BatchRange(b, total, Max);
+            EXPECT_EQ(first, next);
+            EXPECT_GT(count, 0u);
+            if(b + 1 < batches) {
+                EXPECT_EQ(count, Max);
+            }
+            next = first + count;
+        }
+        EXPECT_EQ(next, total);
+    }
+}
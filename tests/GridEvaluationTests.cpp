@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "GridConfig.h"
+#include "GridEvaluation.h"
+
+using namespace GW2Clarity;
+
+namespace
+{
+using Style = StyleTable::Style;
+using T = StyleTable::ThresholdBuilder;
+
+const vec2 Screen { 1920.f, 1080.f };
+const vec2 Origin { 300.5f, 200.25f };
+// Below zero, both thresholds edges, the highest threshold count, and numbers too large to display
+constexpr std::array<i32, 14> Counts { -1, 0, 1, 2, 3, 99, 100, 101, 250, 1499, 1500, 1501, 65535, 70000 };
+
+// Styles with thresholds at single counts, overlapping, from 100 on and up to the highest count, with borders thinner and thicker than
+// the minimum an edited item gets
+std::vector<Style> UserStyles() {
+    std::vector<Style> styles;
+
+    auto& edges = styles.emplace_back("Edges");
+    edges.thresholds = {
+        T().min(1).max(1).border(1.f, 0.f, 0.f, 1.f).borderThickness(0.5f),
+        T().min(2).max(99).glow(0.f, 1.f, 0.f, 1.f).glowSize(0.3f).glowPulse({ 0.5f, 2.f }),
+        T().min(100).max(100).tint(0.5f, 0.75f),
+        T().min(101).max(1500).border(0.f, 0.f, 1.f, 1.f).borderThickness(3.f),
+    };
+
+    auto& overlapping = styles.emplace_back("Overlapping");
+    overlapping.thresholds = {
+        T().min(0).max(0).tint(0.25f, 1.f),
+        T().min(1).max(5).border(1.f, 1.f).borderThickness(2.f),
+        T().min(3).max(150).glow(1.f, 0.5f, 0.f, 1.f).glowSize(0.2f),
+        T().min(1500).max(1500).tint(1.f, 0.f, 0.f, 1.f),
+    };
+
+    auto& high = styles.emplace_back("High");
+    high.thresholds = { T().min(100).max(1500).tint(0.f, 1.f, 1.f, 0.5f).glowPulse({ 1.f, 0.25f }) };
+
+    return styles;
+}
+
+struct Fixture
+{
+    StyleTable styles;
+    std::vector<Grid> grids;
+    std::vector<u32> stackSources;
+    std::vector<PackedGridAppearanceInterval> appearances;
+    std::vector<i32> counts;
+
+    Fixture() {
+        styles.LoadStyles(UserStyles());
+        styles.BuildAppearanceTable(appearances);
+
+        const auto& catalog = CompiledBuffCatalog();
+        const Buff *stacking = nullptr, *single = nullptr, *additional = nullptr;
+        for(const auto& b : catalog.buffs()) {
+            if(b.isCategory() || b.slot == BuffSlotMap::InvalidSlot)
+                continue;
+            if(b.maxStacks > 1 && !stacking)
+                stacking = &b;
+            else if(b.maxStacks > 1 && !additional)
+                additional = &b;
+            else if(b.maxStacks == 1 && !single)
+                single = &b;
+        }
+        EXPECT_TRUE(stacking && single && additional);
+
+        // One grid per style, built-in ones included, each with a stacking buff, a single buff and a buff with an additional one
+        for(u32 s = 0; s < styles.styles().size(); s++) {
+            Grid& g = grids.emplace_back();
+            g.spacing = { 40, 36 };
+            auto addItem = [&](ivec2 pos, const Buff* buff) -> GridItem& {
+                GridItem& i = g.items.emplace_back();
+                i.pos = pos;
+                i.buff = buff;
+                i.style = s;
+                return i;
+            };
+            addItem({ 0, 0 }, stacking);
+            addItem({ 1, 0 }, single);
+            addItem({ 2, 1 }, stacking).additionalBuffs.push_back(additional);
+        }
+        CompileStackSources(grids, catalog.slots(), stackSources);
+        counts.assign(catalog.slots().size(), 0);
+    }
+
+    // Splits count between the item's first and last stack sources
+    void SetCount(const GridItem& item, i32 count) {
+        std::ranges::fill(counts, 0);
+        const auto sources = std::span { stackSources }.subspan(item.firstStackSource, item.stackSourceCount);
+        const i32 first = sources.size() > 1 ? count / 2 : count;
+        counts[sources.front()] += first;
+        counts[sources.back()] += count - first;
+    }
+};
+} // namespace
+
+TEST(GridEvaluation, MatchesCpuPathForLiveCounts) {
+    Fixture f;
+    for(u32 gid = 0; gid < f.grids.size(); gid++) {
+        const Grid& g = f.grids[gid];
+        for(i16 iid = 0; iid < i16(g.items.size()); iid++) {
+            const auto item = BuildGridItemData(g, iid, gid, f.styles, false, 0);
+            for(i32 count : Counts) {
+                f.SetCount(g.items[iid], count);
+                ASSERT_EQ(CountStacks(f.counts, f.stackSources, g.items[iid]), count);
+
+                const auto expected = BuildGridInstance(g, iid, Origin, Screen, f.styles, f.counts, f.stackSources, -1, 0);
+                const auto evaluated = EvaluateGridItem(item, Origin, Screen, f.counts, f.stackSources, f.appearances);
+                EXPECT_EQ(evaluated, expected) << "style '" << f.styles.style(g.items[iid].style).name << "', item " << iid << ", count "
+                                               << count;
+            }
+        }
+    }
+}
+
+TEST(GridEvaluation, MatchesCpuPathWhileEditing) {
+    Fixture f;
+    for(u32 gid = 0; gid < f.grids.size(); gid++) {
+        const Grid& g = f.grids[gid];
+        for(i16 iid = 0; iid < i16(g.items.size()); iid++) {
+            // The edited item ignores its live count
+            f.SetCount(g.items[iid], 7);
+            for(i32 count : Counts) {
+                const auto item = BuildGridItemData(g, iid, gid, f.styles, true, count);
+                const auto expected = BuildGridInstance(g, iid, Origin, Screen, f.styles, f.counts, f.stackSources, iid, count);
+                const auto evaluated = EvaluateGridItem(item, Origin, Screen, f.counts, f.stackSources, f.appearances);
+                EXPECT_EQ(evaluated, expected) << "style '" << f.styles.style(g.items[iid].style).name << "', item " << iid << ", count "
+                                               << count;
+                EXPECT_TRUE(evaluated.pulse & PackedGridInstanceData::HighlightBit);
+            }
+        }
+    }
+}
@@ -0,0 +1,120 @@
+#include <gtest/gtest.h>
+
+#include <random>
+
+#include "GridInstance.h"
+
+using namespace GW2Clarity;
+
+namespace
+{
+using P = PackedGridInstanceData;
+
+// Half a quantization step over the given range, plus a few ulps of float rounding
+f32 HalfStep(const vec2& range, u32 bits) {
+    const f32 magnitude = std::max({ 1.f, std::abs(range.x), std::abs(range.y) });
+    return (range.y - range.x) / f32((1u << bits) - 1) * 0.5f + 4.f * std::numeric_limits<f32>::epsilon() * magnitude;
+}
+
+constexpr f32 TwoPi = 2.f * std::numbers::pi_v<f32>;
+
+// Distance between two angles, going around the circle
+f32 AngleDistance(f32 a, f32 b) {
+    const f32 d = std::fmod(std::abs(a - b), TwoPi);
+    return std::min(d, TwoPi - d);
+}
+
+void ExpectRoundTrip(const GridInstanceData& in) {
+    const GridInstanceData out = Unpack(Pack(in));
+
+    const f32 posError = HalfStep(P::PositionRange, 16), dimsError = HalfStep(P::DimensionsRange, 16);
+    EXPECT_NEAR(out.posDims.x, in.posDims.x, posError);
+    EXPECT_NEAR(out.posDims.y, in.posDims.y, posError);
+    EXPECT_NEAR(out.posDims.z, in.posDims.z, dimsError);
+    EXPECT_NEAR(out.posDims.w, in.posDims.w, dimsError);
+
+    EXPECT_EQ(out.atlasSlot, in.atlasSlot);
+    EXPECT_EQ(out.number, in.number);
+
+    const f32 colorError = HalfStep({ 0.f, 1.f }, 8);
+    for(i32 c = 0; c < 4; c++) {
+        EXPECT_NEAR(out.tint[c], in.tint[c], colorError);
+        EXPECT_NEAR(out.borderColor[c], in.borderColor[c], colorError);
+        EXPECT_NEAR(out.glowColor[c], in.glowColor[c], colorError);
+    }
+
+    EXPECT_NEAR(out.glowSize, in.glowSize, HalfStep(P::GlowSizeRange, 16));
+    EXPECT_NEAR(out.borderThickness, in.borderThickness, HalfStep(P::BorderThicknessRange, 16));
+
+    EXPECT_NEAR(out.glowPulse.x, in.glowPulse.x, colorError);
+    // Frequencies are quantized to whole cycles per animation period
+    EXPECT_NEAR(out.glowPulse.y, in.glowPulse.y, 0.5f / f32(AnimationTimePeriod) + 1e-6f);
+    EXPECT_FLOAT_EQ(out.glowPulse.y, QuantizeAnimationFrequency(in.glowPulse.y));
+    EXPECT_LE(AngleDistance(out.glowPulse.z, in.glowPulse.z), TwoPi / 255.f * 0.5f + 1e-5f);
+
+    EXPECT_EQ(out.highlight, in.highlight);
+}
+} // namespace
+
+TEST(GridInstance, RoundTripAtRangeEnds) {
+    for(bool high : { false, true }) {
+        GridInstanceData in;
+        const f32 t = high ? 1.f : 0.f;
+        in.posDims = high ? vec4(P::PositionRange.y, P::PositionRange.y, P::DimensionsRange.y, P::DimensionsRange.y)
+                          : vec4(P::PositionRange.x, P::PositionRange.x, P::DimensionsRange.x, P::DimensionsRange.x);
+        in.atlasSlot = high ? 0xFFFF : 0;
+        in.number = high ? 0xFFFF : 0;
+        in.tint = in.borderColor = in.glowColor = vec4(t);
+        in.glowSize = high ? P::GlowSizeRange.y : P::GlowSizeRange.x;
+        in.borderThickness = high ? P::BorderThicknessRange.y : P::BorderThicknessRange.x;
+        in.glowPulse = { t, high ? 5.f : 0.f, high ? TwoPi - 1e-4f : 0.f };
+        in.highlight = high;
+
+        ExpectRoundTrip(in);
+
+        // Range ends are exactly representable
+        const GridInstanceData out = Unpack(Pack(in));
+        EXPECT_EQ(out.posDims, in.posDims);
+        EXPECT_EQ(out.glowSize, in.glowSize);
+        EXPECT_EQ(out.borderThickness, in.borderThickness);
+    }
+}
+
+TEST(GridInstance, RoundTripWithinBounds) {
+    std::mt19937 rng(7);
+    auto uniform = [&](f32 a, f32 b) { return std::uniform_real_distribution<f32>(a, b)(rng); };
+    auto color = [&] { return vec4(uniform(0.f, 1.f), uniform(0.f, 1.f), uniform(0.f, 1.f), uniform(0.f, 1.f)); };
+
+    for(i32 i = 0; i < 10'000; i++) {
+        GridInstanceData in;
+        in.posDims = { uniform(P::PositionRange.x, P::PositionRange.y), uniform(P::PositionRange.x, P::PositionRange.y),
+                       uniform(P::DimensionsRange.x, P::DimensionsRange.y), uniform(P::DimensionsRange.x, P::DimensionsRange.y) };
+        in.atlasSlot = u32(rng() % 0x10000);
+        in.number = i32(rng() % 0x10000);
+        in.tint = color();
+        in.borderColor = color();
+        in.glowColor = color();
+        in.glowSize = uniform(0.f, 10.f);
+        in.borderThickness = uniform(0.f, 512.f);
+        in.glowPulse = { uniform(0.f, 1.f), uniform(0.f, 5.f), uniform(-TwoPi, TwoPi) };
+        in.highlight = rng() % 2 == 0;
+
+        ExpectRoundTrip(in);
+        if(HasFailure())
+            break;
+    }
+}
+
+TEST(GridInstance, ClampsOutOfRangeValues) {
+    GridInstanceData in;
+    in.posDims = { -5.f, 7.f, -1.f, 3.f };
+    in.number = 100'000;
+    in.glowSize = 50.f;
+    in.borderThickness = -3.f;
+
+    const GridInstanceData out = Unpack(Pack(in));
+    EXPECT_EQ(out.posDims, vec4(P::PositionRange.x, P::PositionRange.y, P::DimensionsRange.x, P::DimensionsRange.y));
+    EXPECT_EQ(out.number, 0xFFFF);
+    EXPECT_EQ(out.glowSize, P::GlowSizeRange.y);
+    EXPECT_EQ(out.borderThickness, P::BorderThicknessRange.x);
+}
@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+
+#include <thread>
+
+#include "TripleBuffer.h"
+
+using namespace GW2Clarity;
+
+namespace
+{
+// Large enough that a torn read, the reader seeing a buffer the writer is filling, would show as mismatched values
+struct Payload
+{
+    std::array<u64, 64> values {};
+};
+} // namespace
+
+TEST(TripleBuffer, ReaderSeesLatestPublished) {
+    TripleBuffer<u64> buffer(0);
+    EXPECT_EQ(buffer.Acquire(), 0u);
+
+    buffer.back() = 1;
+    buffer.Publish();
+    buffer.back() = 2;
+    buffer.Publish();
+    EXPECT_EQ(buffer.Acquire(), 2u);
+    // Nothing new was published, the same buffer is returned
+    EXPECT_EQ(buffer.Acquire(), 2u);
+    EXPECT_EQ(buffer.front(), 2u);
+}
+
+TEST(TripleBuffer, WriterNeverReusesAcquiredBuffer) {
+    TripleBuffer<u64> buffer(0);
+    buffer.back() = 1;
+    buffer.Publish();
+    const u64& acquired = buffer.Acquire();
+
+    for(u64 i = 2; i < 10; i++) {
+        buffer.back() = i;
+        buffer.Publish();
+        EXPECT_EQ(acquired, 1u);
+    }
+    EXPECT_EQ(buffer.Acquire(), 9u);
+}
+
+TEST(TripleBuffer, ConcurrentProducerConsumer) {
+    constexpr u64 Publishes = 200'000;
+    TripleBuffer<Payload> buffer;
+
+    std::thread producer([&] {
+        for(u64 i = 1; i <= Publishes; i++) {
+            buffer.back().values.fill(i);
+            buffer.Publish();
+        }
+    });
+
+    u64 last = 0, torn = 0, backwards = 0;
+    while(last != Publishes) {
+        const Payload& p = buffer.Acquire();
+        const u64 v = p.values.front();
+        torn += std::ranges::count_if(p.values, [&](u64 x) { return x != v; });
+        backwards += v < last;
+        last = std::max(last, v);
+    }
+    producer.join();
+
+    EXPECT_EQ(torn, 0u);
+    EXPECT_EQ(backwards, 0u);
+    EXPECT_EQ(buffer.Acquire().values.back(), Publishes);
+}